@@ -0,0 +1,138 @@
+#include "Alert.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace {
+
+/// Appends a non-negative value with one decimal
+void appendDecimal(OutputBuffer &out, double value) {
+    out.appendTenths(static_cast<uint64_t>(std::max(value, 0.0) * 10 + 0.5));
+}
+
+/// Priorities of RFC 5424 used for each level
+int syslogPriority(AlertLevel level) {
+    switch (level) {
+    case AlertLevel::Critical:
+        return 2;
+    case AlertLevel::Warning:
+        return 4;
+    default:
+        return 5;
+    }
+}
+
+void appendPerformanceData(OutputBuffer &out, const char *name, double percent, const AlertRule &rule) {
+    out.append(name);
+    out.append('=');
+    appendDecimal(out, percent);
+    out.append("%;");
+    appendDecimal(out, rule.warning);
+    out.append(';');
+    appendDecimal(out, rule.critical);
+    out.append(";0;100");
+}
+
+}
+
+AlertLevel alertLevel(const AlertRule &rule, double percent) {
+    if (percent >= rule.critical)
+        return AlertLevel::Critical;
+    if (percent >= rule.warning)
+        return AlertLevel::Warning;
+    return AlertLevel::Ok;
+}
+
+const char *alertLevelName(AlertLevel level) {
+    switch (level) {
+    case AlertLevel::Critical:
+        return "critical";
+    case AlertLevel::Warning:
+        return "warning";
+    default:
+        return "ok";
+    }
+}
+
+AlertState::AlertState(const AlertRule &rule) : rule{rule} {
+}
+
+bool AlertState::update(double percent, double now) {
+    AlertLevel target = alertLevel(rule, percent);
+    if (target < current) {
+        // Going down needs the percentage to fall hysteresis points below the threshold
+        AlertRule lowered = rule;
+        lowered.warning -= rule.hysteresis;
+        lowered.critical -= rule.hysteresis;
+        target = std::min(current, alertLevel(lowered, percent));
+    }
+    if (target == current) {
+        pending = current;
+        return false;
+    }
+    if (target != pending) {
+        pending = target;
+        pendingSince = now;
+    }
+    if (now - pendingSince < rule.minDuration)
+        return false;
+    previous = current;
+    current = target;
+    return true;
+}
+
+void writeAlertEvent(OutputBuffer &out, AlertFormat format, const char *metric,
+                     const AlertState &state, const AlertRule &rule, double percent) {
+    if (format == AlertFormat::Syslog) {
+        out.append('<');
+        out.appendUint(syslogPriority(state.level()));
+        out.append(">superfree: ");
+        out.append(metric);
+        out.append(' ');
+        out.append(alertLevelName(state.level()));
+        out.append(" (was ");
+        out.append(alertLevelName(state.previousLevel()));
+        out.append("), ");
+        appendDecimal(out, percent);
+        out.append("% used, warning at ");
+        appendDecimal(out, rule.warning);
+        out.append("%, critical at ");
+        appendDecimal(out, rule.critical);
+        out.append("%\n");
+        return;
+    }
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    out.append("{\"timestamp\":");
+    out.appendUint(static_cast<uint64_t>(now.tv_sec));
+    out.append(",\"metric\":\"");
+    out.append(metric);
+    out.append("\",\"level\":\"");
+    out.append(alertLevelName(state.level()));
+    out.append("\",\"previous\":\"");
+    out.append(alertLevelName(state.previousLevel()));
+    out.append("\",\"used_percent\":");
+    appendDecimal(out, percent);
+    out.append(",\"warning\":");
+    appendDecimal(out, rule.warning);
+    out.append(",\"critical\":");
+    appendDecimal(out, rule.critical);
+    out.append("}\n");
+}
+
+AlertLevel writeCheck(OutputBuffer &out, const AlertRule &rule, double memoryPercent, double swapPercent) {
+    const AlertLevel level = std::max(alertLevel(rule, memoryPercent), alertLevel(rule, swapPercent));
+    const char *const STATUS[] = {"OK", "WARNING", "CRITICAL"};
+    out.append("SUPERFREE ");
+    out.append(STATUS[static_cast<int>(level)]);
+    out.append(" - memory ");
+    appendDecimal(out, memoryPercent);
+    out.append("% used, swap ");
+    appendDecimal(out, swapPercent);
+    out.append("% used | ");
+    appendPerformanceData(out, "memory", memoryPercent, rule);
+    out.append(' ');
+    appendPerformanceData(out, "swap", swapPercent, rule);
+    out.append('\n');
+    return level;
+}
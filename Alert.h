@@ -0,0 +1,103 @@
+#ifndef SUPERFREE_ALERT_H
+#define SUPERFREE_ALERT_H
+
+#include <cstdint>
+#include "OutputWriter.h"
+
+/// Severity of a usage percentage, the values are the Nagios exit codes
+enum class AlertLevel {
+    Ok = 0,
+    Warning = 1,
+    Critical = 2,
+};
+
+/// How events are written by --alert
+enum class AlertFormat {
+    /// One JSON object per line
+    Json,
+    /// "<priority>message" lines as read by systemd-journald or logger --prio-prefix
+    Syslog,
+};
+
+/// Thresholds of a metric, shared by --alert, --check and the colors of the bars
+struct AlertRule {
+    /// Percentage from which the level is Warning
+    double warning = 60;
+    /// Percentage from which the level is Critical
+    double critical = 90;
+    /// Points below a threshold the percentage must fall to leave its level
+    double hysteresis = 5;
+    /// Seconds a new level must hold before it is reported
+    double minDuration = 0;
+};
+
+
+/// Returns the level of a percentage without hysteresis
+/// \param rule The thresholds
+/// \param percent Usage percentage
+/// \return Critical, Warning or Ok
+AlertLevel alertLevel(const AlertRule &rule, double percent);
+
+
+/// Returns the lowercase name of a level, e.g. "warning"
+const char *alertLevelName(AlertLevel level);
+
+
+/// Level of one metric over time, with hysteresis and a minimum duration
+class AlertState {
+public:
+
+    /// Initialize the state at Ok
+    /// \param rule The thresholds of the metric
+    explicit AlertState(const AlertRule &rule);
+
+
+    /// Feeds a new sample
+    /// \param percent Usage percentage
+    /// \param now Time of the sample in seconds, from a monotonic clock
+    /// \return True if the reported level changed
+    bool update(double percent, double now);
+
+
+    /// Returns the reported level
+    AlertLevel level() const {
+        return current;
+    }
+
+
+    /// Returns the level reported before the last change
+    AlertLevel previousLevel() const {
+        return previous;
+    }
+
+private:
+
+    AlertRule rule;
+    AlertLevel current = AlertLevel::Ok;
+    AlertLevel previous = AlertLevel::Ok;
+    /// Level the samples point to while it has not held for rule.minDuration
+    AlertLevel pending = AlertLevel::Ok;
+    double pendingSince = 0;
+};
+
+
+/// Writes one level change of a metric
+/// \param out The buffer to write to
+/// \param format JSON or syslog-style line
+/// \param metric Name of the metric, e.g. "memory"
+/// \param state The state that just changed
+/// \param rule The thresholds of the metric
+/// \param percent Usage percentage of the sample that caused the change
+void writeAlertEvent(OutputBuffer &out, AlertFormat format, const char *metric,
+                     const AlertState &state, const AlertRule &rule, double percent);
+
+
+/// Writes the Nagios plugin status line of --check, with performance data
+/// \param out The buffer to write to
+/// \param rule The thresholds
+/// \param memoryPercent Used memory percentage
+/// \param swapPercent Used swap percentage
+/// \return The worst level of both metrics, to use as the exit code
+AlertLevel writeCheck(OutputBuffer &out, const AlertRule &rule, double memoryPercent, double swapPercent);
+
+#endif //SUPERFREE_ALERT_H
@@ -0,0 +1,296 @@
+#include "BatchAnalysis.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <initializer_list>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Parallel.h"
+
+namespace {
+
+/// Size of a tar header and of the blocks holding member data
+const size_t TAR_BLOCK = 512;
+
+/// A file to read, and the host its snapshots belong to
+struct Capture {
+    std::string path;
+    size_t host;
+    bool tar;
+};
+
+/// The used memory and swap of one snapshot, in tenths of a percent
+struct Sample {
+    uint16_t used;
+    uint16_t swapUsed;
+    uint64_t memTotal;
+    uint64_t swapTotal;
+    uint64_t available;
+};
+
+bool endsWith(const std::string &text, const char *suffix) {
+    const size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+/// Adds the meminfo files and tarballs below a directory, skipping symbolic links
+void walk(const std::string &dir, size_t host, std::vector<Capture> &captures) {
+    DIR *handle = opendir(dir.c_str());
+    if (handle == nullptr)
+        return;
+    while (dirent *entry = readdir(handle)) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+        const std::string path = dir + "/" + name;
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN) {
+            struct stat info;
+            if (lstat(path.c_str(), &info) < 0)
+                continue;
+            type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_LNK;
+        }
+        if (type == DT_DIR)
+            walk(path, host, captures);
+        else if (type == DT_REG && std::strcmp(name, "meminfo") == 0)
+            captures.push_back({path, host, false});
+        else if (type == DT_REG && endsWith(path, ".tar"))
+            captures.push_back({path, host, true});
+    }
+    closedir(handle);
+}
+
+/// Reads a whole file into buffer
+bool readFile(const std::string &path, std::string &buffer) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    buffer.clear();
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+        buffer.reserve(static_cast<size_t>(info.st_size));
+    char chunk[65536];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+        buffer.append(chunk, static_cast<size_t>(n));
+    close(fd);
+    return n == 0;
+}
+
+void addSamples(const char *text, size_t length, std::vector<Sample> &samples) {
+    forEachMemInfoSnapshot(text, length, [&](const MemInfoData &data) {
+        Sample sample;
+        const uint64_t used = memInfoUsed(data);
+        const uint64_t swapUsed = data.swapTotal > data.swapFree ? data.swapTotal - data.swapFree : 0;
+        sample.used = static_cast<uint16_t>(data.memTotal > 0 ? (used * 1000 + data.memTotal / 2) / data.memTotal : 0);
+        sample.swapUsed = static_cast<uint16_t>(
+            data.swapTotal > 0 ? (swapUsed * 1000 + data.swapTotal / 2) / data.swapTotal : 0);
+        sample.memTotal = data.memTotal;
+        sample.swapTotal = data.swapTotal;
+        sample.available = memInfoAvailable(data);
+        samples.push_back(sample);
+    });
+}
+
+/// Reads the members named meminfo of an uncompressed ustar or GNU tar archive
+void addTarSamples(const std::string &archive, std::vector<Sample> &samples) {
+    std::string longName;
+    for (size_t pos = 0; pos + TAR_BLOCK <= archive.size();) {
+        const char *header = archive.data() + pos;
+        if (header[0] == '\0')
+            break;
+        std::string name(header, strnlen(header, 100));
+        if (!longName.empty()) {
+            name.swap(longName);
+            longName.clear();
+        }
+        const uint64_t size = std::strtoull(std::string(header + 124, 12).c_str(), nullptr, 8);
+        const char type = header[156];
+        pos += TAR_BLOCK;
+        if (size > archive.size() - pos)
+            break;
+        // GNU stores names longer than 100 bytes in a member of its own before the file
+        if (type == 'L')
+            longName.assign(archive.data() + pos, strnlen(archive.data() + pos, static_cast<size_t>(size)));
+        const bool regular = type == '0' || type == '\0';
+        if (regular && (name == "meminfo" || endsWith(name, "/meminfo")))
+            addSamples(archive.data() + pos, static_cast<size_t>(size), samples);
+        pos += (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+    }
+}
+
+/// Nearest-rank percentile of sorted values
+uint32_t percentile(const std::vector<uint16_t> &sorted, unsigned int percent) {
+    const size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void appendJsonMember(OutputBuffer &out, const char *name, uint64_t value) {
+    out.append(",\"");
+    out.append(name);
+    out.append("\":");
+    out.appendUint(value);
+}
+
+void appendJsonTenths(OutputBuffer &out, const char *name, uint32_t tenths) {
+    out.append(",\"");
+    out.append(name);
+    out.append("\":");
+    out.appendTenths(tenths);
+}
+
+/// Appends a CSV field, quoted when it holds a separator or a quote
+void appendCsvField(OutputBuffer &out, const std::string &text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        out.append(text.data(), text.size());
+        return;
+    }
+    out.append('"');
+    for (char c : text) {
+        if (c == '"')
+            out.append('"');
+        out.append(c);
+    }
+    out.append('"');
+}
+
+}
+
+std::vector<HostSummary> analyzeCaptures(const std::vector<std::string> &paths, unsigned int threads,
+                                         size_t &files) {
+    std::vector<std::string> hosts;
+    std::vector<Capture> captures;
+    for (std::string path : paths) {
+        while (path.size() > 1 && path.back() == '/')
+            path.pop_back();
+        struct stat info;
+        if (stat(path.c_str(), &info) < 0)
+            continue;
+        if (!S_ISDIR(info.st_mode)) {
+            captures.push_back({path, hosts.size(), endsWith(path, ".tar")});
+            hosts.push_back(path);
+            continue;
+        }
+        if (access((path + "/meminfo").c_str(), F_OK) == 0 || access((path + "/proc/meminfo").c_str(), F_OK) == 0) {
+            const size_t host = hosts.size();
+            hosts.push_back(path);
+            walk(path, host, captures);
+            continue;
+        }
+        // Every entry of the directory is one host
+        DIR *handle = opendir(path.c_str());
+        if (handle == nullptr)
+            continue;
+        std::vector<std::string> names;
+        while (dirent *entry = readdir(handle)) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0)
+                names.push_back(entry->d_name);
+        }
+        closedir(handle);
+        std::sort(names.begin(), names.end());
+        for (const auto &name : names) {
+            const std::string child = path + "/" + name;
+            struct stat childInfo;
+            if (lstat(child.c_str(), &childInfo) < 0 || S_ISLNK(childInfo.st_mode))
+                continue;
+            const size_t host = hosts.size();
+            hosts.push_back(name);
+            if (S_ISDIR(childInfo.st_mode))
+                walk(child, host, captures);
+            else if (S_ISREG(childInfo.st_mode))
+                captures.push_back({child, host, endsWith(child, ".tar")});
+        }
+    }
+    files = captures.size();
+
+    // Read and parse in parallel, one buffer per worker
+    std::vector<std::vector<Sample>> perCapture(captures.size());
+    std::vector<std::string> buffers(std::max(1u, threads));
+    parallelFor(captures.size(), threads, [&](size_t index, unsigned int worker) {
+        std::string &buffer = buffers[worker];
+        if (!readFile(captures[index].path, buffer))
+            return;
+        if (captures[index].tar)
+            addTarSamples(buffer, perCapture[index]);
+        else
+            addSamples(buffer.data(), buffer.size(), perCapture[index]);
+    });
+
+    std::vector<std::vector<uint16_t>> used(hosts.size());
+    std::vector<HostSummary> summaries(hosts.size());
+    for (size_t i = 0; i < captures.size(); i++) {
+        HostSummary &summary = summaries[captures[i].host];
+        for (const Sample &sample : perCapture[i]) {
+            used[captures[i].host].push_back(sample.used);
+            summary.availableMin = summary.samples == 0 ? sample.available
+                                                        : std::min(summary.availableMin, sample.available);
+            summary.samples++;
+            summary.memTotal = std::max(summary.memTotal, sample.memTotal);
+            summary.swapTotal = std::max(summary.swapTotal, sample.swapTotal);
+            summary.swapUsedMax = std::max<uint32_t>(summary.swapUsedMax, sample.swapUsed);
+        }
+    }
+    std::vector<HostSummary> result;
+    for (size_t host = 0; host < hosts.size(); host++) {
+        if (used[host].empty())
+            continue;
+        HostSummary &summary = summaries[host];
+        summary.host = hosts[host];
+        std::sort(used[host].begin(), used[host].end());
+        summary.usedP50 = percentile(used[host], 50);
+        summary.usedP95 = percentile(used[host], 95);
+        summary.usedMax = used[host].back();
+        result.push_back(std::move(summary));
+    }
+    std::stable_sort(result.begin(), result.end(), [](const HostSummary &a, const HostSummary &b) {
+        return a.usedP95 > b.usedP95;
+    });
+    return result;
+}
+
+void writeHostCsvHeader(OutputBuffer &out) {
+    out.append("host,samples,mem_total,swap_total,available_min,used_percent_p50,used_percent_p95,"
+               "used_percent_max,swap_used_percent_max\n");
+}
+
+void writeHostCsv(OutputBuffer &out, const HostSummary &summary, const Units &units) {
+    const Units fixed = units.fixed();
+    appendCsvField(out, summary.host);
+    out.append(',');
+    out.appendUint(summary.samples);
+    for (uint64_t kib : {summary.memTotal, summary.swapTotal, summary.availableMin}) {
+        out.append(',');
+        out.appendUint(fixed.count(Quantity::fromKiB(kib)));
+    }
+    const uint32_t percents[] = {summary.usedP50, summary.usedP95, summary.usedMax, summary.swapUsedMax};
+    for (uint32_t percent : percents) {
+        out.append(',');
+        out.appendTenths(percent);
+    }
+    out.append('\n');
+}
+
+void writeHostJson(OutputBuffer &out, const HostSummary &summary, const Units &units) {
+    const Units fixed = units.fixed();
+    out.append("{\"host\":\"");
+    for (char c : summary.host) {
+        if (c == '"' || c == '\\')
+            out.append('\\');
+        out.append(c);
+    }
+    out.append('"');
+    appendJsonMember(out, "samples", summary.samples);
+    out.append(",\"unit\":\"");
+    out.append(fixed.name());
+    out.append('"');
+    appendJsonMember(out, "mem_total", fixed.count(Quantity::fromKiB(summary.memTotal)));
+    appendJsonMember(out, "swap_total", fixed.count(Quantity::fromKiB(summary.swapTotal)));
+    appendJsonMember(out, "available_min", fixed.count(Quantity::fromKiB(summary.availableMin)));
+    appendJsonTenths(out, "used_percent_p50", summary.usedP50);
+    appendJsonTenths(out, "used_percent_p95", summary.usedP95);
+    appendJsonTenths(out, "used_percent_max", summary.usedMax);
+    appendJsonTenths(out, "swap_used_percent_max", summary.swapUsedMax);
+    out.append("}\n");
+}
@@ -0,0 +1,99 @@
+#ifndef SUPERFREE_BATCHANALYSIS_H
+#define SUPERFREE_BATCHANALYSIS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "MemInfoParser.h"
+#include "OutputWriter.h"
+#include "Units.h"
+
+/// Memory use of one host over every meminfo snapshot captured from it. Percentages are
+/// fixed-point tenths of a percent.
+struct HostSummary {
+    /// First path component below the directory given, or the file or tarball itself
+    std::string host;
+    size_t samples = 0;
+    /// Largest MemTotal and SwapTotal seen, in kB
+    uint64_t memTotal = 0;
+    uint64_t swapTotal = 0;
+    /// Smallest MemAvailable seen, in kB
+    uint64_t availableMin = 0;
+    uint32_t usedP50 = 0;
+    uint32_t usedP95 = 0;
+    uint32_t usedMax = 0;
+    uint32_t swapUsedMax = 0;
+};
+
+
+/// Splits text holding one or more concatenated /proc/meminfo dumps (e.g. a loop of
+/// "cat /proc/meminfo >> log") into snapshots, a new one starting at every MemTotal line
+/// \param text Content of the file
+/// \param length Number of bytes of text
+/// \param callback Called as callback(data) for every snapshot reporting MemTotal
+/// \return Number of snapshots found
+template <typename F>
+size_t forEachMemInfoSnapshot(const char *text, size_t length, F callback) {
+    static const char KEY[] = "MemTotal:";
+    const size_t keyLength = sizeof(KEY) - 1;
+    size_t count = 0;
+    size_t start = std::string::npos;
+    for (size_t pos = 0; pos < length;) {
+        if (length - pos >= keyLength && std::memcmp(text + pos, KEY, keyLength) == 0) {
+            if (start != std::string::npos) {
+                MemInfoData data;
+                parseMemInfo(text + start, pos - start, data);
+                callback(data);
+                count++;
+            }
+            start = pos;
+        }
+        const void *newline = std::memchr(text + pos, '\n', length - pos);
+        if (newline == nullptr)
+            break;
+        pos = static_cast<const char *>(newline) - text + 1;
+    }
+    if (start != std::string::npos) {
+        MemInfoData data;
+        parseMemInfo(text + start, length - start, data);
+        callback(data);
+        count++;
+    }
+    return count;
+}
+
+
+/// Summarizes captured meminfo files per host, reading them in parallel. Every entry of a
+/// directory is one host, unless the directory holds meminfo or proc/meminfo itself (a
+/// single sosreport). Directories are walked for files named meminfo (NUMA node files, which have no MemTotal key, are
+/// ignored), symbolic links are not followed, and uncompressed .tar archives are read
+/// member by member. Every file may hold several concatenated dumps.
+/// \param paths Files, directories and .tar archives given on the command line
+/// \param threads Number of worker threads
+/// \param files Receives the number of files read
+/// \return One summary per host with at least one snapshot, the highest p95 first
+std::vector<HostSummary> analyzeCaptures(const std::vector<std::string> &paths, unsigned int threads,
+                                         size_t &files);
+
+
+/// Writes the CSV header line matching writeHostCsv()
+/// \param out The buffer to write to
+void writeHostCsvHeader(OutputBuffer &out);
+
+
+/// Writes one host as a CSV line
+/// \param out The buffer to write to
+/// \param summary The host
+/// \param units Unit of the sizes, -h is written in KiB (or kB)
+void writeHostCsv(OutputBuffer &out, const HostSummary &summary, const Units &units = Units{});
+
+
+/// Writes one host as a JSON object on one line
+/// \param out The buffer to write to
+/// \param summary The host
+/// \param units Unit of the sizes, -h is written in KiB (or kB)
+void writeHostJson(OutputBuffer &out, const HostSummary &summary, const Units &units = Units{});
+
+#endif //SUPERFREE_BATCHANALYSIS_H
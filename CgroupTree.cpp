@@ -0,0 +1,387 @@
+#include "CgroupTree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+#include "MemInfoParser.h"
+#include "Parallel.h"
+
+namespace {
+
+/// Size of the stack buffer used to read memory.stat
+const size_t STAT_BUFFER_SIZE = 8192;
+
+/// Reads a small file relative to dirFd into buffer, returns the number of bytes read
+ssize_t readAt(int dirFd, const char *name, char *buffer, size_t size) {
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    ssize_t n = read(fd, buffer, size);
+    close(fd);
+    return n;
+}
+
+/// Parses the contents of a file holding one number or "max"
+uint64_t parseLimit(const char *buffer, ssize_t length) {
+    if (buffer[0] == 'm')
+        return CGROUP_UNLIMITED;
+    uint64_t value = 0;
+    for (ssize_t i = 0; i < length && buffer[i] >= '0' && buffer[i] <= '9'; ++i)
+        value = value * 10 + (buffer[i] - '0');
+    return value;
+}
+
+/// Reads a file holding one number or "max", returns false when the file is missing
+bool readLimit(int dirFd, const char *name, uint64_t &value) {
+    char buffer[32];
+    ssize_t n = readAt(dirFd, name, buffer, sizeof(buffer));
+    if (n <= 0)
+        return false;
+    value = parseLimit(buffer, n);
+    return true;
+}
+
+/// Rereads a file holding one number from an open descriptor
+bool preadLimit(int fd, uint64_t &value) {
+    char buffer[32];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    value = parseLimit(buffer, n);
+    return true;
+}
+
+/// Returns the cgroup v2 path of the process from /proc/self/cgroup, or an empty
+/// string when the process is not in a cgroup v2 hierarchy
+std::string selfCgroupPath() {
+    char buffer[4096];
+    ssize_t n = readAt(AT_FDCWD, "/proc/self/cgroup", buffer, sizeof(buffer));
+    if (n <= 0)
+        return "";
+    const std::string content(buffer, static_cast<size_t>(n));
+    size_t line = content.compare(0, 3, "0::") == 0 ? 0 : content.find("\n0::");
+    if (line == std::string::npos)
+        return "";
+    size_t start = content.find("::", line) + 2;
+    size_t end = content.find('\n', start);
+    return content.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+/// Returns the usual cgroup v2 mount point without reading mountinfo when possible
+std::string cgroup2Root() {
+    struct statfs fs;
+    if (statfs("/sys/fs/cgroup", &fs) == 0 && fs.f_type == CGROUP2_SUPER_MAGIC)
+        return "/sys/fs/cgroup";
+    return findCgroup2Root();
+}
+
+#define KEY_IS(literal) (length == sizeof(literal) - 1 && std::memcmp(key, literal, length) == 0)
+
+void readStat(int dirFd, CgroupMemory &memory) {
+    char buffer[STAT_BUFFER_SIZE];
+    ssize_t n = readAt(dirFd, "memory.stat", buffer, sizeof(buffer));
+    if (n <= 0)
+        return;
+    scanSpaceKeyValues(buffer, static_cast<size_t>(n), [&](const char *key, size_t length, uint64_t value) {
+        if (KEY_IS("anon"))
+            memory.anon = value;
+        else if (KEY_IS("file"))
+            memory.file = value;
+        else if (KEY_IS("shmem"))
+            memory.shmem = value;
+        else if (KEY_IS("slab"))
+            memory.slab = value;
+    });
+}
+
+}
+
+void readCgroupMemory(int dirFd, CgroupMemory &memory) {
+    memory.hasMemory = readLimit(dirFd, "memory.current", memory.current);
+    if (!memory.hasMemory)
+        return;
+    if (!readLimit(dirFd, "memory.max", memory.max))
+        memory.max = CGROUP_UNLIMITED;
+    if (!readLimit(dirFd, "memory.swap.current", memory.swapCurrent))
+        memory.swapCurrent = 0;
+    if (!readLimit(dirFd, "memory.swap.max", memory.swapMax))
+        memory.swapMax = CGROUP_UNLIMITED;
+    readStat(dirFd, memory);
+}
+
+std::string findCgroup2Root() {
+    int fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return "";
+    std::string content;
+    char buffer[4096];
+    for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;)
+        content.append(buffer, static_cast<size_t>(n));
+    close(fd);
+
+    for (size_t start = 0, end; start < content.size(); start = end + 1) {
+        end = content.find('\n', start);
+        if (end == std::string::npos)
+            end = content.size();
+        size_t separator = content.find(" - ", start);
+        if (separator == std::string::npos || separator > end
+                || content.compare(separator + 3, 8, "cgroup2 ") != 0)
+            continue;
+        // Fields: id parent major:minor root mountpoint ...
+        size_t field = start;
+        for (int i = 0; i < 4 && field != std::string::npos; ++i)
+            field = content.find(' ', field) + 1;
+        size_t fieldEnd = content.find(' ', field);
+        return content.substr(field, fieldEnd - field);
+    }
+    return "";
+}
+
+CgroupLimits::~CgroupLimits() {
+    close();
+}
+
+void CgroupLimits::close() {
+    for (int *fd : {&currentFd, &statFd, &swapCurrentFd}) {
+        if (*fd >= 0)
+            ::close(*fd);
+        *fd = -1;
+    }
+    memoryMax = CGROUP_UNLIMITED;
+    swapMax = CGROUP_UNLIMITED;
+}
+
+bool CgroupLimits::open() {
+    std::string path = selfCgroupPath();
+    if (path.empty())
+        return false;
+    std::string root = cgroup2Root();
+    if (root.empty())
+        return false;
+    return open(root, path);
+}
+
+bool CgroupLimits::open(const std::string &root, const std::string &path) {
+    close();
+    cgroupPath = path.empty() ? "/" : path;
+
+    // The effective limit is the lowest one between the cgroup and the root, e.g. a container
+    // whose processes run in init.scope below its limited root. Usage is read where it is
+    // set, as the limit applies to the whole subtree.
+    std::string memoryDir = root + (cgroupPath == "/" ? "" : cgroupPath) + "/";
+    std::string swapDir = memoryDir;
+    for (std::string ancestor = cgroupPath;;) {
+        const std::string dir = root + (ancestor == "/" ? "" : ancestor) + "/";
+        uint64_t value;
+        if (readLimit(AT_FDCWD, (dir + "memory.max").c_str(), value) && value < memoryMax) {
+            memoryMax = value;
+            memoryDir = dir;
+        }
+        if (readLimit(AT_FDCWD, (dir + "memory.swap.max").c_str(), value) && value < swapMax) {
+            swapMax = value;
+            swapDir = dir;
+        }
+        if (ancestor == "/")
+            break;
+        size_t slash = ancestor.rfind('/');
+        ancestor = slash == 0 || slash == std::string::npos ? "/" : ancestor.substr(0, slash);
+    }
+    if (memoryMax == CGROUP_UNLIMITED && swapMax == CGROUP_UNLIMITED)
+        return false;
+
+    currentFd = ::open((memoryDir + "memory.current").c_str(), O_RDONLY | O_CLOEXEC);
+    statFd = ::open((memoryDir + "memory.stat").c_str(), O_RDONLY | O_CLOEXEC);
+    if (swapMax != 0 && swapMax != CGROUP_UNLIMITED)
+        swapCurrentFd = ::open((swapDir + "memory.swap.current").c_str(), O_RDONLY | O_CLOEXEC);
+    if (currentFd < 0 || statFd < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool CgroupLimits::apply(MemInfoData &data) const {
+    uint64_t current;
+    if (currentFd < 0 || !preadLimit(currentFd, current))
+        return false;
+    char buffer[STAT_BUFFER_SIZE];
+    ssize_t n = pread(statFd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    uint64_t file = 0, inactiveFile = 0, slabReclaimable = 0, shmem = 0;
+    scanSpaceKeyValues(buffer, static_cast<size_t>(n), [&](const char *key, size_t length, uint64_t value) {
+        if (KEY_IS("file"))
+            file = value;
+        else if (KEY_IS("inactive_file"))
+            inactiveFile = value;
+        else if (KEY_IS("slab_reclaimable"))
+            slabReclaimable = value;
+        else if (KEY_IS("shmem"))
+            shmem = value;
+    });
+
+    if (memoryMax != CGROUP_UNLIMITED) {
+        const uint64_t hostAvailable = memInfoAvailable(data);
+        const uint64_t total = std::min(memoryMax / 1024, data.memTotal);
+        const uint64_t used = std::min(current / 1024, total);
+        const uint64_t reclaimable = std::min((inactiveFile + slabReclaimable) / 1024, used);
+        data.memTotal = total;
+        data.memFree = std::min(total - used, data.memFree);
+        data.memAvailable = std::min(total - used + reclaimable, hostAvailable);
+        data.present.set(static_cast<size_t>(MemInfoField::memAvailable));
+        data.buffers = 0;
+        data.cached = file / 1024;
+        data.sReclaimable = slabReclaimable / 1024;
+        data.shmem = shmem / 1024;
+    }
+
+    if (swapMax == 0) {
+        data.swapTotal = 0;
+        data.swapFree = 0;
+    } else if (swapMax != CGROUP_UNLIMITED) {
+        uint64_t swapCurrent = 0;
+        if (swapCurrentFd >= 0)
+            preadLimit(swapCurrentFd, swapCurrent);
+        const uint64_t total = std::min(swapMax / 1024, data.swapTotal);
+        data.swapFree = total - std::min(swapCurrent / 1024, total);
+        data.swapTotal = total;
+    }
+    return true;
+}
+
+CgroupScanner::CgroupScanner(const std::string &root) : root{root} {
+}
+
+CgroupScanner::~CgroupScanner() {
+    for (auto &entry : nodes)
+        closeNode(*entry.second);
+}
+
+void CgroupScanner::closeNode(Node &node) {
+    if (node.dir != nullptr)
+        closedir(node.dir);
+    if (node.fd >= 0)
+        close(node.fd);
+    node.dir = nullptr;
+    node.fd = -1;
+}
+
+bool CgroupScanner::openNode(Node &node) {
+    if (node.memory.path.empty())
+        node.fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    else
+        node.fd = openat(node.parentFd, node.memory.name.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (node.fd < 0)
+        return false;
+    int listFd = dup(node.fd);
+    node.dir = listFd >= 0 ? fdopendir(listFd) : nullptr;
+    if (node.dir == nullptr && listFd >= 0)
+        close(listFd);
+    return true;
+}
+
+bool CgroupScanner::isStale(const Node &node) {
+    if (node.memory.path.empty())
+        return false;
+    struct stat opened;
+    struct stat current;
+    return fstat(node.fd, &opened) < 0 || fstatat(node.parentFd, node.memory.name.c_str(), &current, 0) < 0
+           || opened.st_ino != current.st_ino || opened.st_dev != current.st_dev;
+}
+
+void CgroupScanner::readNode(Node &node) {
+    if (node.fd < 0 && !openNode(node))
+        return;
+    readCgroupMemory(node.fd, node.memory);
+    // A cgroup removed and created again under the same name, e.g. by a service restart,
+    // leaves the cached descriptor on the removed directory, where every read fails
+    if (!node.memory.hasMemory && isStale(node)) {
+        closeNode(node);
+        if (!openNode(node))
+            return;
+        readCgroupMemory(node.fd, node.memory);
+    }
+
+    node.childNames.clear();
+    if (node.dir == nullptr)
+        return;
+    rewinddir(node.dir);
+    while (dirent *entry = readdir(node.dir)) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.')
+            continue;
+        node.childNames.emplace_back(entry->d_name);
+    }
+}
+
+std::vector<CgroupMemory> CgroupScanner::scan(unsigned int threads) {
+    for (auto &entry : nodes)
+        entry.second->seen = false;
+
+    auto rootEntry = nodes.find("");
+    if (rootEntry == nodes.end())
+        rootEntry = nodes.emplace("", std::unique_ptr<Node>(new Node)).first;
+    std::vector<Node *> level{rootEntry->second.get()};
+
+    while (!level.empty()) {
+        parallelFor(level.size(), threads, [&](size_t index, unsigned int) {
+            readNode(*level[index]);
+        });
+        std::vector<Node *> next;
+        for (Node *parent : level) {
+            parent->seen = true;
+            if (parent->fd < 0)
+                continue;
+            for (const auto &name : parent->childNames) {
+                std::string path = parent->memory.path.empty() ? name : parent->memory.path + "/" + name;
+                auto &child = nodes[path];
+                if (!child) {
+                    child.reset(new Node);
+                    child->memory.path = path;
+                    child->memory.name = name;
+                    child->memory.depth = parent->memory.depth + 1;
+                }
+                // The parent may have been opened again since the child was created
+                child->parentFd = parent->fd;
+                next.push_back(child.get());
+            }
+        }
+        level.swap(next);
+    }
+
+    for (auto entry = nodes.begin(); entry != nodes.end();) {
+        if (!entry->second->seen || entry->second->fd < 0) {
+            closeNode(*entry->second);
+            entry = nodes.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+
+    std::vector<CgroupMemory> result;
+    result.reserve(nodes.size());
+    auto rootNode = nodes.find("");
+    if (rootNode != nodes.end())
+        collect(*rootNode->second, result);
+    return result;
+}
+
+void CgroupScanner::collect(const Node &node, std::vector<CgroupMemory> &result) const {
+    result.push_back(node.memory);
+    std::vector<const Node *> children;
+    for (const auto &name : node.childNames) {
+        auto child = nodes.find(node.memory.path.empty() ? name : node.memory.path + "/" + name);
+        if (child != nodes.end())
+            children.push_back(child->second.get());
+    }
+    std::sort(children.begin(), children.end(), [](const Node *a, const Node *b) {
+        return a->memory.current > b->memory.current;
+    });
+    for (const Node *child : children)
+        collect(*child, result);
+}
+
+#undef KEY_IS
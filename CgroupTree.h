@@ -0,0 +1,158 @@
+#ifndef SUPERFREE_CGROUPTREE_H
+#define SUPERFREE_CGROUPTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <dirent.h>
+#include "MemInfoParser.h"
+
+/// Value of memory.max and memory.swap.max when they are "max"
+const uint64_t CGROUP_UNLIMITED = UINT64_MAX;
+
+/// Memory of one cgroup v2, in bytes
+struct CgroupMemory {
+    /// Path relative to the cgroup root, empty for the root itself
+    std::string path;
+    /// Last component of path
+    std::string name;
+    /// Number of ancestors
+    unsigned int depth = 0;
+    /// False when the memory controller is not enabled for the cgroup (e.g. the root)
+    bool hasMemory = false;
+    uint64_t current = 0;
+    uint64_t max = CGROUP_UNLIMITED;
+    uint64_t anon = 0;
+    uint64_t file = 0;
+    uint64_t shmem = 0;
+    uint64_t slab = 0;
+    uint64_t swapCurrent = 0;
+    uint64_t swapMax = CGROUP_UNLIMITED;
+};
+
+
+/// Reads the memory files of one cgroup directory
+/// \param dirFd Descriptor of the cgroup directory
+/// \param memory Receives the values, hasMemory is false when memory.current is missing
+void readCgroupMemory(int dirFd, CgroupMemory &memory);
+
+
+/// Returns the mount point of the cgroup v2 hierarchy from /proc/self/mountinfo,
+/// or an empty string when cgroup2 is not mounted
+std::string findCgroup2Root();
+
+
+/// Memory limits of the cgroup v2 the process runs in, used to show the values of a
+/// container instead of the host ones. The limits are read once by open(), apply() only
+/// rereads memory.current and memory.stat, plus memory.swap.current when swap is limited.
+class CgroupLimits {
+public:
+
+    CgroupLimits() = default;
+
+    ~CgroupLimits();
+
+    CgroupLimits(const CgroupLimits &) = delete;
+    CgroupLimits &operator=(const CgroupLimits &) = delete;
+
+
+    /// Finds the cgroup of the process from /proc/self/cgroup and reads its effective limits
+    /// \return True if memory or swap is limited, false to keep the host values
+    bool open();
+
+
+    /// Reads the effective limits of a cgroup, the lowest ones between it and the root, once.
+    /// The usage is then read from the cgroup setting each limit, which is a parent when the
+    /// limit is on a container root or a slice.
+    /// \param root Mount point of the cgroup v2 hierarchy
+    /// \param path Path of the cgroup relative to root, starting with '/'
+    /// \return True if memory or swap is limited, false to keep the host values
+    bool open(const std::string &root, const std::string &path);
+
+
+    /// Replaces the host totals of data with the ones of the cgroup, capped by the host.
+    /// Available memory is the room left below memory.max plus inactive file pages and
+    /// reclaimable slab; unlimited swap keeps the host values.
+    /// \param data Values read from /proc/meminfo, in kB
+    /// \return False if the cgroup files could not be read, data is then unchanged
+    bool apply(MemInfoData &data) const;
+
+
+    /// Returns the path of the cgroup given to open()
+    const std::string &path() const {
+        return cgroupPath;
+    }
+
+private:
+
+    std::string cgroupPath;
+    uint64_t memoryMax = CGROUP_UNLIMITED;
+    uint64_t swapMax = CGROUP_UNLIMITED;
+    int currentFd = -1;
+    int statFd = -1;
+    int swapCurrentFd = -1;
+
+    /// Closes the descriptors and forgets the limits
+    void close();
+};
+
+
+/// Walks a cgroup v2 hierarchy and reads the memory of every cgroup. The directory
+/// descriptors stay open between scans, so refreshing thousands of cgroups only costs
+/// the reads of their memory files and one readdir per directory.
+class CgroupScanner {
+public:
+
+    /// Initialize a scanner for a hierarchy
+    /// \param root Mount point of the cgroup v2 hierarchy
+    explicit CgroupScanner(const std::string &root);
+
+    ~CgroupScanner();
+
+    CgroupScanner(const CgroupScanner &) = delete;
+    CgroupScanner &operator=(const CgroupScanner &) = delete;
+
+
+    /// Walks the hierarchy one level at a time, reading the cgroups of a level in parallel
+    /// \param threads Number of worker threads
+    /// \return Every cgroup in tree order, siblings sorted by descending memory.current
+    std::vector<CgroupMemory> scan(unsigned int threads);
+
+private:
+
+    /// An open cgroup directory
+    struct Node {
+        int fd = -1;
+        DIR *dir = nullptr;
+        int parentFd = -1;
+        bool seen = false;
+        CgroupMemory memory;
+        std::vector<std::string> childNames;
+    };
+
+    /// Mount point of the hierarchy
+    std::string root;
+
+    /// Every known cgroup by path
+    std::unordered_map<std::string, std::unique_ptr<Node>> nodes;
+
+    /// Opens the directory of a node and a stream to list it
+    bool openNode(Node &node);
+
+    /// Returns true if the directory of a node is no longer the one at its path
+    static bool isStale(const Node &node);
+
+    /// Opens the directory if needed, reads the memory files and lists the children
+    void readNode(Node &node);
+
+    /// Appends node and its descendants to result in tree order
+    void collect(const Node &node, std::vector<CgroupMemory> &result) const;
+
+    /// Closes the descriptors of a node
+    static void closeNode(Node &node);
+};
+
+#endif //SUPERFREE_CGROUPTREE_H
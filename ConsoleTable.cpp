@@ -1,21 +1,36 @@
 #include "ConsoleTable.h"
+#include "DisplayWidth.h"
 
 
 ConsoleTable::ConsoleTable(const std::initializer_list<std::string> headers) : headers{headers} {
     for (const auto &column : headers) {
-        widths.push_back(column.length());
+        headerWidths.push_back(cellWidth(column));
+        widths.push_back(headerWidths.back());
+    }
+}
+
+ConsoleTable::ConsoleTable(const Headers &headers) : headers{headers} {
+    for (const auto &column : headers) {
+        headerWidths.push_back(cellWidth(column));
+        widths.push_back(headerWidths.back());
     }
 }
 
 void ConsoleTable::setPadding(unsigned int n) {
     padding = n;
+    fitTittle();
+    layoutChanged = true;
 }
 
 void ConsoleTable::setTittle(std::string n) {
     tittle = n;
+    tittleWidth = cellWidth(tittle);
+    fitTittle();
+    layoutChanged = true;
 }
 
 void ConsoleTable::setStyle(unsigned int n) {
+    layoutChanged = true;
     switch (n) {
     case 0 :
         style = BasicStyle;
@@ -39,24 +54,127 @@ void ConsoleTable::setStyle(unsigned int n) {
 }
 
 bool ConsoleTable::addRow(std::initializer_list<std::string> row) {
+    return addRow(std::vector<std::string>{row});
+}
+
+bool ConsoleTable::addRow(const std::vector<std::string> &row) {
     if (row.size() > widths.size()) {
         throw std::invalid_argument{"Appended row size must be same as header size"};
     }
 
-    auto r = std::vector<std::string>{row};
-    rows.push_back(r);
+    if (streamOut != nullptr && streamSampleRows == 0) {
+        Widths cellWidths(row.size());
+        for (unsigned int i = 0; i < row.size(); ++i)
+            cellWidths[i] = cellWidth(row[i]);
+        writeStreamRow(row, cellWidths);
+        return true;
+    }
+
+    rows.emplace_back(row);
+    const auto &r = rows.back();
+    Widths cellWidths(r.size());
     for (unsigned int i = 0; i < r.size(); ++i) {
-        widths[i] = std::max(r[i].size() - searchColor(r[i]), widths[i]);
+        cellWidths[i] = cellWidth(r[i]);
+        widths[i] = std::max(cellWidths[i], widths[i]);
     }
+    rowWidths.push_back(std::move(cellWidths));
+    fitTittle();
+    layoutChanged = true;
+
+    if (streamOut != nullptr && --streamSampleRows == 0)
+        startStreamOutput();
     return true;
 }
 
 
+void ConsoleTable::beginStream(std::ostream &out, const Widths &columnWidths) {
+    if (columnWidths.size() != widths.size())
+        throw std::invalid_argument{"Stream widths size must be same as header size"};
+
+    // A header is never truncated, its column is widened instead
+    for (size_t i = 0; i < widths.size(); ++i)
+        widths[i] = std::max(columnWidths[i], headerWidths[i]);
+    fitTittle();
+    streamOut = &out;
+    streamSampleRows = 0;
+    startStreamOutput();
+}
+
+
+void ConsoleTable::beginStream(std::ostream &out, size_t sampleRows) {
+    streamOut = &out;
+    streamSampleRows = sampleRows > rows.size() ? sampleRows - rows.size() : 0;
+    if (streamSampleRows == 0)
+        startStreamOutput();
+}
+
+
+void ConsoleTable::endStream() {
+    if (streamOut == nullptr)
+        return;
+    if (streamSampleRows > 0)
+        startStreamOutput();
+    streamLine.clear();
+    appendLine(streamLine, style.bottom);
+    streamOut->write(streamLine.data(), streamLine.size());
+    streamOut->flush();
+    streamOut = nullptr;
+    streamLine = std::string();
+}
+
+
+void ConsoleTable::startStreamOutput() {
+    streamSampleRows = 0;
+    streamLine.clear();
+    appendLine(streamLine, style.topTittle);
+    appendTittle(streamLine);
+    appendLine(streamLine, style.middleTittle);
+    appendRow(streamLine, headers, headerWidths);
+    appendLine(streamLine, style.middle);
+    streamOut->write(streamLine.data(), streamLine.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        writeStreamRow(rows[i], rowWidths[i]);
+    rows = Rows();
+    rowWidths = std::vector<Widths>();
+    streamOut->flush();
+}
+
+
+void ConsoleTable::writeStreamRow(const std::vector<std::string> &row, const Widths &cellWidths) {
+    streamLine.clear();
+    streamLine += style.vertical;
+    for (unsigned int j = 0; j < row.size(); ++j) {
+        if (cellWidths[j] > columnWidth(j)) {
+            streamLine.append(padding, ' ');
+            appendTruncated(streamLine, row[j], columnWidth(j));
+            streamLine.append(padding, ' ');
+        } else {
+            appendCell(streamLine, row[j], cellWidths[j], j);
+        }
+        streamLine += style.vertical;
+    }
+    streamLine += '\n';
+    streamOut->write(streamLine.data(), streamLine.size());
+}
+
+
+void ConsoleTable::appendTruncated(std::string &out, const std::string &text, size_t width) const {
+    if (width == 0)
+        return;
+    out.append(text, 0, displayPrefixLength(text.data(), text.size(), width - 1));
+    out += ELLIPSIS_CHARACTER;
+    if (text.find('\e') != std::string::npos)
+        out += COLOR_RESET;
+}
+
+
 bool ConsoleTable::removeRow(unsigned int index) {
-    if (index > rows.size())
+    if (index >= rows.size())
         return false;
 
     rows.erase(rows.begin() + index);
+    rowWidths.erase(rowWidths.begin() + index);
+    layoutChanged = true;
     return true;
 }
 
@@ -72,161 +190,206 @@ ConsoleTable &ConsoleTable::operator+=(std::initializer_list<std::string> row) {
 
 
 ConsoleTable &ConsoleTable::operator-=(const uint32_t rowIndex) {
-    if (rows.size() < rowIndex)
+    if (rowIndex >= rows.size())
         throw std::out_of_range{"Row index out of range."};
 
     removeRow(rowIndex);
     return *this;
 }
 
-std::string ConsoleTable::getLine(RowType rowType) const {
-    std::stringstream line;
-    line << rowType.left;
+size_t ConsoleTable::lineSize(const RowType &rowType) const {
+    size_t total = rowType.left.size() + 1;
     for (unsigned int i = 0; i < widths.size(); ++i) {
-        for (unsigned int j = 0; j < (widths[i] + padding + padding); ++j) {
-            line << style.horizontal;
-        }
-        line << (i == widths.size() - 1 ? rowType.right : rowType.intersect);
+        total += (columnWidth(i) + padding + padding) * style.horizontal.size();
+        total += (i == widths.size() - 1 ? rowType.right : rowType.intersect).size();
     }
-    return line.str() + "\n";
+    return total;
 }
 
-
-std::string ConsoleTable::getHeaders(const Headers &headers) const {
-    std::stringstream line;
-    line << style.vertical;
-    for (unsigned int i = 0; i < headers.size(); ++i) {
-        std::string text = headers[i];
-        line << SPACE_CHARACTER * padding + text + SPACE_CHARACTER * (widths[i] - text.length() + searchColor(text)) + SPACE_CHARACTER * padding;
-        line << style.vertical;
+void ConsoleTable::appendLine(std::string &out, const RowType &rowType) const {
+    out += rowType.left;
+    for (unsigned int i = 0; i < widths.size(); ++i) {
+        for (size_t j = 0; j < columnWidth(i) + padding + padding; ++j)
+            out += style.horizontal;
+        out += (i == widths.size() - 1 ? rowType.right : rowType.intersect);
     }
-    line << "\n";
-    return line.str();
+    out += '\n';
 }
 
-size_t ConsoleTable::calculateSizeRow(void) const{
-    size_t total = 1;
-    for (unsigned int i = 0; i < headers.size(); ++i)
-        total = total + 5 + widths[i];
-    return total;
+size_t ConsoleTable::innerWidth() const {
+    size_t inner = widths.size() - 1 + tittleExtra;
+    for (auto width : widths)
+        inner += width + padding + padding;
+    return inner;
+}
+
+void ConsoleTable::fitTittle() {
+    const size_t previous = tittleExtra;
+    tittleExtra = 0;
+    const size_t needed = tittleWidth + padding + padding;
+    const size_t inner = innerWidth();
+    tittleExtra = needed > inner ? needed - inner : 0;
+    if (tittleExtra != previous)
+        layoutChanged = true;
 }
 
-size_t ConsoleTable::simulateSizeRow(std::string text, int diference) const{
-    size_t total = 1;
-    total = total + 5 + text.length() + (widths[0] - calculateDiference(diference, widths[0], text));
-    for (unsigned int i = 1; i < headers.size(); ++i)
-        total = total + 5 + (widths[i] - calculateDiference(diference, widths[i], text));
+size_t ConsoleTable::tittleFill() const {
+    const size_t used = tittleWidth + padding;
+    const size_t inner = innerWidth();
+    return inner > used + padding ? inner - used : padding;
+}
+
+size_t ConsoleTable::tittleSize() const {
+    return style.vertical.size() * 2 + padding + tittle.size() + tittleFill() + 1;
+}
+
+void ConsoleTable::appendTittle(std::string &out) const {
+    out += style.vertical;
+    out.append(padding, ' ');
+    out += tittle;
+    out.append(tittleFill(), ' ');
+    out += style.vertical;
+    out += '\n';
+}
+
+size_t ConsoleTable::rowSize(const std::vector<std::string> &row, const Widths &cellWidths) const {
+    size_t total = style.vertical.size() + 1;
+    for (unsigned int j = 0; j < row.size(); ++j)
+        total += padding + row[j].size() + (columnWidth(j) - cellWidths[j]) + padding + style.vertical.size();
     return total;
 }
 
-size_t ConsoleTable::calculateDiference(int &diference, size_t width, const std::string &text) const{
-    size_t operatorDiference = 0;
-    if (diference > 0){
-        diference = 0;
-        operatorDiference = text.length();
-    } else if (diference < 0){
-        if (abs(diference) < width){
-            operatorDiference = width - abs(diference);
-            diference = 0;
-        } else{
-            diference = diference + width;
-            operatorDiference = width;
-        }
-    }
-    return operatorDiference;
-}
-
-std::string ConsoleTable::getTittle(const std::string &tittle) const {
-    std::stringstream line;
-    line << style.vertical;
-    std::string text = tittle;
-    int diference = 0;
-    diference = widths[0] - text.length() + searchColor(text);
-    size_t normalRow = calculateSizeRow();
-    size_t actualRow = simulateSizeRow(text, diference);
-    int sizeRowDiference = abs(normalRow - actualRow);
-    for (unsigned int i = 0; i < headers.size(); ++i){
-        size_t operatorDiference = calculateDiference(diference, widths[i], text);
-        if(i > 0)
-            line << SPACE_CHARACTER;
-        line << SPACE_CHARACTER * padding;
-        if(i > 0){
-            if (i == headers.size() - 1)
-                line << SPACE_CHARACTER * (widths[i] - operatorDiference - sizeRowDiference);
-            else
-                line << SPACE_CHARACTER * (widths[i] - operatorDiference);
-        } else {
-            line << text +
-                SPACE_CHARACTER * (widths[i] - operatorDiference + searchColor(text));
-        }
-        line << SPACE_CHARACTER * padding;
-    }
-    line << style.vertical;
-    line << "\n";
-    return line.str();
-}
-
-std::string ConsoleTable::getRows(const Rows &rows) const {
-    std::stringstream line;
-    for (const auto &row : rows) {
-        line << style.vertical;
-        for (unsigned int j = 0; j < row.size(); ++j) {
-            std::string text = row[j];
-            line << SPACE_CHARACTER * padding + text + SPACE_CHARACTER * (widths[j] - text.length() + searchColor(text)) + SPACE_CHARACTER * padding;
-            line << style.vertical;
-        }
-        line << "\n";
+void ConsoleTable::appendRow(std::string &out, const std::vector<std::string> &row, const Widths &cellWidths) const {
+    out += style.vertical;
+    for (unsigned int j = 0; j < row.size(); ++j) {
+        appendCell(out, row[j], cellWidths[j], j);
+        out += style.vertical;
     }
+    out += '\n';
+}
+
+void ConsoleTable::appendCell(std::string &out, const std::string &text, size_t textWidth, unsigned int column) const {
+    out.append(padding, ' ');
+    out += text;
+    out.append(columnWidth(column) - textWidth + padding, ' ');
+}
 
-    return line.str();
+size_t ConsoleTable::cellWidth(const std::string &text) const {
+    return displayWidth(text);
+}
+
+size_t ConsoleTable::renderSize() const {
+    size_t total = lineSize(style.topTittle) + tittleSize() + lineSize(style.middleTittle)
+        + rowSize(headers, headerWidths) + lineSize(style.middle) + lineSize(style.bottom);
+    for (size_t i = 0; i < rows.size(); ++i)
+        total += rowSize(rows[i], rowWidths[i]);
+    return total;
+}
+
+void ConsoleTable::render(std::string &out) const {
+    out.reserve(out.size() + renderSize());
+    appendLine(out, style.topTittle);
+    appendTittle(out);
+    appendLine(out, style.middleTittle);
+    appendRow(out, headers, headerWidths);
+    appendLine(out, style.middle);
+    for (size_t i = 0; i < rows.size(); ++i)
+        appendRow(out, rows[i], rowWidths[i]);
+    appendLine(out, style.bottom);
 }
 
 std::ostream &operator<<(std::ostream &out, const ConsoleTable &consoleTable) {
-    out << consoleTable.getLine(consoleTable.style.topTittle);
-    out << consoleTable.getTittle(consoleTable.tittle);
-    out << consoleTable.getLine(consoleTable.style.middleTittle);
-    out << consoleTable.getHeaders(consoleTable.headers);
-    out << consoleTable.getLine(consoleTable.style.middle);
-    out << consoleTable.getRows(consoleTable.rows);
-    out << consoleTable.getLine(consoleTable.style.bottom);
-    return out;
+    std::string text;
+    consoleTable.render(text);
+    return out.write(text.data(), text.size());
+}
+
+size_t ConsoleTable::rowCount() const {
+    return rows.size();
+}
+
+size_t ConsoleTable::lineCount() const {
+    return rows.size() + 6;
+}
+
+void ConsoleTable::redraw(std::ostream &out, unsigned int row) {
+    std::string frame;
+    if (layoutChanged || row != previousRow || previousRows.size() != rows.size()) {
+        std::string table;
+        render(table);
+        frame.reserve(table.size() + lineCount() * 16);
+        unsigned int line = row;
+        for (size_t start = 0, end; start < table.size(); start = end + 1, ++line) {
+            end = table.find('\n', start);
+            frame += "\e[" + std::to_string(line) + ";1H";
+            frame.append(table, start, end - start);
+            frame += "\e[K";
+        }
+    } else {
+        for (unsigned int i = 0; i < rows.size(); ++i) {
+            size_t column = 2;
+            for (unsigned int j = 0; j < rows[i].size(); ++j) {
+                if (j >= previousRows[i].size() || rows[i][j] != previousRows[i][j]) {
+                    frame += "\e[" + std::to_string(row + 5 + i) + ";" + std::to_string(column) + "H";
+                    appendCell(frame, rows[i][j], rowWidths[i][j], j);
+                }
+                column += columnWidth(j) + padding + padding + 1;
+            }
+        }
+    }
+    out.write(frame.data(), frame.size());
+    previousRows = rows;
+    previousRow = row;
+    layoutChanged = false;
 }
 
 bool ConsoleTable::sort(bool ascending) {
+    layoutChanged = true;
+    std::vector<size_t> order(rows.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
     if (ascending)
-        std::sort(rows.begin(), rows.end(), std::less<std::vector<std::string>>());
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return rows[a] < rows[b]; });
     else
-        std::sort(rows.begin(), rows.end(), std::greater<std::vector<std::string>>());
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return rows[a] > rows[b]; });
+    Rows sortedRows;
+    std::vector<Widths> sortedWidths;
+    sortedRows.reserve(rows.size());
+    sortedWidths.reserve(rows.size());
+    for (size_t index : order) {
+        sortedRows.push_back(std::move(rows[index]));
+        sortedWidths.push_back(std::move(rowWidths[index]));
+    }
+    rows = std::move(sortedRows);
+    rowWidths = std::move(sortedWidths);
     return true;
 }
 
 void ConsoleTable::updateRow(unsigned int row, unsigned int header, const std::string &data) {
-    if (row > rows.size() - 1)
+    if (row >= rows.size())
         throw std::out_of_range{"Row index out of range."};
-    if (header > headers.size() - 1)
+    if (header >= headers.size())
         throw std::out_of_range{"Header index out of range."};
 
     rows[row][header] = data;
+    size_t width = cellWidth(data);
+    rowWidths[row][header] = width;
+    if (width > widths[header]) {
+        widths[header] = width;
+        fitTittle();
+        layoutChanged = true;
+    }
 }
 
 void ConsoleTable::updateHeader(unsigned int header, const std::string &text) {
-    if (header > headers.size())
+    if (header >= headers.size())
         throw std::out_of_range{"Header index out of range."};
 
     headers[header] = text;
-}
-
-size_t ConsoleTable::searchColor(const std::string &text) const{
-    size_t pos = text.find(COLOR_INITIATOR_CHARACTER,0);
-    size_t counter = 0;
-    if (pos != std::string::npos){
-        counter = countCharacters(counter, pos, text, COLOR_FINAL_CHARACTER);
-        size_t rpos = text.rfind("\e");
-        if (rpos  != std::string::npos && rpos > pos)
-            counter = countCharacters(counter, rpos, text, COLOR_FINAL_CHARACTER);
-        return counter;
-    }
-    return counter;
+    headerWidths[header] = cellWidth(text);
+    widths[header] = std::max(widths[header], headerWidths[header]);
+    fitTittle();
+    layoutChanged = true;
 }
 
 std::string operator*(const std::string &other, int repeats) {
@@ -236,13 +399,3 @@ std::string operator*(const std::string &other, int repeats) {
         ret.append(other);
     return ret;
 }
-
-size_t countCharacters(size_t counter, size_t pos,const std::string &text, char characterBreaker){
-    counter++;
-    for(size_t i = pos; i < text.length(); i++){
-        if(text[i] == characterBreaker)
-            break;
-        counter++;
-    }
-    return counter;
-}
@@ -21,6 +21,11 @@ public:
     ConsoleTable(const std::initializer_list<std::string> headers);
 
 
+    /// Initialize a new ConsoleTable whose columns are only known at run time
+    /// \param headers The tables headers
+    explicit ConsoleTable(const Headers &headers);
+
+
     /// Sets the distance from the text to the cell border
     /// \param n Spaces between the text and the cell border
     void setPadding(unsigned int n);
@@ -49,6 +54,12 @@ public:
     bool addRow(std::initializer_list<std::string> row);
 
 
+    /// Adds a new row to the table
+    /// \param row A vector of strings to add as row
+    /// \return True if the value was added successfully, otherwise false
+    bool addRow(const std::vector<std::string> &row);
+
+
     /// Removes a row from the table by the row index
     /// \param index The index of the row that should be removed
     /// \return True if the row was removed successfully, otherwise false
@@ -68,6 +79,54 @@ public:
     void updateHeader(unsigned int header,const std::string &text);
 
 
+    /// Returns the number of rows of the table
+    /// \return Number of rows
+    size_t rowCount() const;
+
+
+    /// Returns the number of terminal lines the table takes when printed
+    /// \return Number of lines
+    size_t lineCount() const;
+
+
+    /// Returns the exact number of bytes render() appends
+    /// \return Size of the rendered table in bytes
+    size_t renderSize() const;
+
+
+    /// Appends the whole table to a string, reserving its exact size first so the
+    /// table is rendered with a single allocation
+    /// \param out The string the table is appended to
+    void render(std::string &out) const;
+
+
+    /// Writes the table starting at a terminal row, emitting only the cells that changed
+    /// since the previous call. The whole table is written again when its layout changed.
+    /// \param out The output stream the updates should be written to
+    /// \param row 1-based terminal row of the first line of the table
+    void redraw(std::ostream &out, unsigned int row);
+
+
+    /// Starts streaming the table with fixed column widths. The title and headers are written
+    /// immediately and every row added afterwards is written as soon as it is added instead
+    /// of being kept, cells wider than their column are truncated with an ellipsis.
+    /// \param out The output stream the table is written to, it must outlive the stream
+    /// \param columnWidths Display width of every column, raised to the width of its header
+    void beginStream(std::ostream &out, const Widths &columnWidths);
+
+
+    /// Starts streaming the table with column widths sampled from the first rows. Those rows
+    /// are kept until sampleRows of them have been added (or endStream() is called), then the
+    /// table starts printing and later rows are written as soon as they are added.
+    /// \param out The output stream the table is written to, it must outlive the stream
+    /// \param sampleRows Number of rows used to compute the column widths
+    void beginStream(std::ostream &out, size_t sampleRows);
+
+
+    /// Writes the rows still being sampled and the bottom line, and leaves streaming mode
+    void endStream();
+
+
     /// Operator of the addRow() function
     /// \param row A list of strings to add as row
     /// \return this
@@ -90,10 +149,40 @@ private:
     /// Holds all rows of the table
     Rows rows;
 
+    /// Holds the display width of every header, computed when it is set
+    Widths headerWidths;
+
+    /// Holds the display width of every cell, computed when the row is added or updated
+    std::vector<Widths> rowWidths;
+
 
     /// Holds the size of widest string of each column of the table
     Widths widths;
 
+    /// Display width of the title
+    size_t tittleWidth = 0;
+
+    /// Columns added to the last column so the title fits, see fitTittle()
+    size_t tittleExtra = 0;
+
+    /// Rows emitted by the previous redraw()
+    Rows previousRows;
+
+    /// Terminal row used by the previous redraw()
+    unsigned int previousRow = 0;
+
+    /// True when the next redraw() has to write the whole table
+    bool layoutChanged = true;
+
+    /// Destination of the rows while streaming, nullptr when the table keeps its rows
+    std::ostream *streamOut = nullptr;
+
+    /// Rows still to be sampled before a sampled stream starts printing
+    size_t streamSampleRows = 0;
+
+    /// Reused buffer of the row being streamed
+    std::string streamLine;
+
     /// Defines row type
     struct RowType {
         std::string left;
@@ -140,42 +229,85 @@ private:
     /// Space character constant
     const std::string SPACE_CHARACTER = " ";
 
-    /// Color initiator character constant
-    const std::string COLOR_INITIATOR_CHARACTER = "\e";
+    /// Appended to truncated cells while streaming
+    const std::string ELLIPSIS_CHARACTER = "…";
 
-    /// Color final character constant
-    const char COLOR_FINAL_CHARACTER = 'm';
+    /// Resets the colors of a truncated cell
+    const std::string COLOR_RESET = "\e[0m";
 
     /// The distance between the cell text and the cell border
     unsigned int padding = 1;
 
 
-    /// Returns a formatted horizontal separation line for the table
+    /// Returns the size in bytes of a horizontal separation line
     /// \param rowType The type of the row (top, middle, bottom)
-    /// \return The formatted row string
-    std::string getLine(RowType rowType) const;
+    /// \return Number of bytes of the line
+    size_t lineSize(const RowType &rowType) const;
 
-    size_t calculateDiference(int &diference, size_t width, const std::string &text) const;
+    /// Appends a horizontal separation line for the table
+    /// \param out The string the line is appended to
+    /// \param rowType The type of the row (top, middle, bottom)
+    void appendLine(std::string &out, const RowType &rowType) const;
+
+    /// Returns the display width between the left and right borders
+    size_t innerWidth() const;
+
+    /// Computes how much the last column is widened so the title fits between the borders
+    void fitTittle();
+
+    /// Returns the display width of a column, with the room made for the title
+    size_t columnWidth(size_t column) const {
+        return widths[column] + (column + 1 == widths.size() ? tittleExtra : 0);
+    }
+
+    /// Returns the number of spaces after the title
+    size_t tittleFill() const;
 
-    size_t calculateSizeRow(void) const;
+    /// Returns the size in bytes of the title row
+    /// \return Number of bytes of the title row
+    size_t tittleSize() const;
 
-    size_t simulateSizeRow(std::string text, int diference) const;
+    /// Appends the title row, padded to the width of the table
+    /// \param out The string the row is appended to
+    void appendTittle(std::string &out) const;
 
-    /// Returns a formatted header string
-    /// \param headers The Headers-object that holds the header strings
-    /// \return The formatted header string
-    std::string getHeaders(const Headers &headers) const;
+    /// Returns the size in bytes of a header or data row
+    /// \param row The cells of the row
+    /// \param cellWidths The display width of every cell
+    /// \return Number of bytes of the row
+    size_t rowSize(const std::vector<std::string> &row, const Widths &cellWidths) const;
 
+    /// Appends a header or data row
+    /// \param out The string the row is appended to
+    /// \param row The cells of the row
+    /// \param cellWidths The display width of every cell
+    void appendRow(std::string &out, const std::vector<std::string> &row, const Widths &cellWidths) const;
 
-    /// Returns a formmatted row string
-    /// \param rows The Rows-object that holds all rows of the table
-    /// \return A formatted string of all rows in the table
-    std::string getRows(const Rows &rows) const;
+    /// Appends a cell padded to the width of its column, without borders
+    /// \param out The string the cell is appended to
+    /// \param text The text of the cell
+    /// \param textWidth The display width of text
+    /// \param column The index of the column
+    void appendCell(std::string &out, const std::string &text, size_t textWidth, unsigned int column) const;
 
-    /// Returns a formmatted title row string
-    /// \param tittle The ttitle row of the table
-    /// \return A formatted string of a tittle rows in the table
-    std::string getTittle(const std::string &tittle) const;
+    /// Writes the title, the headers and the rows sampled so far to the stream
+    void startStreamOutput();
+
+    /// Writes a row to the stream, truncating the cells wider than their column
+    /// \param row The cells of the row
+    /// \param cellWidths The display width of every cell
+    void writeStreamRow(const std::vector<std::string> &row, const Widths &cellWidths);
+
+    /// Appends text cut to a display width, ending with an ellipsis
+    /// \param out The string the text is appended to
+    /// \param text The text of the cell
+    /// \param width The display width of the result
+    void appendTruncated(std::string &out, const std::string &text, size_t width) const;
+
+    /// Returns the number of terminal columns text takes, see displayWidth()
+    /// \param text The text of a cell
+    /// \return Display width of text
+    size_t cellWidth(const std::string &text) const;
 
 
     /// Writes the entire table with all its contents in the output stream
@@ -184,12 +316,6 @@ private:
     /// \param consoleTable The ConsoleTable-object
     /// \return Output stream with the formatted table string
     friend std::ostream &operator<<(std::ostream &out, const ConsoleTable &consoleTable);
-
-    /// Search color into the introduced text, return the number of
-    /// characters that you need to remove from the size.
-    /// \param text variable that contain text to analize
-    /// \return number of characters to remove from the size
-    size_t searchColor(const std::string &text) const;
 };
 
 
@@ -199,12 +325,4 @@ private:
 /// \return The repeated string
 std::string operator*(const std::string &other, int repeats);
 
-/// Count characters from position to characterBreaker and previous count
-/// \param counter this variable is the previous count
-/// \param pos is the position of the string that you need to start
-/// \param text strint to analize
-/// \param characterBreaker character to break the count
-/// \return return the count of characters
-size_t countCharacters(size_t counter, size_t pos,const std::string &text, char characterBreaker) ;
-
 #endif //CONSOLETABLE_CONSOLETABLE_H
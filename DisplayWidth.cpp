@@ -0,0 +1,289 @@
+#include "DisplayWidth.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define SUPERFREE_X86 1
+#endif
+
+namespace {
+
+const unsigned char ESCAPE = 0x1B;
+
+struct Range {
+    uint32_t first;
+    uint32_t last;
+};
+
+/// Code points that take no column: combining marks, zero width spaces and joiners,
+/// variation selectors
+const Range ZERO_WIDTH[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E},
+    {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+    {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF},
+};
+
+/// East Asian Wide and Fullwidth code points
+const Range WIDE[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+    {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18CFF}, {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F320},
+    {0x1F32D, 0x1F335}, {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA},
+    {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E},
+    {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E},
+    {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4},
+    {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2},
+    {0x1F6D5, 0x1F6D7}, {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB},
+    {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <size_t N>
+bool inRanges(const Range (&ranges)[N], uint32_t codePoint) {
+    if (codePoint < ranges[0].first || codePoint > ranges[N - 1].last)
+        return false;
+    size_t low = 0;
+    size_t high = N;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (codePoint > ranges[middle].last)
+            low = middle + 1;
+        else if (codePoint < ranges[middle].first)
+            high = middle;
+        else
+            return true;
+    }
+    return false;
+}
+
+/// Returns the length of the escape sequence starting at text, which points to ESC
+size_t escapeLength(const unsigned char *text, const unsigned char *end) {
+    const unsigned char *pos = text + 1;
+    if (pos == end)
+        return 1;
+    if (*pos == '[') {
+        for (++pos; pos < end; ++pos) {
+            if (*pos >= 0x40 && *pos <= 0x7E)
+                return pos - text + 1;
+        }
+        return end - text;
+    }
+    if (*pos == ']') {
+        for (++pos; pos < end; ++pos) {
+            if (*pos == 0x07)
+                return pos - text + 1;
+            if (*pos == ESCAPE && pos + 1 < end && pos[1] == '\\')
+                return pos - text + 2;
+        }
+        return end - text;
+    }
+    return 2;
+}
+
+/// Decodes one UTF-8 code point, returns its length or 0 when the sequence is invalid
+size_t decodeUtf8(const unsigned char *text, const unsigned char *end, uint32_t &codePoint) {
+    unsigned char lead = *text;
+    size_t length;
+    uint32_t minimum;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codePoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codePoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codePoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - text) < length)
+        return 0;
+    for (size_t i = 1; i < length; ++i) {
+        if ((text[i] & 0xC0) != 0x80)
+            return 0;
+        codePoint = (codePoint << 6) | (text[i] & 0x3F);
+    }
+    if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        return 0;
+    return length;
+}
+
+/// Measures one unit (escape sequence, control character or code point) and returns its length
+size_t scanUnit(const unsigned char *text, const unsigned char *end, size_t &width) {
+    unsigned char c = *text;
+    if (c == ESCAPE)
+        return escapeLength(text, end);
+    if (c < 0x80) {
+        if (c >= 0x20 && c != 0x7F)
+            width += 1;
+        return 1;
+    }
+    uint32_t codePoint;
+    size_t length = decodeUtf8(text, end, codePoint);
+    if (length == 0) {
+        width += 1;
+        return 1;
+    }
+    width += codePointWidth(codePoint);
+    return length;
+}
+
+#ifdef SUPERFREE_X86
+/// Number of leading bytes of a 16 byte block that are printable ASCII
+inline unsigned int printablePrefix16(const unsigned char *text) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+    __m128i printable = _mm_andnot_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x7F)),
+                                         _mm_cmpgt_epi8(block, _mm_set1_epi8(0x1F)));
+    unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(printable));
+    return mask == 0xFFFF ? 16 : __builtin_ctz(~mask);
+}
+
+/// Counts 32 bytes of printable ASCII at a time, compiled for AVX2 and selected at runtime
+__attribute__((target("avx2")))
+size_t displayWidthAvx2(const unsigned char *pos, const unsigned char *end) {
+    size_t width = 0;
+    while (end - pos >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+        __m256i printable = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x7F)),
+                                                _mm256_cmpgt_epi8(block, _mm256_set1_epi8(0x1F)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(printable));
+        if (mask == 0xFFFFFFFFu) {
+            width += 32;
+            pos += 32;
+            continue;
+        }
+        unsigned int prefix = __builtin_ctz(~mask);
+        width += prefix;
+        pos += prefix;
+        pos += scanUnit(pos, end, width);
+    }
+    while (end - pos >= 16) {
+        unsigned int prefix = printablePrefix16(pos);
+        width += prefix;
+        pos += prefix;
+        if (prefix < 16)
+            pos += scanUnit(pos, end, width);
+    }
+    while (pos < end)
+        pos += scanUnit(pos, end, width);
+    return width;
+}
+
+size_t displayWidthSse2(const unsigned char *pos, const unsigned char *end) {
+    size_t width = 0;
+    while (end - pos >= 16) {
+        unsigned int prefix = printablePrefix16(pos);
+        width += prefix;
+        pos += prefix;
+        if (prefix < 16)
+            pos += scanUnit(pos, end, width);
+    }
+    while (pos < end)
+        pos += scanUnit(pos, end, width);
+    return width;
+}
+
+typedef size_t (*WidthFunction)(const unsigned char *, const unsigned char *);
+
+WidthFunction selectWidthFunction() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return displayWidthAvx2;
+    return displayWidthSse2;
+}
+#endif
+
+}
+
+unsigned int codePointWidth(uint32_t codePoint) {
+    if (codePoint < 0x20 || (codePoint >= 0x7F && codePoint < 0xA0))
+        return 0;
+    if (codePoint < 0x300)
+        return 1;
+    if (inRanges(ZERO_WIDTH, codePoint))
+        return 0;
+    if (inRanges(WIDE, codePoint))
+        return 2;
+    return 1;
+}
+
+size_t displayWidthScalar(const char *text, size_t length) {
+    const unsigned char *pos = reinterpret_cast<const unsigned char *>(text);
+    const unsigned char *end = pos + length;
+    size_t width = 0;
+    while (pos < end)
+        pos += scanUnit(pos, end, width);
+    return width;
+}
+
+size_t displayWidth(const char *text, size_t length) {
+#ifdef SUPERFREE_X86
+    static const WidthFunction function = selectWidthFunction();
+    const unsigned char *pos = reinterpret_cast<const unsigned char *>(text);
+    return function(pos, pos + length);
+#else
+    return displayWidthScalar(text, length);
+#endif
+}
+
+bool displayWidthAvailable(DisplayWidthPath path) {
+    switch (path) {
+        case DisplayWidthPath::Scalar:
+            return true;
+#ifdef SUPERFREE_X86
+        case DisplayWidthPath::Sse2:
+            return true;
+        case DisplayWidthPath::Avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+size_t displayWidthWith(DisplayWidthPath path, const char *text, size_t length) {
+    const unsigned char *pos = reinterpret_cast<const unsigned char *>(text);
+    switch (path) {
+#ifdef SUPERFREE_X86
+        case DisplayWidthPath::Sse2:
+            return displayWidthSse2(pos, pos + length);
+        case DisplayWidthPath::Avx2:
+            return displayWidthAvx2(pos, pos + length);
+#endif
+        default:
+            return displayWidthScalar(text, length);
+    }
+}
+
+size_t displayPrefixLength(const char *text, size_t length, size_t width) {
+    const unsigned char *begin = reinterpret_cast<const unsigned char *>(text);
+    const unsigned char *end = begin + length;
+    const unsigned char *pos = begin;
+    size_t used = 0;
+    while (pos < end) {
+        size_t unitWidth = 0;
+        size_t unitLength = scanUnit(pos, end, unitWidth);
+        if (used + unitWidth > width)
+            break;
+        used += unitWidth;
+        pos += unitLength;
+    }
+    return pos - begin;
+}
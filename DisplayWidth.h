@@ -0,0 +1,71 @@
+#ifndef SUPERFREE_DISPLAYWIDTH_H
+#define SUPERFREE_DISPLAYWIDTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Returns the number of terminal columns a text takes. Escape sequences (CSI, OSC and
+/// two-byte ESC sequences) and control characters take 0 columns, combining marks 0,
+/// East Asian wide and fullwidth code points 2 and every other UTF-8 code point 1.
+/// Invalid UTF-8 bytes take 1 column each. Runs of printable ASCII are counted with
+/// SSE2, or AVX2 when the CPU supports it.
+/// \param text The text to measure
+/// \param length Number of bytes of text
+/// \return Display width of text
+size_t displayWidth(const char *text, size_t length);
+
+
+/// Returns the number of terminal columns a text takes, see displayWidth(const char *, size_t)
+/// \param text The text to measure
+/// \return Display width of text
+inline size_t displayWidth(const std::string &text) {
+    return displayWidth(text.data(), text.size());
+}
+
+
+/// Scalar reference of displayWidth(), one code point at a time
+/// \param text The text to measure
+/// \param length Number of bytes of text
+/// \return Display width of text
+size_t displayWidthScalar(const char *text, size_t length);
+
+
+/// Implementations of displayWidth()
+enum class DisplayWidthPath {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+
+/// Returns true if an implementation is compiled in and the CPU supports it
+/// \param path The implementation
+/// \return True if displayWidthWith() can run it
+bool displayWidthAvailable(DisplayWidthPath path);
+
+
+/// Returns the display width computed by a given implementation, to check every one the
+/// CPU supports against the scalar reference and not only the one displayWidth() selects
+/// \param path The implementation, displayWidthAvailable() must be true for it
+/// \param text The text to measure
+/// \param length Number of bytes of text
+/// \return Display width of text
+size_t displayWidthWith(DisplayWidthPath path, const char *text, size_t length);
+
+
+/// Returns the length in bytes of the longest prefix of text that takes at most width columns.
+/// Escape sequences are never split and the ones found before the limit are included.
+/// \param text The text to cut
+/// \param length Number of bytes of text
+/// \param width Maximum display width of the prefix
+/// \return Number of bytes of the prefix
+size_t displayPrefixLength(const char *text, size_t length, size_t width);
+
+
+/// Returns the number of columns of a code point: 0, 1 or 2
+/// \param codePoint Unicode code point
+/// \return Display width of the code point
+unsigned int codePointWidth(uint32_t codePoint);
+
+#endif //SUPERFREE_DISPLAYWIDTH_H
@@ -0,0 +1,135 @@
+#include "Forecast.h"
+
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+/// Forecasts further away than this are shown as stable, a slope this small is noise
+const double FORECAST_HORIZON = 30 * 24 * 3600;
+
+}
+
+void Trend::add(double seconds, double value) {
+    if (count == 0) {
+        originTime = seconds;
+        originValue = value;
+    }
+    if (count == FORECAST_WINDOW) {
+        const double t = times[next] - originTime;
+        const double v = values[next] - originValue;
+        sumT -= t;
+        sumV -= v;
+        sumTT -= t * t;
+        sumTV -= t * v;
+        count--;
+    }
+    times[next] = seconds;
+    values[next] = value;
+    next = (next + 1) % FORECAST_WINDOW;
+    count++;
+    const double t = seconds - originTime;
+    const double v = value - originValue;
+    sumT += t;
+    sumV += v;
+    sumTT += t * t;
+    sumTV += t * v;
+    if (++sinceRebase >= FORECAST_WINDOW)
+        rebase();
+}
+
+void Trend::rebase() {
+    const size_t oldest = (next + FORECAST_WINDOW - count) % FORECAST_WINDOW;
+    originTime = times[oldest];
+    originValue = values[oldest];
+    sumT = sumV = sumTT = sumTV = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t index = (oldest + i) % FORECAST_WINDOW;
+        const double t = times[index] - originTime;
+        const double v = values[index] - originValue;
+        sumT += t;
+        sumV += v;
+        sumTT += t * t;
+        sumTV += t * v;
+    }
+    sinceRebase = 0;
+}
+
+double Trend::slope() const {
+    const double n = static_cast<double>(count);
+    const double variance = n * sumTT - sumT * sumT;
+    if (count < 2 || variance <= 0)
+        return 0;
+    return (n * sumTV - sumT * sumV) / variance;
+}
+
+double Trend::last() const {
+    return count > 0 ? values[(next + FORECAST_WINDOW - 1) % FORECAST_WINDOW] : 0;
+}
+
+void Trend::clear() {
+    next = count = sinceRebase = 0;
+    sumT = sumV = sumTT = sumTV = 0;
+}
+
+void ExhaustionForecast::add(Quantity available, Quantity memTotal, Quantity swapFree, Quantity swapTotal) {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    addAt(static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) / 1e9, available, memTotal, swapFree,
+          swapTotal);
+}
+
+void ExhaustionForecast::addAt(double seconds, Quantity available, Quantity memTotal, Quantity swapFree,
+                               Quantity swapTotal) {
+    this->available.add(seconds, static_cast<double>(available.bytes()));
+    memThreshold = static_cast<double>(memTotal.bytes()) * thresholdPercent / 100;
+    // Swap turned off or on makes the previous samples meaningless
+    if (swapTotal.bytes() == 0) {
+        this->swapFree.clear();
+        swapThreshold = -1;
+        return;
+    }
+    if (swapThreshold < 0)
+        this->swapFree.clear();
+    this->swapFree.add(seconds, static_cast<double>(swapFree.bytes()));
+    swapThreshold = static_cast<double>(swapTotal.bytes()) * thresholdPercent / 100;
+}
+
+Exhaustion ExhaustionForecast::project(const Trend &trend, double threshold) {
+    Exhaustion exhaustion;
+    if (trend.size() < FORECAST_MIN_SAMPLES)
+        return exhaustion;
+    exhaustion.known = true;
+    exhaustion.bytesPerSecond = trend.slope();
+    const double left = trend.last() - threshold;
+    if (left <= 0)
+        exhaustion.seconds = 0;
+    else if (exhaustion.bytesPerSecond < 0 && left / -exhaustion.bytesPerSecond < FORECAST_HORIZON)
+        exhaustion.seconds = left / -exhaustion.bytesPerSecond;
+    return exhaustion;
+}
+
+std::string formatExhaustion(const Exhaustion &exhaustion) {
+    if (!exhaustion.known)
+        return "-";
+    if (exhaustion.seconds < 0)
+        return "stable";
+    if (exhaustion.seconds < 1)
+        return "\e[38;5;197mnow\e[0m";
+    const unsigned long seconds = static_cast<unsigned long>(exhaustion.seconds + 0.5);
+    char text[32];
+    if (seconds < 60)
+        std::snprintf(text, sizeof(text), "%lus", seconds);
+    else if (seconds < 3600)
+        std::snprintf(text, sizeof(text), "%lum %02lus", seconds / 60, seconds % 60);
+    else if (seconds < 86400)
+        std::snprintf(text, sizeof(text), "%luh %02lum", seconds / 3600, seconds % 3600 / 60);
+    else
+        std::snprintf(text, sizeof(text), "%lud %02luh", seconds / 86400, seconds % 86400 / 3600);
+    // Red within the hour, yellow within the day, as the bars
+    if (seconds < 3600)
+        return std::string("\e[38;5;197m") + text + "\e[0m";
+    if (seconds < 86400)
+        return std::string("\e[38;5;226m") + text + "\e[0m";
+    return text;
+}
@@ -0,0 +1,135 @@
+#ifndef SUPERFREE_FORECAST_H
+#define SUPERFREE_FORECAST_H
+
+#include <cstddef>
+#include <string>
+#include "Units.h"
+
+/// Number of most recent samples the trend is fitted on, one minute with -s 1
+const size_t FORECAST_WINDOW = 60;
+
+/// Samples needed before a forecast is made
+const size_t FORECAST_MIN_SAMPLES = 3;
+
+/// Least-squares line through the last FORECAST_WINDOW samples. Adding a sample updates
+/// the sums in O(1): the new sample is added and the one leaving the window subtracted.
+/// The sums are recomputed around the oldest sample once per window, so the rounding of
+/// the removals does not build up and the values stay small.
+class Trend {
+public:
+
+    /// Adds a sample, replacing the oldest one when the window is full
+    /// \param seconds Time of the sample, increasing
+    /// \param value Value of the sample
+    void add(double seconds, double value);
+
+
+    /// Returns the number of samples in the window
+    size_t size() const {
+        return count;
+    }
+
+
+    /// Returns the change of the value per second, 0 with fewer than 2 distinct times
+    double slope() const;
+
+
+    /// Returns the value of the newest sample
+    double last() const;
+
+
+    /// Removes every sample
+    void clear();
+
+private:
+
+    double times[FORECAST_WINDOW] = {};
+    double values[FORECAST_WINDOW] = {};
+    /// Index of the next sample written
+    size_t next = 0;
+    size_t count = 0;
+    /// Samples added since the sums were last recomputed
+    size_t sinceRebase = 0;
+    /// Time and value subtracted from the samples in the sums
+    double originTime = 0;
+    double originValue = 0;
+    double sumT = 0;
+    double sumV = 0;
+    double sumTT = 0;
+    double sumTV = 0;
+
+    /// Recomputes the sums around the oldest sample
+    void rebase();
+};
+
+
+/// Forecast of a quantity running out
+struct Exhaustion {
+    /// False until FORECAST_MIN_SAMPLES samples were taken, or without anything to exhaust
+    bool known = false;
+    /// Seconds until the quantity falls to the threshold, 0 when it already did, negative
+    /// when it is not decreasing
+    double seconds = -1;
+    /// Change of the quantity in bytes per second
+    double bytesPerSecond = 0;
+};
+
+
+/// Projects when available memory and free swap reach a threshold from their trends
+class ExhaustionForecast {
+public:
+
+    /// \param thresholdPercent Share of the total at which memory and swap count as
+    /// exhausted, 0 when nothing is left
+    explicit ExhaustionForecast(double thresholdPercent = 0) : thresholdPercent{thresholdPercent} {
+    }
+
+
+    /// Adds a sample taken now, on CLOCK_MONOTONIC
+    /// \param available Available memory
+    /// \param memTotal Total memory
+    /// \param swapFree Free swap
+    /// \param swapTotal Total swap
+    void add(Quantity available, Quantity memTotal, Quantity swapFree, Quantity swapTotal);
+
+
+    /// Adds a sample taken at a given time, e.g. of a recording
+    /// \param seconds Time of the sample, increasing
+    /// \param available Available memory
+    /// \param memTotal Total memory
+    /// \param swapFree Free swap
+    /// \param swapTotal Total swap
+    void addAt(double seconds, Quantity available, Quantity memTotal, Quantity swapFree, Quantity swapTotal);
+
+
+    /// Returns when available memory reaches the threshold
+    Exhaustion memory() const {
+        return project(available, memThreshold);
+    }
+
+
+    /// Returns when free swap reaches the threshold, unknown without swap
+    Exhaustion swap() const {
+        return swapThreshold >= 0 ? project(swapFree, swapThreshold) : Exhaustion{};
+    }
+
+private:
+
+    double thresholdPercent;
+    Trend available;
+    Trend swapFree;
+    /// Thresholds in bytes of the newest sample, negative without swap
+    double memThreshold = 0;
+    double swapThreshold = -1;
+
+    static Exhaustion project(const Trend &trend, double threshold);
+};
+
+
+/// Formats a forecast for a table, e.g. "2h 05m", "-" when unknown and "stable" when the
+/// quantity is not decreasing
+/// \param exhaustion The forecast
+/// \return The text of the cell
+std::string formatExhaustion(const Exhaustion &exhaustion);
+
+#endif //SUPERFREE_FORECAST_H
@@ -0,0 +1,222 @@
+#include "Fragmentation.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <initializer_list>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MemInfoParser.h"
+
+namespace {
+
+/// Size of the first read, zoneinfo grows with every node and CPU
+const size_t FRAGMENTATION_INITIAL_SIZE = 16384;
+
+const char *skipSpaces(const char *pos, const char *end) {
+    while (pos < end && (*pos == ' ' || *pos == '\t'))
+        ++pos;
+    return pos;
+}
+
+/// Returns the end of the token starting at pos
+const char *tokenEnd(const char *pos, const char *end) {
+    while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\n' && *pos != ',')
+        ++pos;
+    return pos;
+}
+
+const char *parseNumber(const char *pos, const char *end, uint64_t &value) {
+    value = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+        value = value * 10 + static_cast<uint64_t>(*pos - '0');
+    return pos;
+}
+
+const char *nextLine(const char *pos, const char *end) {
+    const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    return newline != nullptr ? newline + 1 : end;
+}
+
+bool tokenIs(const char *token, const char *tokenEnd, const char *literal) {
+    const size_t length = std::strlen(literal);
+    return static_cast<size_t>(tokenEnd - token) == length && std::memcmp(token, literal, length) == 0;
+}
+
+/// Parses "Node <n>, zone <name>" at the start of a line of buddyinfo or zoneinfo
+bool parseZoneHeader(const char *&pos, const char *end, unsigned int &node, char (&zone)[ZONE_NAME_SIZE]) {
+    static const char NODE[] = "Node ";
+    if (static_cast<size_t>(end - pos) < sizeof(NODE) || std::memcmp(pos, NODE, sizeof(NODE) - 1) != 0)
+        return false;
+    uint64_t number;
+    pos = parseNumber(pos + sizeof(NODE) - 1, end, number);
+    node = static_cast<unsigned int>(number);
+    static const char ZONE[] = ", zone";
+    if (static_cast<size_t>(end - pos) < sizeof(ZONE) || std::memcmp(pos, ZONE, sizeof(ZONE) - 1) != 0)
+        return false;
+    pos = skipSpaces(pos + sizeof(ZONE) - 1, end);
+    const char *nameEnd = tokenEnd(pos, end);
+    const size_t length = std::min<size_t>(nameEnd - pos, ZONE_NAME_SIZE - 1);
+    std::memcpy(zone, pos, length);
+    zone[length] = '\0';
+    pos = nameEnd;
+    return true;
+}
+
+}
+
+uint64_t ZoneFreeBlocks::freePages() const {
+    uint64_t pages = 0;
+    for (unsigned int order = 0; order < orders; ++order)
+        pages += blocks[order] << order;
+    return pages;
+}
+
+uint64_t ZoneFreeBlocks::unusablePages(unsigned int order) const {
+    uint64_t pages = 0;
+    for (unsigned int smaller = 0; smaller < order && smaller < orders; ++smaller)
+        pages += blocks[smaller] << smaller;
+    return pages;
+}
+
+int ZoneFreeBlocks::largestOrder() const {
+    for (int order = static_cast<int>(orders) - 1; order >= 0; --order) {
+        if (blocks[order] > 0)
+            return order;
+    }
+    return -1;
+}
+
+bool parseBuddyInfo(const char *text, size_t length, std::vector<ZoneFreeBlocks> &zones) {
+    zones.clear();
+    const char *end = text + length;
+    for (const char *pos = text; pos < end; pos = nextLine(pos, end)) {
+        ZoneFreeBlocks zone;
+        if (!parseZoneHeader(pos, end, zone.node, zone.zone))
+            continue;
+        for (pos = skipSpaces(pos, end); pos < end && *pos >= '0' && *pos <= '9'; pos = skipSpaces(pos, end)) {
+            uint64_t count;
+            pos = parseNumber(pos, end, count);
+            if (zone.orders < FRAGMENTATION_MAX_ORDERS)
+                zone.blocks[zone.orders++] = count;
+        }
+        zones.push_back(zone);
+    }
+    return !zones.empty();
+}
+
+void parseZoneInfo(const char *text, size_t length, std::vector<ZoneFreeBlocks> &zones) {
+    const char *end = text + length;
+    ZoneFreeBlocks *current = nullptr;
+    size_t next = 0;
+    for (const char *pos = text; pos < end; pos = nextLine(pos, end)) {
+        if (*pos == 'N') {
+            unsigned int node;
+            char name[ZONE_NAME_SIZE];
+            if (!parseZoneHeader(pos, end, node, name))
+                continue;
+            // Both files list the zones in the same order, zoneinfo also has the empty ones
+            current = nullptr;
+            for (size_t i = 0; i < zones.size() && current == nullptr; ++i) {
+                ZoneFreeBlocks &zone = zones[(next + i) % zones.size()];
+                if (zone.node == node && std::strcmp(zone.zone, name) == 0) {
+                    current = &zone;
+                    next = (next + i + 1) % zones.size();
+                }
+            }
+            continue;
+        }
+        if (current == nullptr)
+            continue;
+        // Only the watermarks are indented by 8 spaces and followed by a single word
+        const char *key = skipSpaces(pos, end);
+        if (key == pos || key >= end || *key < 'a' || *key > 'z')
+            continue;
+        const char *keyEnd = tokenEnd(key, end);
+        uint64_t *target = nullptr;
+        if (tokenIs(key, keyEnd, "min"))
+            target = &current->watermarkMin;
+        else if (tokenIs(key, keyEnd, "low"))
+            target = &current->watermarkLow;
+        else if (tokenIs(key, keyEnd, "high"))
+            target = &current->watermarkHigh;
+        else if (tokenIs(key, keyEnd, "managed"))
+            target = &current->managed;
+        if (target != nullptr)
+            parseNumber(skipSpaces(keyEnd, end), end, *target);
+    }
+}
+
+void parseCompaction(const char *text, size_t length, CompactionStats &stats) {
+    scanSpaceKeyValues(text, length, [&](const char *key, size_t keyLength, uint64_t value) {
+        static const char PREFIX[] = "compact_";
+        if (keyLength < sizeof(PREFIX) - 1 || std::memcmp(key, PREFIX, sizeof(PREFIX) - 1) != 0)
+            return;
+        const char *name = key + sizeof(PREFIX) - 1;
+        const char *nameEnd = key + keyLength;
+        if (tokenIs(name, nameEnd, "stall"))
+            stats.stall = value;
+        else if (tokenIs(name, nameEnd, "fail"))
+            stats.fail = value;
+        else if (tokenIs(name, nameEnd, "success"))
+            stats.success = value;
+        else if (tokenIs(name, nameEnd, "migrate_scanned"))
+            stats.migrateScanned = value;
+        else if (tokenIs(name, nameEnd, "free_scanned"))
+            stats.freeScanned = value;
+        else if (tokenIs(name, nameEnd, "daemon_wake"))
+            stats.daemonWake = value;
+    });
+}
+
+FragmentationReader::FragmentationReader(const std::string &procRoot)
+        : buddyinfoFd{open((procRoot + "/buddyinfo").c_str(), O_RDONLY | O_CLOEXEC)},
+          zoneinfoFd{open((procRoot + "/zoneinfo").c_str(), O_RDONLY | O_CLOEXEC)},
+          vmstatFd{open((procRoot + "/vmstat").c_str(), O_RDONLY | O_CLOEXEC)},
+          buffer(FRAGMENTATION_INITIAL_SIZE) {
+}
+
+FragmentationReader::~FragmentationReader() {
+    for (int fd : {buddyinfoFd, zoneinfoFd, vmstatFd}) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+ssize_t FragmentationReader::readAll(int fd) {
+    if (fd < 0)
+        return -1;
+    size_t length = 0;
+    for (;;) {
+        if (length == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        ssize_t n = pread(fd, buffer.data() + length, buffer.size() - length, static_cast<off_t>(length));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0)
+            return static_cast<ssize_t>(length);
+        length += static_cast<size_t>(n);
+    }
+}
+
+bool FragmentationReader::read(std::vector<ZoneFreeBlocks> &zones) {
+    ssize_t length = readAll(buddyinfoFd);
+    if (length <= 0 || !parseBuddyInfo(buffer.data(), static_cast<size_t>(length), zones))
+        return false;
+    length = readAll(zoneinfoFd);
+    if (length > 0)
+        parseZoneInfo(buffer.data(), static_cast<size_t>(length), zones);
+    return true;
+}
+
+bool FragmentationReader::readCompaction(CompactionStats &stats) {
+    const ssize_t length = readAll(vmstatFd);
+    if (length <= 0)
+        return false;
+    clock_gettime(CLOCK_MONOTONIC, &stats.time);
+    parseCompaction(buffer.data(), static_cast<size_t>(length), stats);
+    return true;
+}
@@ -0,0 +1,131 @@
+#ifndef SUPERFREE_FRAGMENTATION_H
+#define SUPERFREE_FRAGMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/// Largest number of orders kept per zone, the kernel has 11 (MAX_ORDER 10) on most
+/// configurations and up to 14 with large base pages
+const unsigned int FRAGMENTATION_MAX_ORDERS = 16;
+
+/// Maximum length of a zone name kept, e.g. "Normal"
+const size_t ZONE_NAME_SIZE = 16;
+
+/// Order from which the kernel treats an allocation as costly (PAGE_ALLOC_COSTLY_ORDER)
+const unsigned int COSTLY_ORDER = 3;
+
+/// Free memory of one zone: blocks per order from /proc/buddyinfo and watermarks from
+/// /proc/zoneinfo, all in pages
+struct ZoneFreeBlocks {
+    unsigned int node = 0;
+    char zone[ZONE_NAME_SIZE] = {};
+    /// Number of orders reported
+    unsigned int orders = 0;
+    /// Free blocks of 2^order pages
+    uint64_t blocks[FRAGMENTATION_MAX_ORDERS] = {};
+    /// Pages managed by the buddy allocator, 0 when zoneinfo was not read
+    uint64_t managed = 0;
+    uint64_t watermarkMin = 0;
+    uint64_t watermarkLow = 0;
+    uint64_t watermarkHigh = 0;
+
+    /// Returns the number of free pages
+    uint64_t freePages() const;
+
+    /// Returns the free pages in blocks smaller than 2^order pages, which an allocation of
+    /// that order cannot use
+    uint64_t unusablePages(unsigned int order) const;
+
+    /// Returns the largest order with a free block, -1 when nothing is free
+    int largestOrder() const;
+};
+
+
+/// Compaction counters of /proc/vmstat
+struct CompactionStats {
+    /// Allocations that stalled to compact memory directly
+    uint64_t stall = 0;
+    uint64_t fail = 0;
+    uint64_t success = 0;
+    /// Pages scanned for movable pages and for free target pages
+    uint64_t migrateScanned = 0;
+    uint64_t freeScanned = 0;
+    /// Times kcompactd was woken up
+    uint64_t daemonWake = 0;
+    /// CLOCK_MONOTONIC time of the read
+    timespec time{};
+};
+
+
+/// Parses /proc/buddyinfo in place
+/// \param text Content of the file
+/// \param length Number of bytes of text
+/// \param zones Receives one entry per populated zone, cleared first
+/// \return False if no zone was found
+bool parseBuddyInfo(const char *text, size_t length, std::vector<ZoneFreeBlocks> &zones);
+
+
+/// Parses the watermarks and managed pages of /proc/zoneinfo in a single pass, only
+/// looking at the lines that start a zone or hold one of these keys
+/// \param text Content of the file
+/// \param length Number of bytes of text
+/// \param zones Zones of parseBuddyInfo() to complete, matched by node and name
+void parseZoneInfo(const char *text, size_t length, std::vector<ZoneFreeBlocks> &zones);
+
+
+/// Parses the compaction counters of /proc/vmstat, missing ones stay 0
+/// \param text Content of the file
+/// \param length Number of bytes of text
+/// \param stats Receives the counters
+void parseCompaction(const char *text, size_t length, CompactionStats &stats);
+
+
+/// Reads buddyinfo, zoneinfo and vmstat, kept open so a refresh only costs pread(2) calls
+/// into buffers that are reused
+class FragmentationReader {
+public:
+
+    /// Opens the files, see isOpen()
+    /// \param procRoot Directory holding the files, usually /proc
+    explicit FragmentationReader(const std::string &procRoot = "/proc");
+
+    ~FragmentationReader();
+
+    FragmentationReader(const FragmentationReader &) = delete;
+    FragmentationReader &operator=(const FragmentationReader &) = delete;
+
+
+    /// Returns true if buddyinfo could be opened, zoneinfo and vmstat are optional
+    bool isOpen() const {
+        return buddyinfoFd >= 0;
+    }
+
+
+    /// Reads the free blocks of every zone
+    /// \param zones Receives one entry per populated zone
+    /// \return False if buddyinfo could not be read
+    bool read(std::vector<ZoneFreeBlocks> &zones);
+
+
+    /// Reads the compaction counters
+    /// \param stats Receives the counters and the time of the read
+    /// \return False if vmstat could not be read
+    bool readCompaction(CompactionStats &stats);
+
+private:
+
+    int buddyinfoFd;
+    int zoneinfoFd;
+    int vmstatFd;
+    /// Content of the last file read, grown to fit zoneinfo
+    std::vector<char> buffer;
+
+    /// Reads a whole file into buffer, returns its length or -1
+    ssize_t readAll(int fd);
+};
+
+#endif //SUPERFREE_FRAGMENTATION_H
@@ -0,0 +1,142 @@
+#include "KernelMemory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+/// Size of the first read of slabinfo, about 200 caches
+const size_t SLABINFO_INITIAL_SIZE = 32768;
+
+/// Numbers of a slabinfo line after the name: 5 object counts, 3 tunables and 3 slab counts
+const size_t SLABINFO_NUMBERS = 11;
+
+bool byBytesDescending(const SlabCache &a, const SlabCache &b) {
+    return a.bytes > b.bytes;
+}
+
+/// Returns the start of the line following pos
+const char *nextLine(const char *pos, const char *end) {
+    const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    return newline != nullptr ? newline + 1 : end;
+}
+
+}
+
+KernelBreakdown kernelBreakdown(const MemInfoData &data) {
+    KernelBreakdown kernel;
+    kernel.slabReclaimable = data.sReclaimable;
+    kernel.slabUnreclaimable = data.sUnreclaim;
+    kernel.kernelStack = data.kernelStack;
+    kernel.pageTables = data.pageTables;
+    kernel.secPageTables = data.has(MemInfoField::secPageTables) ? data.secPageTables : 0;
+    kernel.vmalloc = data.vmallocUsed;
+    kernel.percpu = data.has(MemInfoField::percpu) ? data.percpu : 0;
+    // Hugetlb (4.16) counts the pools of every page size, HugePages_* only the default one
+    const uint64_t total = data.hugePagesTotal * data.hugepageSize;
+    kernel.hugePages = data.has(MemInfoField::hugetlb) ? std::max(data.hugetlb, total) : total;
+    const uint64_t free = std::min(data.hugePagesFree, data.hugePagesTotal);
+    kernel.hugePagesUsed = (data.hugePagesTotal - free) * data.hugepageSize;
+    return kernel;
+}
+
+bool parseSlabInfo(const char *text, size_t length, uint64_t pageSize, std::vector<SlabCache> &caches) {
+    caches.clear();
+    const char *pos = text;
+    const char *end = text + length;
+    static const char HEADER[] = "slabinfo - version: 2.";
+    if (length < sizeof(HEADER) - 1 || std::memcmp(text, HEADER, sizeof(HEADER) - 1) != 0)
+        return false;
+
+    for (pos = nextLine(pos, end); pos < end; ) {
+        if (*pos == '#') {
+            pos = nextLine(pos, end);
+            continue;
+        }
+        SlabCache cache;
+        size_t nameLength = 0;
+        for (; pos < end && *pos != ' ' && *pos != '\n'; ++pos) {
+            if (nameLength < SLAB_NAME_SIZE - 1)
+                cache.name[nameLength++] = *pos;
+        }
+        cache.name[nameLength] = '\0';
+
+        // Numbers in order, skipping the ": tunables" and ": slabdata" labels
+        uint64_t numbers[SLABINFO_NUMBERS];
+        size_t count = 0;
+        while (pos < end && *pos != '\n') {
+            if (*pos >= '0' && *pos <= '9') {
+                uint64_t value = 0;
+                for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+                    value = value * 10 + static_cast<uint64_t>(*pos - '0');
+                if (count < SLABINFO_NUMBERS)
+                    numbers[count++] = value;
+            } else {
+                for (; pos < end && *pos != ' ' && *pos != '\n'; ++pos) {
+                }
+                for (; pos < end && *pos == ' '; ++pos) {
+                }
+            }
+        }
+        if (pos < end)
+            ++pos;
+        if (count < SLABINFO_NUMBERS || nameLength == 0)
+            continue;
+        cache.activeObjects = numbers[0];
+        cache.objects = numbers[1];
+        cache.objectSize = numbers[2];
+        cache.pagesPerSlab = numbers[4];
+        cache.slabs = numbers[9];
+        cache.bytes = cache.slabs * cache.pagesPerSlab * pageSize;
+        caches.push_back(cache);
+    }
+    return true;
+}
+
+void selectTopSlabs(std::vector<SlabCache> &caches, size_t topCount, SlabScan &scan) {
+    scan.caches = caches.size();
+    scan.bytes = 0;
+    for (const auto &cache : caches)
+        scan.bytes += cache.bytes;
+    const size_t keep = std::min(topCount, caches.size());
+    std::partial_sort(caches.begin(), caches.begin() + keep, caches.end(), byBytesDescending);
+    scan.top.assign(caches.begin(), caches.begin() + keep);
+}
+
+SlabInfoReader::SlabInfoReader(const std::string &path)
+        : fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)}, pageSize{static_cast<uint64_t>(sysconf(_SC_PAGESIZE))},
+          buffer(SLABINFO_INITIAL_SIZE) {
+    if (fd < 0)
+        error = errno;
+}
+
+SlabInfoReader::~SlabInfoReader() {
+    if (fd >= 0)
+        close(fd);
+}
+
+bool SlabInfoReader::read(size_t topCount, SlabScan &scan) {
+    if (fd < 0)
+        return false;
+    size_t length = 0;
+    for (;;) {
+        if (length == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        ssize_t n = pread(fd, buffer.data() + length, buffer.size() - length, static_cast<off_t>(length));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (n == 0)
+            break;
+        length += static_cast<size_t>(n);
+    }
+    if (!parseSlabInfo(buffer.data(), length, pageSize, caches))
+        return false;
+    selectTopSlabs(caches, topCount, scan);
+    return true;
+}
@@ -0,0 +1,125 @@
+#ifndef SUPERFREE_KERNELMEMORY_H
+#define SUPERFREE_KERNELMEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MemInfoParser.h"
+
+/// Kernel memory reported by /proc/meminfo, in kB. It is counted in "used" without
+/// belonging to any process.
+struct KernelBreakdown {
+    uint64_t slabReclaimable = 0;
+    uint64_t slabUnreclaimable = 0;
+    uint64_t kernelStack = 0;
+    /// Page tables of processes, and of the IOMMU and KVM guests (SecPageTables)
+    uint64_t pageTables = 0;
+    uint64_t secPageTables = 0;
+    uint64_t vmalloc = 0;
+    uint64_t percpu = 0;
+    /// The hugetlbfs pools of every page size, used or not
+    uint64_t hugePages = 0;
+    /// Huge pages of the default size allocated to a mapping
+    uint64_t hugePagesUsed = 0;
+
+    uint64_t total() const {
+        return slabReclaimable + slabUnreclaimable + kernelStack + pageTables + secPageTables + vmalloc
+               + percpu + hugePages;
+    }
+};
+
+
+/// Extracts the kernel memory from meminfo
+/// \param data The parsed meminfo values
+/// \return The kernel memory, 0 for the fields missing on older kernels
+KernelBreakdown kernelBreakdown(const MemInfoData &data);
+
+
+/// Maximum length of a slab cache name kept, longer names are truncated
+const size_t SLAB_NAME_SIZE = 32;
+
+/// One line of /proc/slabinfo
+struct SlabCache {
+    char name[SLAB_NAME_SIZE];
+    uint64_t activeObjects;
+    uint64_t objects;
+    /// Size of one object in bytes
+    uint64_t objectSize;
+    uint64_t slabs;
+    uint64_t pagesPerSlab;
+    /// Memory held by the slabs of the cache in bytes, slabs * pagesPerSlab * page size
+    uint64_t bytes;
+};
+
+/// Result of reading /proc/slabinfo
+struct SlabScan {
+    /// The caches holding most memory, sorted by descending bytes
+    std::vector<SlabCache> top;
+    /// Number of caches found
+    size_t caches = 0;
+    /// Memory held by all caches in bytes
+    uint64_t bytes = 0;
+};
+
+
+/// Parses the text of /proc/slabinfo version 2.x in place, in a single pass
+/// \param text Content of the file
+/// \param length Number of bytes of text
+/// \param pageSize Bytes per page
+/// \param caches Receives every cache, cleared first so its capacity is reused
+/// \return False if the header is not slabinfo 2.x
+bool parseSlabInfo(const char *text, size_t length, uint64_t pageSize, std::vector<SlabCache> &caches);
+
+
+/// Keeps the caches holding most memory with a partial sort
+/// \param caches Every cache, reordered
+/// \param topCount Number of caches to keep
+/// \param scan Receives the top caches and the totals
+void selectTopSlabs(std::vector<SlabCache> &caches, size_t topCount, SlabScan &scan);
+
+
+/// Reads /proc/slabinfo, which is only readable by root. The file stays open and the
+/// buffers are reused, so a refresh costs the pread(2) calls and one parse.
+class SlabInfoReader {
+public:
+
+    /// Opens the file, see isOpen()
+    /// \param path Path of slabinfo
+    explicit SlabInfoReader(const std::string &path = "/proc/slabinfo");
+
+    ~SlabInfoReader();
+
+    SlabInfoReader(const SlabInfoReader &) = delete;
+    SlabInfoReader &operator=(const SlabInfoReader &) = delete;
+
+
+    /// Returns true if the file could be opened
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+
+    /// Returns the errno of the failed open, e.g. EACCES without root
+    int openError() const {
+        return error;
+    }
+
+
+    /// Reads the file again
+    /// \param topCount Number of caches to keep
+    /// \param scan Receives the caches holding most memory
+    /// \return False if the file could not be read or parsed
+    bool read(size_t topCount, SlabScan &scan);
+
+private:
+
+    int fd;
+    int error = 0;
+    uint64_t pageSize;
+    /// Content of the file, grown to fit
+    std::vector<char> buffer;
+    std::vector<SlabCache> caches;
+};
+
+#endif //SUPERFREE_KERNELMEMORY_H
@@ -0,0 +1,193 @@
+#ifndef SUPERFREE_MEMINFO_H
+#define SUPERFREE_MEMINFO_H
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "Alert.h"
+#include "MemInfoParser.h"
+#include "Sampler.h"
+#include "Units.h"
+
+class MemInfo {
+private:
+    const std::string pathMeminfo;
+
+    /// Keeps /proc/meminfo open so refresh() only needs a pread(2), and applies the limits
+    /// of the enclosing cgroup when inside a container
+    MemInfoReader reader;
+
+    /// Thresholds of the yellow and red bars
+    AlertRule rule;
+
+    /// Unit of the sizes shown
+    Units units;
+
+    const char *getColor(Percent percent) const {
+        switch (alertLevel(rule, percent.toDouble())) {
+        case AlertLevel::Critical:
+            return "\e[38;5;197m";
+        case AlertLevel::Warning:
+            return "\e[38;5;226m";
+        default:
+            return "\e[38;5;148m"; //green
+        }
+    }
+
+
+public:
+    MemInfoData data;
+    Quantity memTotal;
+    Quantity memFree;
+    Quantity memUsed;
+    Quantity memAvailable;
+    Quantity memBuffers;
+    Quantity memCached;
+    Quantity buffCached;
+    Quantity swapTotal;
+    Quantity swapUsed;
+    Quantity swapFree;
+    Quantity Total;
+    Quantity TotalUsed;
+    Quantity TotalFree;
+
+    enum barOptions {
+        bOption_Invalid,
+        Memory,
+        Swap,
+        Totals,
+    };
+
+    /// \param cgroupAware Report the limits of the enclosing cgroup v2 instead of the host
+    /// \param procRoot Directory holding meminfo, e.g. the proc/ of a captured sosreport
+    explicit MemInfo(bool cgroupAware, const std::string &procRoot = "/proc")
+            : pathMeminfo{procRoot + "/meminfo"}, reader{cgroupAware, pathMeminfo} {
+        refresh();
+    }
+
+    MemInfo(const MemInfo &) = delete;
+    MemInfo &operator=(const MemInfo &) = delete;
+
+    void refresh() {
+        readFile();
+        update();
+    }
+
+    /// Shows recorded values instead of the current ones
+    void load(const MemInfoData &snapshot) {
+        data = snapshot;
+        update();
+    }
+
+    /// Converts the values of data to byte quantities
+    void update() {
+        memTotal = Quantity::fromKiB(data.memTotal);
+        memFree = Quantity::fromKiB(data.memFree);
+        memAvailable = Quantity::fromKiB(memInfoAvailable(data));
+        memBuffers = Quantity::fromKiB(data.buffers);
+        memCached = Quantity::fromKiB(data.cached);
+        swapTotal = Quantity::fromKiB(data.swapTotal);
+        swapFree = Quantity::fromKiB(data.swapFree);
+        memUsed = Quantity::fromKiB(memInfoUsed(data));
+        buffCached = Quantity::fromKiB(memInfoBuffCache(data));
+        swapUsed = swapTotal - swapFree;
+        Total = memTotal + swapTotal;
+        TotalUsed = memUsed + swapUsed;
+        TotalFree = memFree + swapFree;
+    }
+
+    void readFile(){
+        if (!reader.read(data))
+            throw std::runtime_error{"Unable to read " + pathMeminfo};
+    }
+
+    /// Sets the percentages from which the bars are yellow and red
+    void setThresholds(const AlertRule &thresholds) {
+        rule = thresholds;
+    }
+
+    /// Sets the unit of the sizes shown by format()
+    void setUnits(const Units &unitMode) {
+        units = unitMode;
+    }
+
+    const Units &getUnits() const {
+        return units;
+    }
+
+    /// Formats a size in the unit set by setUnits(), e.g. "16324036 KiB"
+    std::string format(Quantity quantity) const {
+        return formatQuantity(quantity, units);
+    }
+
+    /// Returns the used memory percentage, rounded to the tenth shown by the bar
+    double memoryPercent() const {
+        return Percent::of(memUsed, memTotal).toDouble();
+    }
+
+    /// Returns the used swap percentage, 0 without swap
+    double swapPercent() const {
+        return Percent::of(swapUsed, swapTotal).toDouble();
+    }
+
+    /// Returns the path of the cgroup whose limits are shown, empty for the host
+    std::string cgroupPath() const {
+        return reader.cgroupPath();
+    }
+
+    std::string printBar(){
+        return " ";
+    }
+
+    void printData(){
+        std::cout << "MemTotal: " << format(memTotal) << std::endl;
+        std::cout << "MemUsed: " << format(memUsed) << std::endl;
+        std::cout << "MemFree: " << format(memFree) << std::endl;
+        std::cout << "MemAvailable: " << format(memAvailable) << std::endl;
+        std::cout << "Buffers: " << format(memBuffers) << std::endl;
+        std::cout << "Cached: " << format(memCached) << std::endl;
+        std::cout << "BuffCached: " << format(buffCached) << std::endl;
+        std::cout << "SwapTotal: " << format(swapTotal) << std::endl;
+        std::cout << "SwapUsed: " << format(swapUsed) << std::endl;
+        std::cout << "SwapFree: " << format(swapFree) << std::endl;
+    }
+
+    /// Returns a colored bar of 22 cells and the percentage with one decimal
+    std::string genericPrintBar(Quantity used, Quantity total) const {
+        const Percent percent = Percent::of(used, total);
+        const unsigned int cells = std::min(percent.cells(22), 22u);
+        char text[12];
+        const size_t length = formatPercent(text, percent);
+        std::string result;
+        result.reserve(48);
+        result += getColor(percent);
+        result += '[';
+        result.append(cells, '#');
+        result.append(22 - cells, '.');
+        result += "] ";
+        result.append(text, length);
+        result += " %\e[0m";
+        return result;
+    }
+
+    std::string printBar(int type){
+        std::string result = "";
+        switch(type){
+        case Memory:
+            return genericPrintBar(memUsed, memTotal);
+            break;
+        case Swap:
+            return genericPrintBar(swapUsed, swapTotal);
+            break;
+        case Totals:
+            return genericPrintBar(TotalUsed, Total);
+        default:
+            return result;
+        }
+        return result;
+    }
+
+};
+
+#endif //SUPERFREE_MEMINFO_H
@@ -0,0 +1,224 @@
+#include "MemInfoParser.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+struct FieldInfo {
+    const char *key;
+    size_t length;
+    size_t offset;
+    MemInfoUnit unit;
+};
+
+constexpr FieldInfo FIELDS[] = {
+#define SUPERFREE_MEMINFO_INFO(key, member, unit) \
+    {key, sizeof(key) - 1, offsetof(MemInfoData, member), MemInfoUnit::unit},
+    SUPERFREE_MEMINFO_FIELDS(SUPERFREE_MEMINFO_INFO)
+#undef SUPERFREE_MEMINFO_INFO
+};
+
+static_assert(sizeof(FIELDS) / sizeof(FIELDS[0]) == MEMINFO_FIELD_COUNT, "Field table out of sync");
+
+/// Number of slots of the perfect hash table, a power of two
+constexpr size_t TABLE_SIZE = 512;
+
+/// Marks an empty slot of the perfect hash table
+constexpr uint8_t EMPTY_SLOT = 0xFF;
+
+static_assert(MEMINFO_FIELD_COUNT < EMPTY_SLOT, "Too many fields for uint8_t slots");
+
+constexpr uint32_t hashKey(const char *key, size_t length, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+struct KeyTable {
+    uint32_t seed;
+    uint8_t slots[TABLE_SIZE];
+};
+
+/// Searches a seed that maps every known key to a different slot
+constexpr KeyTable buildKeyTable() {
+    KeyTable table{0, {}};
+    for (uint32_t seed = 1; seed < 100000; seed++) {
+        for (size_t i = 0; i < TABLE_SIZE; i++)
+            table.slots[i] = EMPTY_SLOT;
+        bool collision = false;
+        for (size_t i = 0; i < MEMINFO_FIELD_COUNT && !collision; i++) {
+            size_t slot = hashKey(FIELDS[i].key, FIELDS[i].length, seed) & (TABLE_SIZE - 1);
+            if (table.slots[slot] != EMPTY_SLOT)
+                collision = true;
+            else
+                table.slots[slot] = static_cast<uint8_t>(i);
+        }
+        if (!collision) {
+            table.seed = seed;
+            return table;
+        }
+    }
+    return table;
+}
+
+constexpr KeyTable KEY_TABLE = buildKeyTable();
+
+static_assert(KEY_TABLE.seed != 0, "No perfect hash seed found for the meminfo keys");
+
+uint64_t &fieldRef(MemInfoData &data, size_t index) {
+    return *reinterpret_cast<uint64_t *>(reinterpret_cast<char *>(&data) + FIELDS[index].offset);
+}
+
+void resetData(MemInfoData &data) {
+#define SUPERFREE_MEMINFO_RESET(key, member, unit) data.member = 0;
+    SUPERFREE_MEMINFO_FIELDS(SUPERFREE_MEMINFO_RESET)
+#undef SUPERFREE_MEMINFO_RESET
+    data.present.reset();
+    data.extraCount = 0;
+}
+
+void addExtra(MemInfoData &data, const char *key, size_t length, uint64_t value, MemInfoUnit unit) {
+    if (data.extraCount == MEMINFO_MAX_EXTRA)
+        return;
+    MemInfoExtra &extra = data.extra[data.extraCount++];
+    if (length >= MEMINFO_EXTRA_KEY_SIZE)
+        length = MEMINFO_EXTRA_KEY_SIZE - 1;
+    std::memcpy(extra.key, key, length);
+    extra.key[length] = '\0';
+    extra.value = value;
+    extra.unit = unit;
+}
+
+/// Stores one value in its field, or in data.extra for unknown keys
+/// \return True if the key is a known field
+bool storeValue(MemInfoData &data, const char *key, size_t length, uint64_t value, bool hasKbUnit) {
+    MemInfoField field;
+    if (!resolveMemInfoKey(key, length, field)) {
+        addExtra(data, key, length, value, hasKbUnit ? MemInfoUnit::KiB : MemInfoUnit::Pages);
+        return false;
+    }
+    size_t index = static_cast<size_t>(field);
+    fieldRef(data, index) = value;
+    data.present.set(index);
+    return true;
+}
+
+}
+
+uint64_t MemInfoData::get(MemInfoField field) const {
+    size_t index = static_cast<size_t>(field);
+    return *reinterpret_cast<const uint64_t *>(reinterpret_cast<const char *>(this) + FIELDS[index].offset);
+}
+
+void MemInfoData::set(MemInfoField field, uint64_t value) {
+    size_t index = static_cast<size_t>(field);
+    fieldRef(*this, index) = value;
+    present.set(index);
+}
+
+const char *memInfoKey(MemInfoField field) {
+    return FIELDS[static_cast<size_t>(field)].key;
+}
+
+MemInfoUnit memInfoUnit(MemInfoField field) {
+    return FIELDS[static_cast<size_t>(field)].unit;
+}
+
+bool resolveMemInfoKey(const char *key, size_t length, MemInfoField &field) {
+    uint8_t index = KEY_TABLE.slots[hashKey(key, length, KEY_TABLE.seed) & (TABLE_SIZE - 1)];
+    if (index == EMPTY_SLOT || FIELDS[index].length != length
+            || std::memcmp(FIELDS[index].key, key, length) != 0)
+        return false;
+    field = static_cast<MemInfoField>(index);
+    return true;
+}
+
+uint64_t memInfoAvailable(const MemInfoData &data) {
+    if (!data.has(MemInfoField::memAvailable))
+        return data.memFree;
+    return data.memAvailable;
+}
+
+uint64_t memInfoBuffCache(const MemInfoData &data) {
+    return data.buffers + data.cached + data.sReclaimable;
+}
+
+uint64_t memInfoUsed(const MemInfoData &data) {
+    uint64_t available = memInfoAvailable(data);
+    if (available <= data.memTotal)
+        return data.memTotal - available;
+    uint64_t notUsed = data.memFree + memInfoBuffCache(data);
+    return notUsed <= data.memTotal ? data.memTotal - notUsed : 0;
+}
+
+size_t parseMemInfo(const char *buffer, size_t length, MemInfoData &data) {
+    resetData(data);
+    size_t found = 0;
+    scanKeyValues(buffer, length, [&](const char *key, size_t keyLength, uint64_t value, bool hasKbUnit) {
+        found += storeValue(data, key, keyLength, value, hasKbUnit);
+    });
+    return found;
+}
+
+size_t parseNodeMemInfo(const char *buffer, size_t length, MemInfoData &data) {
+    resetData(data);
+    size_t found = 0;
+    scanKeyValues(buffer, length, [&](const char *key, size_t keyLength, uint64_t value, bool hasKbUnit) {
+        // Skip the "Node <n> " prefix in place
+        if (keyLength > 5 && std::memcmp(key, "Node ", 5) == 0) {
+            const char *space = static_cast<const char *>(std::memchr(key + 5, ' ', keyLength - 5));
+            if (space != nullptr) {
+                keyLength -= space + 1 - key;
+                key = space + 1;
+            }
+        }
+        found += storeValue(data, key, keyLength, value, hasKbUnit);
+    });
+    return found;
+}
+
+bool memInfoExtra(const MemInfoData &data, const char *key, uint64_t &value) {
+    for (size_t i = 0; i < data.extraCount; i++) {
+        if (std::strcmp(data.extra[i].key, key) == 0) {
+            value = data.extra[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readMemInfo(const char *path, MemInfoData &data) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    char buffer[MEMINFO_BUFFER_SIZE];
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (n <= 0)
+        return false;
+    parseMemInfo(buffer, static_cast<size_t>(n), data);
+    return true;
+}
+
+bool preadMemInfo(int fd, MemInfoData &data) {
+    char buffer[MEMINFO_BUFFER_SIZE];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    parseMemInfo(buffer, static_cast<size_t>(n), data);
+    return true;
+}
+
+bool preadNodeMemInfo(int fd, MemInfoData &data) {
+    char buffer[MEMINFO_BUFFER_SIZE];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    parseNodeMemInfo(buffer, static_cast<size_t>(n), data);
+    return true;
+}
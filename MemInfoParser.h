@@ -0,0 +1,272 @@
+#ifndef SUPERFREE_MEMINFOPARSER_H
+#define SUPERFREE_MEMINFOPARSER_H
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// Size of the stack buffer used to read /proc/meminfo in one read(2)
+const size_t MEMINFO_BUFFER_SIZE = 8192;
+
+/// Unit of a meminfo value as printed by the kernel
+enum class MemInfoUnit : uint8_t {
+    KiB,
+    Pages,
+};
+
+/// Every key known in /proc/meminfo: X(kernel key, member name, unit)
+/// Adding a key here is enough to parse it, the lookup table is built at compile time.
+#define SUPERFREE_MEMINFO_FIELDS(X) \
+    X("MemTotal", memTotal, KiB) \
+    X("MemFree", memFree, KiB) \
+    X("MemAvailable", memAvailable, KiB) \
+    X("Buffers", buffers, KiB) \
+    X("Cached", cached, KiB) \
+    X("SwapCached", swapCached, KiB) \
+    X("Active", active, KiB) \
+    X("Inactive", inactive, KiB) \
+    X("Active(anon)", activeAnon, KiB) \
+    X("Inactive(anon)", inactiveAnon, KiB) \
+    X("Active(file)", activeFile, KiB) \
+    X("Inactive(file)", inactiveFile, KiB) \
+    X("Unevictable", unevictable, KiB) \
+    X("Mlocked", mlocked, KiB) \
+    X("HighTotal", highTotal, KiB) \
+    X("HighFree", highFree, KiB) \
+    X("LowTotal", lowTotal, KiB) \
+    X("LowFree", lowFree, KiB) \
+    X("MmapCopy", mmapCopy, KiB) \
+    X("SwapTotal", swapTotal, KiB) \
+    X("SwapFree", swapFree, KiB) \
+    X("Zswap", zswap, KiB) \
+    X("Zswapped", zswapped, KiB) \
+    X("Dirty", dirty, KiB) \
+    X("Writeback", writeback, KiB) \
+    X("AnonPages", anonPages, KiB) \
+    X("Mapped", mapped, KiB) \
+    X("Shmem", shmem, KiB) \
+    X("KReclaimable", kReclaimable, KiB) \
+    X("Slab", slab, KiB) \
+    X("SReclaimable", sReclaimable, KiB) \
+    X("SUnreclaim", sUnreclaim, KiB) \
+    X("KernelStack", kernelStack, KiB) \
+    X("ShadowCallStack", shadowCallStack, KiB) \
+    X("PageTables", pageTables, KiB) \
+    X("SecPageTables", secPageTables, KiB) \
+    X("NFS_Unstable", nfsUnstable, KiB) \
+    X("Bounce", bounce, KiB) \
+    X("WritebackTmp", writebackTmp, KiB) \
+    X("CommitLimit", commitLimit, KiB) \
+    X("Committed_AS", committedAS, KiB) \
+    X("VmallocTotal", vmallocTotal, KiB) \
+    X("VmallocUsed", vmallocUsed, KiB) \
+    X("VmallocChunk", vmallocChunk, KiB) \
+    X("Percpu", percpu, KiB) \
+    X("HardwareCorrupted", hardwareCorrupted, KiB) \
+    X("AnonHugePages", anonHugePages, KiB) \
+    X("ShmemHugePages", shmemHugePages, KiB) \
+    X("ShmemPmdMapped", shmemPmdMapped, KiB) \
+    X("FileHugePages", fileHugePages, KiB) \
+    X("FilePmdMapped", filePmdMapped, KiB) \
+    X("CmaTotal", cmaTotal, KiB) \
+    X("CmaFree", cmaFree, KiB) \
+    X("Unaccepted", unaccepted, KiB) \
+    X("Balloon", balloon, KiB) \
+    X("HugePages_Total", hugePagesTotal, Pages) \
+    X("HugePages_Free", hugePagesFree, Pages) \
+    X("HugePages_Rsvd", hugePagesRsvd, Pages) \
+    X("HugePages_Surp", hugePagesSurp, Pages) \
+    X("Hugepagesize", hugepageSize, KiB) \
+    X("Hugetlb", hugetlb, KiB) \
+    X("DirectMap4k", directMap4k, KiB) \
+    X("DirectMap2M", directMap2M, KiB) \
+    X("DirectMap4M", directMap4M, KiB) \
+    X("DirectMap1G", directMap1G, KiB)
+
+/// Index of every known meminfo key
+enum class MemInfoField : uint8_t {
+#define SUPERFREE_MEMINFO_ENUM(key, member, unit) member,
+    SUPERFREE_MEMINFO_FIELDS(SUPERFREE_MEMINFO_ENUM)
+#undef SUPERFREE_MEMINFO_ENUM
+};
+
+/// Number of known meminfo keys
+const size_t MEMINFO_FIELD_COUNT = 0
+#define SUPERFREE_MEMINFO_COUNT(key, member, unit) + 1
+    SUPERFREE_MEMINFO_FIELDS(SUPERFREE_MEMINFO_COUNT);
+#undef SUPERFREE_MEMINFO_COUNT
+
+/// Maximum number of keys not present in SUPERFREE_MEMINFO_FIELDS that are kept
+const size_t MEMINFO_MAX_EXTRA = 16;
+
+/// Maximum length of a key not present in SUPERFREE_MEMINFO_FIELDS, longer keys are truncated
+const size_t MEMINFO_EXTRA_KEY_SIZE = 32;
+
+/// A key of meminfo that superfree does not know, carried through as is
+struct MemInfoExtra {
+    char key[MEMINFO_EXTRA_KEY_SIZE];
+    uint64_t value;
+    MemInfoUnit unit;
+};
+
+/// Values read from /proc/meminfo, in kB except HugePages_* that are page counts
+struct MemInfoData {
+#define SUPERFREE_MEMINFO_MEMBER(key, member, unit) uint64_t member;
+    SUPERFREE_MEMINFO_FIELDS(SUPERFREE_MEMINFO_MEMBER)
+#undef SUPERFREE_MEMINFO_MEMBER
+
+    /// Fields found in the last parse
+    std::bitset<MEMINFO_FIELD_COUNT> present;
+
+    /// Keys found in the last parse that are not known fields
+    MemInfoExtra extra[MEMINFO_MAX_EXTRA];
+    size_t extraCount;
+
+    /// Returns the value of a field by index
+    uint64_t get(MemInfoField field) const;
+
+    /// Sets the value of a field by index and marks it present
+    void set(MemInfoField field, uint64_t value);
+
+    /// Returns true if the kernel reported the field
+    bool has(MemInfoField field) const {
+        return present.test(static_cast<size_t>(field));
+    }
+};
+
+
+/// Returns the kernel key of a field, e.g. "Active(anon)"
+const char *memInfoKey(MemInfoField field);
+
+/// Returns the unit of a field
+MemInfoUnit memInfoUnit(MemInfoField field);
+
+/// Resolves a kernel key to its field using the compile-time perfect hash
+/// \param key Key text, not null terminated
+/// \param length Length of the key
+/// \param field Receives the field if found
+/// \return True if the key is known, otherwise false
+bool resolveMemInfoKey(const char *key, size_t length, MemInfoField &field);
+
+
+/// Available memory, MemFree when the kernel does not report MemAvailable
+uint64_t memInfoAvailable(const MemInfoData &data);
+
+/// Buffers/cache as procps free computes it: Buffers + Cached + SReclaimable
+uint64_t memInfoBuffCache(const MemInfoData &data);
+
+/// Used memory as procps free computes it: MemTotal - MemAvailable,
+/// or MemTotal - MemFree - buff/cache when that would be negative
+uint64_t memInfoUsed(const MemInfoData &data);
+
+
+/// Scans "Key:   value kB" lines in place, as found in meminfo, smaps_rollup or status files.
+/// Lines without a colon end the scan; lines whose value is not a number get 0.
+/// \param buffer Text of the file
+/// \param length Number of bytes in buffer
+/// \param callback Called as callback(key, keyLength, value, hasKbUnit) for every line
+template <typename F>
+void scanKeyValues(const char *buffer, size_t length, F callback) {
+    const char *pos = buffer;
+    const char *end = buffer + length;
+    while (pos < end) {
+        const char *key = pos;
+        const char *colon = static_cast<const char *>(std::memchr(pos, ':', end - pos));
+        if (colon == nullptr)
+            break;
+        pos = colon + 1;
+        while (pos < end && *pos == ' ')
+            pos++;
+        uint64_t value = 0;
+        while (pos < end && static_cast<unsigned char>(*pos - '0') < 10) {
+            value = value * 10 + (*pos - '0');
+            pos++;
+        }
+        bool hasKbUnit = pos + 1 < end && *pos == ' ' && pos[1] == 'k';
+        callback(key, static_cast<size_t>(colon - key), value, hasKbUnit);
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (newline == nullptr)
+            break;
+        pos = newline + 1;
+    }
+}
+
+
+/// Scans "key value" lines in place, as found in /proc/vmstat or cgroup memory.stat files
+/// \param buffer Text of the file
+/// \param length Number of bytes in buffer
+/// \param callback Called as callback(key, keyLength, value) for every line
+template <typename F>
+void scanSpaceKeyValues(const char *buffer, size_t length, F callback) {
+    const char *pos = buffer;
+    const char *end = buffer + length;
+    while (pos < end) {
+        const char *key = pos;
+        while (pos < end && *pos != ' ' && *pos != '\n')
+            pos++;
+        size_t keyLength = pos - key;
+        while (pos < end && *pos == ' ')
+            pos++;
+        uint64_t value = 0;
+        while (pos < end && static_cast<unsigned char>(*pos - '0') < 10) {
+            value = value * 10 + (*pos - '0');
+            pos++;
+        }
+        if (keyLength > 0)
+            callback(key, keyLength, value);
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (newline == nullptr)
+            break;
+        pos = newline + 1;
+    }
+}
+
+
+/// Parses the contents of /proc/meminfo in place, without allocating
+/// \param buffer Text of the file
+/// \param length Number of bytes in buffer
+/// \param data Struct that receives the values, unknown keys go to data.extra
+/// \return Number of lines recognized
+size_t parseMemInfo(const char *buffer, size_t length, MemInfoData &data);
+
+
+/// Parses a per-node meminfo file of /sys/devices/system/node/node<n>/meminfo in place.
+/// The "Node <n> " prefix of every line is skipped, keys that only exist per node such as
+/// MemUsed and FilePages go to data.extra.
+/// \param buffer Text of the file
+/// \param length Number of bytes in buffer
+/// \param data Struct that receives the values
+/// \return Number of lines recognized
+size_t parseNodeMemInfo(const char *buffer, size_t length, MemInfoData &data);
+
+
+/// Looks up a key that is not a known field in data.extra
+/// \param data The parsed values
+/// \param key Kernel key, e.g. "FilePages"
+/// \param value Receives the value if found
+/// \return True if the key was found, otherwise false
+bool memInfoExtra(const MemInfoData &data, const char *key, uint64_t &value);
+
+
+/// Reads a meminfo file with a single read(2) into a stack buffer and parses it
+/// \param path Path of the file, usually /proc/meminfo
+/// \param data Struct that receives the values
+/// \return True if the file could be read, otherwise false
+bool readMemInfo(const char *path, MemInfoData &data);
+
+
+/// Reads an already open meminfo file again with pread(2) at offset 0 and parses it
+/// \param fd Descriptor of the open file, kept open for the next refresh
+/// \param data Struct that receives the values
+/// \return True if the file could be read, otherwise false
+bool preadMemInfo(int fd, MemInfoData &data);
+
+
+/// Reads an already open per-node meminfo file again with pread(2), see parseNodeMemInfo()
+/// \param fd Descriptor of the open file, kept open for the next refresh
+/// \param data Struct that receives the values
+/// \return True if the file could be read, otherwise false
+bool preadNodeMemInfo(int fd, MemInfoData &data);
+
+#endif //SUPERFREE_MEMINFOPARSER_H
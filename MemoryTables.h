@@ -0,0 +1,207 @@
+#ifndef SUPERFREE_MEMORYTABLES_H
+#define SUPERFREE_MEMORYTABLES_H
+
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ConsoleTable.h"
+#include "Forecast.h"
+#include "MemInfo.h"
+#include "Pressure.h"
+#include "VmStat.h"
+
+/// Sets a row of a table, adding it the first time
+inline void setRow(ConsoleTable &table, unsigned int index, std::initializer_list<std::string> row) {
+    if (table.rowCount() <= index) {
+        table += row;
+        return;
+    }
+    unsigned int column = 0;
+    for (const auto &cell : row)
+        table.updateRow(index, column++, cell);
+}
+
+/// Sets the only row of a table, adding it the first time
+inline void setRow(ConsoleTable &table, std::initializer_list<std::string> row) {
+    setRow(table, 0, row);
+}
+
+/// Sets the only row of a table whose columns depend on the options
+inline void setRow(ConsoleTable &table, const std::vector<std::string> &row) {
+    if (table.rowCount() == 0) {
+        table.addRow(row);
+        return;
+    }
+    for (unsigned int column = 0; column < row.size(); ++column)
+        table.updateRow(0, column, row[column]);
+}
+
+/// The Memory, Swap and Totals tables printed by superfree, plus the Activity table
+/// of /proc/vmstat rates and the time to exhaustion when repeating, and the Pressure
+/// table with --psi
+struct MemoryTables {
+    ConsoleTable tableMemory;
+    ConsoleTable tableSwap;
+    ConsoleTable tableTotals{"TOTAL", "USED", "FREE", "USE%"};
+    ConsoleTable tableActivity{"FAULTS", "MAJOR FAULTS", "SWAP IN", "SWAP OUT",
+                               "SCANNED", "DIRECT SCAN", "RECLAIMED", "OOM KILLS"};
+    ConsoleTable tablePressure{"STALLED", "AVG10", "AVG60", "AVG300", "TOTAL"};
+
+    /// Shows tableActivity, only when the vmstat counters could be opened
+    bool activity = false;
+    VmStatReader vmstat;
+    VmStatData vmstatSample[2];
+    /// Number of samples read so far
+    unsigned long vmstatSamples = 0;
+
+    /// Shows tablePressure when set
+    const PressureTrigger *pressure = nullptr;
+
+    /// Adds an EXHAUSTED IN column to tableMemory and tableSwap when set
+    const ExhaustionForecast *forecast;
+    /// Cells of tableMemory and tableSwap, kept so a refresh reuses them
+    std::vector<std::string> memoryRow;
+    std::vector<std::string> swapRow;
+
+    /// \param forecast Forecast fed with every refresh, shown next to the bars of memory and
+    /// swap when set, must outlive the tables
+    explicit MemoryTables(const ExhaustionForecast *forecast = nullptr)
+            : tableMemory(forecast != nullptr
+                          ? ConsoleTable::Headers{"TOTAL", "USED", "FREE", "BUF/CACHE", "AVAILABLE", "USE%",
+                                                  "EXHAUSTED IN"}
+                          : ConsoleTable::Headers{"TOTAL", "USED", "FREE", "BUF/CACHE", "AVAILABLE", "USE%"}),
+              tableSwap(forecast != nullptr ? ConsoleTable::Headers{"TOTAL", "USED", "FREE", "USE%", "EXHAUSTED IN"}
+                                            : ConsoleTable::Headers{"TOTAL", "USED", "FREE", "USE%"}),
+              forecast{forecast} {
+        tableMemory.setPadding(1);
+        tableMemory.setStyle(4);
+        tableMemory.setTittle("Memory");
+        tableSwap.setPadding(1);
+        tableSwap.setStyle(4);
+        tableSwap.setTittle("Swap");
+        tableTotals.setPadding(1);
+        tableTotals.setStyle(4);
+        tableTotals.setTittle("Totals");
+        tableActivity.setPadding(1);
+        tableActivity.setStyle(4);
+        tableActivity.setTittle("Activity (per second, OOM kills since the last refresh)");
+        tablePressure.setPadding(1);
+        tablePressure.setStyle(4);
+    }
+
+    /// Adds the Activity table, rates need two samples so it is only useful when repeating
+    /// \param procRoot Directory holding vmstat
+    void enableActivity(const std::string &procRoot = "/proc") {
+        activity = vmstat.open((procRoot + "/vmstat").c_str());
+    }
+
+    void update(MemInfo &info) {
+        memoryRow.resize(forecast != nullptr ? 7 : 6);
+        memoryRow[0] = "\e[38;5;75m" + info.format(info.memTotal) + "\e[0m";
+        memoryRow[1] = info.format(info.memUsed);
+        memoryRow[2] = info.format(info.memFree);
+        memoryRow[3] = info.format(info.buffCached);
+        memoryRow[4] = info.format(info.memAvailable);
+        memoryRow[5] = info.printBar(1);
+        swapRow.resize(forecast != nullptr ? 5 : 4);
+        swapRow[0] = "\e[38;5;75m" + info.format(info.swapTotal) + "\e[0m";
+        swapRow[1] = info.format(info.swapUsed);
+        swapRow[2] = info.format(info.swapFree);
+        swapRow[3] = info.printBar(2);
+        if (forecast != nullptr) {
+            memoryRow[6] = formatExhaustion(forecast->memory());
+            swapRow[4] = formatExhaustion(forecast->swap());
+        }
+        setRow(tableMemory, memoryRow);
+        setRow(tableSwap, swapRow);
+
+        setRow(tableTotals, {"\e[38;5;75m" + info.format(info.Total) + "\e[0m",
+                info.format(info.TotalUsed),
+                info.format(info.TotalFree),
+                info.printBar(3)});
+
+        if (activity)
+            updateActivity();
+        if (pressure != nullptr)
+            updatePressure();
+    }
+
+    void updatePressure() {
+        PressureData data;
+        if (!pressure->read(data))
+            return;
+        tablePressure.setTittle(pressure->lastEvent() == PressureEvent::Triggered
+                                ? "Memory pressure (\e[38;5;197mtrigger fired\e[0m)"
+                                : "Memory pressure (heartbeat)");
+        // The averages have two decimals, shown with one as every other percentage
+        auto percent = [](double value) {
+            char text[16];
+            const size_t length = formatPercent(text, Percent::of(static_cast<uint64_t>(value * 100 + 0.5), 10000));
+            return std::string(text, length) + " %";
+        };
+        setRow(tablePressure, 0, {"some", percent(data.some.avg10), percent(data.some.avg60),
+                percent(data.some.avg300), std::to_string(data.some.total) + " us"});
+        if (data.hasFull)
+            setRow(tablePressure, 1, {"full", percent(data.full.avg10), percent(data.full.avg60),
+                    percent(data.full.avg300), std::to_string(data.full.total) + " us"});
+    }
+
+    void updateActivity() {
+        VmStatData &current = vmstatSample[vmstatSamples % 2];
+        if (!vmstat.read(current))
+            return;
+        vmstatSamples++;
+        setActivity(vmstatSamples > 1 ? &vmstatSample[vmstatSamples % 2] : nullptr, current);
+    }
+
+    /// Shows the rates between two samples, or dashes without a previous sample
+    void setActivity(const VmStatData *previous, const VmStatData &current) {
+        if (previous == nullptr) {
+            setRow(tableActivity, {"-", "-", "-", "-", "-", "-", "-", "-"});
+            return;
+        }
+        const VmStatRates rates = vmStatRates(*previous, current);
+        auto rate = [](double value) { return std::to_string(static_cast<uint64_t>(value + 0.5)); };
+        setRow(tableActivity, {rate(rates.pgfault),
+                rates.pgmajfault > 0 ? "\e[38;5;226m" + rate(rates.pgmajfault) + "\e[0m" : "0",
+                rate(rates.pswpin),
+                rate(rates.pswpout),
+                rate(rates.pgscan),
+                rates.pgscanDirect > 0 ? "\e[38;5;197m" + rate(rates.pgscanDirect) + "\e[0m" : "0",
+                rate(rates.pgsteal),
+                rates.oomKill > 0 ? "\e[38;5;197m" + std::to_string(rates.oomKill) + "\e[0m" : "0"});
+    }
+
+    void print(std::ostream &out) const {
+        out << tableMemory;
+        out << tableSwap;
+        out << tableTotals;
+        if (activity)
+            out << tableActivity;
+        if (pressure != nullptr)
+            out << tablePressure;
+    }
+
+    /// Updates the tables already on screen, leaving the cursor below them
+    void redraw(std::ostream &out) {
+        unsigned int row = 1;
+        tableMemory.redraw(out, row);
+        row += tableMemory.lineCount();
+        tableSwap.redraw(out, row);
+        row += tableSwap.lineCount();
+        tableTotals.redraw(out, row);
+        row += tableTotals.lineCount();
+        if (activity) {
+            tableActivity.redraw(out, row);
+            row += tableActivity.lineCount();
+        }
+        if (pressure != nullptr) {
+            tablePressure.redraw(out, row);
+            row += tablePressure.lineCount();
+        }
+        out << "\e[" << row << ";1H";
+    }
+};
+
+#endif //SUPERFREE_MEMORYTABLES_H
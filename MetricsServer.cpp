@@ -0,0 +1,480 @@
+#include "MetricsServer.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "OutputWriter.h"
+#include "Pressure.h"
+#include "VmStat.h"
+
+namespace {
+
+/// Largest request accepted, headers included
+const size_t MAX_REQUEST_SIZE = 8192;
+
+/// Connections beyond this are closed as soon as they are accepted
+const size_t MAX_CONNECTIONS = 256;
+
+/// Connections without activity for this long are closed
+const uint64_t IDLE_TIMEOUT_MS = 30000;
+
+uint64_t monotonicMs() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+void appendHeader(OutputBuffer &out, const char *name, const char *type, const char *help) {
+    out.append("# TYPE ");
+    out.append(name);
+    out.append(' ');
+    out.append(type);
+    out.append("\n# HELP ");
+    out.append(name);
+    out.append(' ');
+    out.append(help);
+    out.append('\n');
+}
+
+/// Appends a label value, escaping backslashes, double quotes and line feeds
+void appendLabelValue(OutputBuffer &out, const char *text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\\' || text[i] == '"')
+            out.append('\\');
+        if (text[i] == '\n') {
+            out.append("\\n");
+            continue;
+        }
+        out.append(text[i]);
+    }
+}
+
+void appendSample(OutputBuffer &out, const char *name, const char *label, const char *value, size_t valueLength,
+                  uint64_t sample) {
+    out.append(name);
+    out.append('{');
+    out.append(label);
+    out.append("=\"");
+    appendLabelValue(out, value, valueLength);
+    out.append("\"} ");
+    out.appendUint(sample);
+    out.append('\n');
+}
+
+void appendDouble(OutputBuffer &out, double value) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.6g", value);
+    out.append(text, static_cast<size_t>(length));
+}
+
+/// Every line of /proc/vmstat: nr_* are current counts, the others event counters
+void appendVmStat(OutputBuffer &out, const char *buffer, size_t length) {
+    appendHeader(out, "superfree_vmstat", "gauge", "Current counts of /proc/vmstat (nr_*).");
+    scanSpaceKeyValues(buffer, length, [&](const char *key, size_t keyLength, uint64_t value) {
+        if (keyLength > 3 && std::memcmp(key, "nr_", 3) == 0)
+            appendSample(out, "superfree_vmstat", "field", key, keyLength, value);
+    });
+    appendHeader(out, "superfree_vmstat_events", "counter", "Event counters of /proc/vmstat.");
+    scanSpaceKeyValues(buffer, length, [&](const char *key, size_t keyLength, uint64_t value) {
+        if (keyLength <= 3 || std::memcmp(key, "nr_", 3) != 0)
+            appendSample(out, "superfree_vmstat_events_total", "field", key, keyLength, value);
+    });
+}
+
+void appendPressure(OutputBuffer &out, const PressureData &data) {
+    appendHeader(out, "superfree_pressure_stall_seconds", "counter",
+                 "Time tasks stalled on memory since boot, from /proc/pressure/memory.");
+    out.append("superfree_pressure_stall_seconds_total{kind=\"some\"} ");
+    appendDouble(out, data.some.total / 1e6);
+    out.append('\n');
+    if (data.hasFull) {
+        out.append("superfree_pressure_stall_seconds_total{kind=\"full\"} ");
+        appendDouble(out, data.full.total / 1e6);
+        out.append('\n');
+    }
+    appendHeader(out, "superfree_pressure_ratio", "gauge",
+                 "Share of time tasks stalled on memory over 10, 60 and 300 seconds.");
+    const PressureLine *lines[] = {&data.some, data.hasFull ? &data.full : nullptr};
+    const char *kinds[] = {"some", "full"};
+    for (size_t i = 0; i < 2; i++) {
+        if (lines[i] == nullptr)
+            continue;
+        const double averages[] = {lines[i]->avg10, lines[i]->avg60, lines[i]->avg300};
+        const char *windows[] = {"10", "60", "300"};
+        for (size_t j = 0; j < 3; j++) {
+            out.append("superfree_pressure_ratio{kind=\"");
+            out.append(kinds[i]);
+            out.append("\",window=\"");
+            out.append(windows[j]);
+            out.append("s\"} ");
+            appendDouble(out, averages[j] / 100);
+            out.append('\n');
+        }
+    }
+}
+
+void appendCgroups(OutputBuffer &out, const std::vector<CgroupMemory> &cgroups) {
+    appendHeader(out, "superfree_cgroup_memory_bytes", "gauge",
+                 "Memory of every cgroup v2 with the memory controller, from memory.current, memory.max, "
+                 "memory.stat and memory.swap.current.");
+    for (const auto &cgroup : cgroups) {
+        if (!cgroup.hasMemory)
+            continue;
+        const std::string path = "/" + cgroup.path;
+        const std::pair<const char *, uint64_t> states[] = {
+            {"current", cgroup.current}, {"max", cgroup.max}, {"anon", cgroup.anon}, {"file", cgroup.file},
+            {"shmem", cgroup.shmem}, {"slab", cgroup.slab}, {"swap", cgroup.swapCurrent},
+        };
+        for (const auto &state : states) {
+            if (state.second == CGROUP_UNLIMITED)
+                continue;
+            out.append("superfree_cgroup_memory_bytes{cgroup=\"");
+            appendLabelValue(out, path.data(), path.size());
+            out.append("\",state=\"");
+            out.append(state.first);
+            out.append("\"} ");
+            out.appendUint(state.second);
+            out.append('\n');
+        }
+    }
+}
+
+std::shared_ptr<const std::string> makeResponse(const char *status, const char *contentType, const std::string &body,
+                                                const char *extraHeaders = "") {
+    std::string response = std::string{"HTTP/1.1 "} + status + "\r\nContent-Type: " + contentType
+        + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n" + extraHeaders + "\r\n";
+    response += body;
+    return std::make_shared<const std::string>(std::move(response));
+}
+
+/// Opens a listening socket on "host:port", "[ipv6]:port" or ":port"
+int listenOn(const std::string &address) {
+    const size_t colon = address.rfind(':');
+    if (colon == std::string::npos)
+        throw std::runtime_error{"Invalid listen address " + address + ", expected host:port"};
+    std::string host = address.substr(0, colon);
+    const std::string port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+        host = host.substr(1, host.size() - 2);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo *addresses = nullptr;
+    int result = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses);
+    if (result != 0)
+        throw std::runtime_error{"Invalid listen address " + address + ": " + gai_strerror(result)};
+    int error = 0;
+    int fd = -1;
+    for (addrinfo *entry = addresses; entry != nullptr && fd < 0; entry = entry->ai_next) {
+        fd = socket(entry->ai_family, entry->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, entry->ai_protocol);
+        if (fd < 0) {
+            error = errno;
+            continue;
+        }
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, entry->ai_addr, entry->ai_addrlen) < 0 || listen(fd, SOMAXCONN) < 0) {
+            error = errno;
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0)
+        throw std::runtime_error{"Unable to listen on " + address + ": " + std::strerror(error)};
+    return fd;
+}
+
+}
+
+MetricsCollector::MetricsCollector(bool cgroupAware, const std::string &procRoot)
+        : reader{cgroupAware, procRoot + "/meminfo"} {
+    vmstatFd = open((procRoot + "/vmstat").c_str(), O_RDONLY | O_CLOEXEC);
+    pressureFd = open((procRoot + "/pressure/memory").c_str(), O_RDONLY | O_CLOEXEC);
+    if (procRoot != "/proc")
+        return;
+    const std::string root = findCgroup2Root();
+    if (!root.empty())
+        cgroups.reset(new CgroupScanner{root});
+}
+
+MetricsCollector::~MetricsCollector() {
+    if (vmstatFd >= 0)
+        close(vmstatFd);
+    if (pressureFd >= 0)
+        close(pressureFd);
+}
+
+void MetricsCollector::collect(std::string &body) {
+    collections++;
+    OutputBuffer out(body);
+    MemInfoData data;
+    if (reader.read(data))
+        writePrometheus(out, data);
+
+    if (vmstatFd >= 0) {
+        char buffer[VMSTAT_BUFFER_SIZE];
+        ssize_t n = pread(vmstatFd, buffer, sizeof(buffer), 0);
+        if (n > 0)
+            appendVmStat(out, buffer, static_cast<size_t>(n));
+    }
+
+    PressureData pressure;
+    if (pressureFd >= 0 && preadPressure(pressureFd, pressure))
+        appendPressure(out, pressure);
+
+    // One thread: the server is single-threaded and a collection is rare thanks to coalescing
+    if (cgroups != nullptr)
+        appendCgroups(out, cgroups->scan(1));
+
+    appendHeader(out, "superfree_exporter_collections", "counter", "Reads of /proc done to answer scrapes.");
+    out.append("superfree_exporter_collections_total ");
+    out.appendUint(collections);
+    out.append("\n# EOF\n");
+    out.flush();
+}
+
+MetricsServer::MetricsServer(const std::string &address, unsigned int coalesceMs, bool cgroupAware,
+                             const std::string &procRoot)
+        : collector{cgroupAware, procRoot}, coalesceMs{coalesceMs} {
+    listenFd = listenOn(address);
+    sockaddr_storage bound{};
+    socklen_t length = sizeof(bound);
+    getsockname(listenFd, reinterpret_cast<sockaddr *>(&bound), &length);
+    if (bound.ss_family == AF_INET6)
+        boundPort = ntohs(reinterpret_cast<const sockaddr_in6 &>(bound).sin6_port);
+    else
+        boundPort = ntohs(reinterpret_cast<const sockaddr_in &>(bound).sin_port);
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    if (epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0) {
+        int error = errno;
+        ::close(listenFd);
+        if (epollFd >= 0)
+            ::close(epollFd);
+        throw std::runtime_error{std::string{"Unable to set up epoll: "} + std::strerror(error)};
+    }
+}
+
+MetricsServer::~MetricsServer() {
+    for (const auto &entry : connections)
+        ::close(entry.first);
+    ::close(epollFd);
+    ::close(listenFd);
+}
+
+void MetricsServer::run(const volatile sig_atomic_t &stop) {
+    epoll_event events[64];
+    while (!stop) {
+        int n = epoll_wait(epollFd, events, 64, 1000);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error{std::string{"epoll_wait failed: "} + std::strerror(errno)};
+        }
+        for (int i = 0; i < n; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                accept();
+                continue;
+            }
+            auto found = connections.find(fd);
+            if (found == connections.end())
+                continue;
+            Connection &connection = found->second;
+            connection.lastActiveMs = monotonicMs();
+            bool keep = true;
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                keep = false;
+            else if (connection.response != nullptr)
+                keep = send(connection);
+            else
+                keep = receive(connection);
+            if (!keep)
+                close(fd);
+        }
+        closeIdle();
+    }
+}
+
+std::shared_ptr<const std::string> MetricsServer::metricsResponse() {
+    const uint64_t now = monotonicMs();
+    if (cached == nullptr || now - cachedAtMs >= coalesceMs) {
+        std::string body;
+        collector.collect(body);
+        cached = makeResponse("200 OK", OPENMETRICS_CONTENT_TYPE, body);
+        cachedHeaderLength = cached->size() - body.size();
+        cachedAtMs = now;
+    }
+    return cached;
+}
+
+void MetricsServer::accept() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        if (connections.size() >= MAX_CONNECTIONS) {
+            ::close(fd);
+            continue;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        Connection &connection = connections[fd];
+        connection.fd = fd;
+        connection.lastActiveMs = monotonicMs();
+    }
+}
+
+bool MetricsServer::receive(Connection &connection) {
+    char buffer[4096];
+    for (;;) {
+        ssize_t n = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (n == 0)
+            return false;
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        connection.request.append(buffer, static_cast<size_t>(n));
+        if (connection.request.size() > MAX_REQUEST_SIZE)
+            break;
+    }
+    if (answer(connection))
+        return send(connection);
+    if (connection.request.size() > MAX_REQUEST_SIZE) {
+        static const auto tooLarge = makeResponse("431 Request Header Fields Too Large", "text/plain",
+                                                  "Request too large\n");
+        connection.response = tooLarge;
+        connection.sent = 0;
+        connection.end = tooLarge->size();
+        connection.closeAfterResponse = true;
+        return send(connection);
+    }
+    return true;
+}
+
+bool MetricsServer::answer(Connection &connection) {
+    const size_t headerEnd = connection.request.find("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+        return false;
+    static const auto index = makeResponse("200 OK", "text/plain; charset=utf-8",
+                                           "superfree exporter, the metrics are at /metrics\n");
+    static const auto notFound = makeResponse("404 Not Found", "text/plain; charset=utf-8", "Not found\n");
+    static const auto notAllowed = makeResponse("405 Method Not Allowed", "text/plain; charset=utf-8",
+                                                "Only GET and HEAD are supported\n", "Allow: GET, HEAD\r\n");
+
+    const std::string request = connection.request.substr(0, headerEnd);
+    connection.request.erase(0, headerEnd + 4);
+    const size_t lineEnd = request.find("\r\n");
+    const std::string line = request.substr(0, lineEnd);
+    const size_t methodEnd = line.find(' ');
+    const size_t targetEnd = methodEnd == std::string::npos ? std::string::npos : line.find(' ', methodEnd + 1);
+    const std::string method = line.substr(0, methodEnd);
+    std::string target = methodEnd == std::string::npos ? "" : line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    target = target.substr(0, target.find('?'));
+    const bool http10 = targetEnd != std::string::npos && line.compare(targetEnd + 1, std::string::npos, "HTTP/1.0") == 0;
+
+    std::string headers = request.substr(lineEnd == std::string::npos ? request.size() : lineEnd);
+    for (char &c : headers)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    const bool askedClose = headers.find("\r\nconnection: close") != std::string::npos;
+    const bool askedKeepAlive = headers.find("\r\nconnection: keep-alive") != std::string::npos;
+    connection.closeAfterResponse = askedClose || (http10 && !askedKeepAlive);
+
+    const bool head = method == "HEAD";
+    size_t headerLength = 0;
+    if (method != "GET" && !head) {
+        connection.response = notAllowed;
+        connection.closeAfterResponse = true;
+    } else if (target == "/metrics") {
+        connection.response = metricsResponse();
+        headerLength = cachedHeaderLength;
+    } else if (target == "/") {
+        connection.response = index;
+    } else {
+        connection.response = notFound;
+    }
+    if (head && headerLength == 0)
+        headerLength = connection.response->find("\r\n\r\n") + 4;
+    connection.sent = 0;
+    connection.end = head ? headerLength : connection.response->size();
+    return true;
+}
+
+bool MetricsServer::send(Connection &connection) {
+    while (connection.response != nullptr) {
+        while (connection.sent < connection.end) {
+            ssize_t n = ::send(connection.fd, connection.response->data() + connection.sent,
+                               connection.end - connection.sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    return false;
+                if (!connection.waitingWritable) {
+                    epoll_event event{};
+                    event.events = EPOLLOUT;
+                    event.data.fd = connection.fd;
+                    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+                    connection.waitingWritable = true;
+                }
+                return true;
+            }
+            connection.sent += static_cast<size_t>(n);
+        }
+        connection.response.reset();
+        if (connection.closeAfterResponse)
+            return false;
+        // Pipelined requests already received
+        answer(connection);
+    }
+    if (connection.waitingWritable) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = connection.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.waitingWritable = false;
+    }
+    return true;
+}
+
+void MetricsServer::close(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void MetricsServer::closeIdle() {
+    const uint64_t now = monotonicMs();
+    std::vector<int> idle;
+    for (const auto &entry : connections) {
+        if (now - entry.second.lastActiveMs > IDLE_TIMEOUT_MS)
+            idle.push_back(entry.first);
+    }
+    for (int fd : idle)
+        close(fd);
+}
@@ -0,0 +1,147 @@
+#ifndef SUPERFREE_METRICSSERVER_H
+#define SUPERFREE_METRICSSERVER_H
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "CgroupTree.h"
+#include "Sampler.h"
+
+/// Window during which scrapes share one collection when --coalesce is not given
+const unsigned int METRICS_DEFAULT_COALESCE_MS = 1000;
+
+/// Content type of the OpenMetrics text format
+const char *const OPENMETRICS_CONTENT_TYPE = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+
+/// Collects meminfo, vmstat, memory pressure and the cgroup v2 tree as OpenMetrics text
+class MetricsCollector {
+public:
+
+    /// Opens the files read by every collection, throws std::runtime_error if
+    /// meminfo cannot be opened. vmstat, PSI and cgroups are skipped when missing.
+    /// \param cgroupAware Report the limits of the enclosing cgroup v2 instead of the host
+    /// \param procRoot Directory read instead of /proc, e.g. a captured tree. The live
+    /// cgroup tree is only collected with /proc.
+    explicit MetricsCollector(bool cgroupAware, const std::string &procRoot = "/proc");
+
+    ~MetricsCollector();
+
+    MetricsCollector(const MetricsCollector &) = delete;
+    MetricsCollector &operator=(const MetricsCollector &) = delete;
+
+
+    /// Reads every source and serializes it
+    /// \param body Receives the exposition, terminated by "# EOF"
+    void collect(std::string &body);
+
+
+    /// Returns the number of collections so far
+    uint64_t count() const {
+        return collections;
+    }
+
+private:
+
+    MemInfoReader reader;
+    int vmstatFd = -1;
+    int pressureFd = -1;
+    std::unique_ptr<CgroupScanner> cgroups;
+    uint64_t collections = 0;
+};
+
+
+/// A single-threaded epoll HTTP/1.1 server answering GET /metrics. Scrapes arriving within
+/// the coalescing window of a collection get the same pre-serialized response, so any number
+/// of concurrent scrapers costs one read of /proc per window.
+class MetricsServer {
+public:
+
+    /// Binds and listens, throws std::runtime_error on failure
+    /// \param address "host:port", "[ipv6]:port" or ":port" for every interface, port 0 picks one
+    /// \param coalesceMs Milliseconds during which a collection is reused
+    /// \param cgroupAware Report the limits of the enclosing cgroup v2 instead of the host
+    /// \param procRoot Directory read instead of /proc, see MetricsCollector
+    MetricsServer(const std::string &address, unsigned int coalesceMs, bool cgroupAware,
+                  const std::string &procRoot = "/proc");
+
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+
+
+    /// Serves until stop becomes non zero, checked whenever epoll_wait(2) returns
+    /// (on EINTR from a signal handler, or at the latest every second)
+    /// \param stop Flag set by a signal handler or another thread
+    void run(const volatile sig_atomic_t &stop);
+
+
+    /// Returns the port the server listens on
+    uint16_t port() const {
+        return boundPort;
+    }
+
+
+    /// Returns the number of collections so far, one per coalescing window with scrapes
+    uint64_t collections() const {
+        return collector.count();
+    }
+
+private:
+
+    /// One client connection, requests are answered in order
+    struct Connection {
+        int fd = -1;
+        /// Received bytes not yet answered
+        std::string request;
+        /// Response being sent, shared with the cache so a new collection does not free it
+        std::shared_ptr<const std::string> response;
+        size_t sent = 0;
+        size_t end = 0;
+        bool closeAfterResponse = false;
+        /// Registered for EPOLLOUT because the socket buffer was full
+        bool waitingWritable = false;
+        /// CLOCK_MONOTONIC time of the last activity in milliseconds
+        uint64_t lastActiveMs = 0;
+    };
+
+    /// Returns the cached metrics response, collecting again when the window is over
+    std::shared_ptr<const std::string> metricsResponse();
+
+    void accept();
+
+    /// Reads what the client sent and answers the complete requests
+    /// \return False if the connection must be closed
+    bool receive(Connection &connection);
+
+    /// Picks the response to the first complete request of the connection
+    /// \return False if there is no complete request
+    bool answer(Connection &connection);
+
+    /// Sends the pending response
+    /// \return False if the connection must be closed
+    bool send(Connection &connection);
+
+    void close(int fd);
+
+    /// Closes connections idle for longer than the timeout
+    void closeIdle();
+
+    MetricsCollector collector;
+    unsigned int coalesceMs;
+    int listenFd = -1;
+    int epollFd = -1;
+    uint16_t boundPort = 0;
+    std::unordered_map<int, Connection> connections;
+
+    std::shared_ptr<const std::string> cached;
+    /// Length of the headers of cached, HEAD requests only get them
+    size_t cachedHeaderLength = 0;
+    uint64_t cachedAtMs = 0;
+};
+
+#endif //SUPERFREE_METRICSSERVER_H
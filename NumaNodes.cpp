@@ -0,0 +1,99 @@
+#include "NumaNodes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+/// Size of the stack buffer used to read numastat
+const size_t NUMASTAT_BUFFER_SIZE = 512;
+
+#define KEY_IS(literal) (length == sizeof(literal) - 1 && std::memcmp(key, literal, length) == 0)
+
+bool readNumaStat(int fd, NumaNode &node) {
+    char buffer[NUMASTAT_BUFFER_SIZE];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    scanSpaceKeyValues(buffer, static_cast<size_t>(n), [&](const char *key, size_t length, uint64_t value) {
+        if (KEY_IS("numa_hit"))
+            node.numaHit = value;
+        else if (KEY_IS("numa_miss"))
+            node.numaMiss = value;
+        else if (KEY_IS("numa_foreign"))
+            node.numaForeign = value;
+    });
+    return true;
+}
+
+#undef KEY_IS
+
+/// Returns true if name is node<n>, storing n in id
+bool parseNodeName(const char *name, unsigned int &id) {
+    if (std::strncmp(name, "node", 4) != 0 || name[4] == '\0')
+        return false;
+    id = 0;
+    for (const char *c = name + 4; *c; ++c) {
+        if (*c < '0' || *c > '9')
+            return false;
+        id = id * 10 + (*c - '0');
+    }
+    return true;
+}
+
+}
+
+NumaNodes::NumaNodes(const std::string &root) {
+    int rootFd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0)
+        return;
+    int listFd = dup(rootFd);
+    DIR *dir = listFd >= 0 ? fdopendir(listFd) : nullptr;
+    if (dir == nullptr) {
+        if (listFd >= 0)
+            close(listFd);
+        close(rootFd);
+        return;
+    }
+    while (dirent *entry = readdir(dir)) {
+        unsigned int id;
+        if (!parseNodeName(entry->d_name, id))
+            continue;
+        const std::string name = entry->d_name;
+        int meminfoFd = openat(rootFd, (name + "/meminfo").c_str(), O_RDONLY | O_CLOEXEC);
+        if (meminfoFd < 0)
+            continue;
+        int numastatFd = openat(rootFd, (name + "/numastat").c_str(), O_RDONLY | O_CLOEXEC);
+        files.push_back({id, meminfoFd, numastatFd});
+    }
+    closedir(dir);
+    close(rootFd);
+    std::sort(files.begin(), files.end(), [](const NodeFiles &a, const NodeFiles &b) {
+        return a.id < b.id;
+    });
+}
+
+NumaNodes::~NumaNodes() {
+    for (const auto &node : files) {
+        close(node.meminfoFd);
+        if (node.numastatFd >= 0)
+            close(node.numastatFd);
+    }
+}
+
+bool NumaNodes::read(std::vector<NumaNode> &nodes) const {
+    nodes.resize(files.size());
+    bool complete = true;
+    for (size_t i = 0; i < files.size(); ++i) {
+        NumaNode &node = nodes[i];
+        node.id = files[i].id;
+        if (!preadNodeMemInfo(files[i].meminfoFd, node.meminfo))
+            complete = false;
+        if (files[i].numastatFd < 0 || !readNumaStat(files[i].numastatFd, node))
+            complete = false;
+    }
+    return complete;
+}
@@ -0,0 +1,63 @@
+#ifndef SUPERFREE_NUMANODES_H
+#define SUPERFREE_NUMANODES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MemInfoParser.h"
+
+/// Memory and allocation counters of one NUMA node
+struct NumaNode {
+    /// Node number, the n of node<n>
+    unsigned int id = 0;
+    /// Values of node<n>/meminfo in kB, MemUsed and FilePages are in extra
+    MemInfoData meminfo;
+    /// Pages allocated on this node as intended
+    uint64_t numaHit = 0;
+    /// Pages allocated on this node although another node was preferred
+    uint64_t numaMiss = 0;
+    /// Pages intended for this node but allocated on another one
+    uint64_t numaForeign = 0;
+};
+
+
+/// Reads the memory of every NUMA node from /sys/devices/system/node. The meminfo and
+/// numastat files stay open, so a refresh only costs two pread(2) per node.
+class NumaNodes {
+public:
+
+    /// Opens the meminfo and numastat files of every node
+    /// \param root Directory holding the node<n> directories
+    explicit NumaNodes(const std::string &root = "/sys/devices/system/node");
+
+    ~NumaNodes();
+
+    NumaNodes(const NumaNodes &) = delete;
+    NumaNodes &operator=(const NumaNodes &) = delete;
+
+
+    /// Returns the number of nodes found
+    size_t size() const {
+        return files.size();
+    }
+
+
+    /// Reads every node again
+    /// \param nodes Receives one entry per node, sorted by node number
+    /// \return False if a file could not be read
+    bool read(std::vector<NumaNode> &nodes) const;
+
+private:
+
+    /// Open files of one node
+    struct NodeFiles {
+        unsigned int id;
+        int meminfoFd;
+        int numastatFd;
+    };
+
+    std::vector<NodeFiles> files;
+};
+
+#endif //SUPERFREE_NUMANODES_H
@@ -0,0 +1,360 @@
+#include "OutputWriter.h"
+
+#include <cerrno>
+#include <ctime>
+#include <initializer_list>
+#include <unistd.h>
+
+namespace {
+
+const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/// Figures shown by the Memory, Swap and Totals tables
+struct Summary {
+    Quantity memTotal;
+    Quantity memUsed;
+    Quantity memFree;
+    Quantity memShared;
+    Quantity memBuffCache;
+    Quantity memAvailable;
+    Quantity swapTotal;
+    Quantity swapUsed;
+    Quantity swapFree;
+    Quantity total;
+    Quantity totalUsed;
+    Quantity totalFree;
+};
+
+Summary summarize(const MemInfoData &data) {
+    Summary summary;
+    summary.memTotal = Quantity::fromKiB(data.memTotal);
+    summary.memUsed = Quantity::fromKiB(memInfoUsed(data));
+    summary.memFree = Quantity::fromKiB(data.memFree);
+    summary.memShared = Quantity::fromKiB(data.shmem);
+    summary.memBuffCache = Quantity::fromKiB(memInfoBuffCache(data));
+    summary.memAvailable = Quantity::fromKiB(memInfoAvailable(data));
+    summary.swapTotal = Quantity::fromKiB(data.swapTotal);
+    summary.swapFree = Quantity::fromKiB(data.swapFree);
+    summary.swapUsed = summary.swapTotal - summary.swapFree;
+    summary.total = summary.memTotal + summary.swapTotal;
+    summary.totalUsed = summary.memUsed + summary.swapUsed;
+    summary.totalFree = summary.memFree + summary.swapFree;
+    return summary;
+}
+
+uint64_t unixTime() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec);
+}
+
+void appendJsonString(OutputBuffer &out, const char *text) {
+    out.append('"');
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\')
+            out.append('\\');
+        out.append(*text);
+    }
+    out.append('"');
+}
+
+void appendJsonMember(OutputBuffer &out, const char *name, uint64_t value, bool first = false) {
+    if (!first)
+        out.append(',');
+    appendJsonString(out, name);
+    out.append(':');
+    out.appendUint(value);
+}
+
+void appendJsonSize(OutputBuffer &out, const char *name, Quantity value, const Units &units, bool first = false) {
+    appendJsonMember(out, name, units.count(value), first);
+}
+
+void appendJsonPercent(OutputBuffer &out, Quantity used, Quantity total) {
+    out.append(",\"used_percent\":");
+    out.appendTenths(Percent::of(used, total).tenths());
+}
+
+/// Writes the forecast of a quantity, null until it is known and for exhausted_in_seconds
+/// when the quantity is not decreasing
+void appendJsonExhaustion(OutputBuffer &out, const Exhaustion &exhaustion, const Units &units) {
+    out.append(",\"exhausted_in_seconds\":");
+    if (exhaustion.known && exhaustion.seconds >= 0)
+        out.appendUint(static_cast<uint64_t>(exhaustion.seconds + 0.5));
+    else
+        out.append("null");
+    out.append(",\"change_per_second\":");
+    if (!exhaustion.known) {
+        out.append("null");
+        return;
+    }
+    const double change = exhaustion.bytesPerSecond;
+    const double magnitude = change < 0 ? -change : change;
+    const uint64_t count = units.count(Quantity::fromBytes(static_cast<uint64_t>(magnitude + 0.5)));
+    if (change < 0 && count > 0)
+        out.append('-');
+    out.appendUint(count);
+}
+
+void appendCsvSizes(OutputBuffer &out, std::initializer_list<Quantity> values, const Units &units) {
+    for (Quantity value : values) {
+        out.append(',');
+        out.appendUint(units.count(value));
+    }
+}
+
+/// Writes a meminfo field in the unit of the sizes, or as is when it is a page count
+void appendField(OutputBuffer &out, uint64_t value, MemInfoUnit unit, const Units &units) {
+    out.appendUint(unit == MemInfoUnit::KiB ? units.count(Quantity::fromKiB(value)) : value);
+}
+
+void appendPromHeader(OutputBuffer &out, const char *name, const char *help) {
+    out.append("# HELP ");
+    out.append(name);
+    out.append(' ');
+    out.append(help);
+    out.append("\n# TYPE ");
+    out.append(name);
+    out.append(" gauge\n");
+}
+
+void appendPromSample(OutputBuffer &out, const char *name, const char *label, const char *value, uint64_t sample) {
+    out.append(name);
+    out.append('{');
+    out.append(label);
+    out.append("=\"");
+    out.append(value);
+    out.append("\"} ");
+    out.appendUint(sample);
+    out.append('\n');
+}
+
+}
+
+OutputBuffer::OutputBuffer(int fd) : fd{fd} {
+}
+
+OutputBuffer::OutputBuffer(std::string &target) : fd{-1}, target{&target} {
+}
+
+void OutputBuffer::append(const char *text, size_t size) {
+    if (length + size > CAPACITY) {
+        flush();
+        // Text larger than the buffer goes out as is after the pending text
+        if (size > CAPACITY) {
+            write(text, size);
+            return;
+        }
+    }
+    std::memcpy(buffer + length, text, size);
+    length += size;
+}
+
+void OutputBuffer::appendUint(uint64_t value) {
+    char digits[20];
+    char *pos = digits + sizeof(digits);
+    while (value >= 100) {
+        unsigned int pair = static_cast<unsigned int>(value % 100) * 2;
+        value /= 100;
+        *--pos = DIGIT_PAIRS[pair + 1];
+        *--pos = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10) {
+        unsigned int pair = static_cast<unsigned int>(value) * 2;
+        *--pos = DIGIT_PAIRS[pair + 1];
+        *--pos = DIGIT_PAIRS[pair];
+    } else {
+        *--pos = static_cast<char>('0' + value);
+    }
+    append(pos, digits + sizeof(digits) - pos);
+}
+
+void OutputBuffer::appendTenths(uint64_t tenths) {
+    appendUint(tenths / 10);
+    char decimals[2] = {'.', static_cast<char>('0' + tenths % 10)};
+    append(decimals, sizeof(decimals));
+}
+
+void OutputBuffer::appendPercent(uint64_t used, uint64_t total) {
+    appendTenths(Percent::of(used, total).tenths());
+}
+
+bool OutputBuffer::flush() {
+    const bool written = write(buffer, length);
+    length = 0;
+    return written;
+}
+
+bool OutputBuffer::write(const char *text, size_t size) {
+    if (target != nullptr) {
+        target->append(text, size);
+        return true;
+    }
+    if (fd < 0)
+        return true;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::write(fd, text + written, size - written);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void writeJson(OutputBuffer &out, const MemInfoData &data, uint64_t timestamp, const Units &units,
+               const ExhaustionForecast *forecast) {
+    const Summary summary = summarize(data);
+    const Units fixed = units.fixed();
+    out.append('{');
+    appendJsonMember(out, "timestamp", timestamp != 0 ? timestamp : unixTime(), true);
+    out.append(",\"unit\":\"");
+    out.append(fixed.name());
+    out.append("\",\"memory\":{");
+    appendJsonSize(out, "total", summary.memTotal, fixed, true);
+    appendJsonSize(out, "used", summary.memUsed, fixed);
+    appendJsonSize(out, "free", summary.memFree, fixed);
+    appendJsonSize(out, "shared", summary.memShared, fixed);
+    appendJsonSize(out, "buff_cache", summary.memBuffCache, fixed);
+    appendJsonSize(out, "available", summary.memAvailable, fixed);
+    appendJsonPercent(out, summary.memUsed, summary.memTotal);
+    if (forecast != nullptr)
+        appendJsonExhaustion(out, forecast->memory(), fixed);
+    out.append("},\"swap\":{");
+    appendJsonSize(out, "total", summary.swapTotal, fixed, true);
+    appendJsonSize(out, "used", summary.swapUsed, fixed);
+    appendJsonSize(out, "free", summary.swapFree, fixed);
+    appendJsonPercent(out, summary.swapUsed, summary.swapTotal);
+    if (forecast != nullptr)
+        appendJsonExhaustion(out, forecast->swap(), fixed);
+    out.append("},\"totals\":{");
+    appendJsonSize(out, "total", summary.total, fixed, true);
+    appendJsonSize(out, "used", summary.totalUsed, fixed);
+    appendJsonSize(out, "free", summary.totalFree, fixed);
+    appendJsonPercent(out, summary.totalUsed, summary.total);
+    out.append("},\"meminfo\":{");
+    bool first = true;
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (!data.has(field))
+            continue;
+        if (!first)
+            out.append(',');
+        appendJsonString(out, memInfoKey(field));
+        out.append(':');
+        appendField(out, data.get(field), memInfoUnit(field), fixed);
+        first = false;
+    }
+    for (size_t i = 0; i < data.extraCount; i++) {
+        if (!first)
+            out.append(',');
+        appendJsonString(out, data.extra[i].key);
+        out.append(':');
+        appendField(out, data.extra[i].value, data.extra[i].unit, fixed);
+        first = false;
+    }
+    out.append("}}\n");
+}
+
+void writeCsvHeader(OutputBuffer &out) {
+    out.append("timestamp,mem_total,mem_used,mem_free,mem_shared,mem_buff_cache,mem_available,mem_used_percent,"
+               "swap_total,swap_used,swap_free,swap_used_percent,total,total_used,total_free,total_used_percent");
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        out.append(',');
+        out.append(memInfoKey(static_cast<MemInfoField>(i)));
+    }
+    out.append('\n');
+}
+
+void writeCsv(OutputBuffer &out, const MemInfoData &data, uint64_t timestamp, const Units &units) {
+    const Summary summary = summarize(data);
+    const Units fixed = units.fixed();
+    out.appendUint(timestamp != 0 ? timestamp : unixTime());
+    appendCsvSizes(out, {summary.memTotal, summary.memUsed, summary.memFree, summary.memShared,
+                         summary.memBuffCache, summary.memAvailable}, fixed);
+    out.append(',');
+    out.appendTenths(Percent::of(summary.memUsed, summary.memTotal).tenths());
+    appendCsvSizes(out, {summary.swapTotal, summary.swapUsed, summary.swapFree}, fixed);
+    out.append(',');
+    out.appendTenths(Percent::of(summary.swapUsed, summary.swapTotal).tenths());
+    appendCsvSizes(out, {summary.total, summary.totalUsed, summary.totalFree}, fixed);
+    out.append(',');
+    out.appendTenths(Percent::of(summary.totalUsed, summary.total).tenths());
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        out.append(',');
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (data.has(field))
+            appendField(out, data.get(field), memInfoUnit(field), fixed);
+    }
+    out.append('\n');
+}
+
+void writePrometheus(OutputBuffer &out, const MemInfoData &data) {
+    const Summary summary = summarize(data);
+    appendPromHeader(out, "superfree_memory_bytes", "Memory as shown in the Memory table.");
+    appendPromSample(out, "superfree_memory_bytes", "state", "total", summary.memTotal.bytes());
+    appendPromSample(out, "superfree_memory_bytes", "state", "used", summary.memUsed.bytes());
+    appendPromSample(out, "superfree_memory_bytes", "state", "free", summary.memFree.bytes());
+    appendPromSample(out, "superfree_memory_bytes", "state", "shared", summary.memShared.bytes());
+    appendPromSample(out, "superfree_memory_bytes", "state", "buff_cache", summary.memBuffCache.bytes());
+    appendPromSample(out, "superfree_memory_bytes", "state", "available", summary.memAvailable.bytes());
+
+    appendPromHeader(out, "superfree_swap_bytes", "Swap as shown in the Swap table.");
+    appendPromSample(out, "superfree_swap_bytes", "state", "total", summary.swapTotal.bytes());
+    appendPromSample(out, "superfree_swap_bytes", "state", "used", summary.swapUsed.bytes());
+    appendPromSample(out, "superfree_swap_bytes", "state", "free", summary.swapFree.bytes());
+
+    appendPromHeader(out, "superfree_meminfo_bytes", "Values of /proc/meminfo reported in kB.");
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (data.has(field) && memInfoUnit(field) == MemInfoUnit::KiB)
+            appendPromSample(out, "superfree_meminfo_bytes", "field", memInfoKey(field), Quantity::fromKiB(data.get(field)).bytes());
+    }
+    for (size_t i = 0; i < data.extraCount; i++) {
+        if (data.extra[i].unit == MemInfoUnit::KiB)
+            appendPromSample(out, "superfree_meminfo_bytes", "field", data.extra[i].key, Quantity::fromKiB(data.extra[i].value).bytes());
+    }
+
+    appendPromHeader(out, "superfree_meminfo_pages", "Values of /proc/meminfo reported as page counts.");
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (data.has(field) && memInfoUnit(field) == MemInfoUnit::Pages)
+            appendPromSample(out, "superfree_meminfo_pages", "field", memInfoKey(field), data.get(field));
+    }
+    for (size_t i = 0; i < data.extraCount; i++) {
+        if (data.extra[i].unit == MemInfoUnit::Pages)
+            appendPromSample(out, "superfree_meminfo_pages", "field", data.extra[i].key, data.extra[i].value);
+    }
+}
+
+void writeSnapshot(OutputBuffer &out, OutputFormat format, const MemInfoData &data, bool first, uint64_t timestamp,
+                   const Units &units, const ExhaustionForecast *forecast) {
+    switch (format) {
+    case OutputFormat::Json:
+        writeJson(out, data, timestamp, units, forecast);
+        break;
+    case OutputFormat::Csv:
+        if (first)
+            writeCsvHeader(out);
+        writeCsv(out, data, timestamp, units);
+        break;
+    case OutputFormat::Prometheus:
+        writePrometheus(out, data);
+        break;
+    default:
+        break;
+    }
+}
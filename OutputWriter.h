@@ -0,0 +1,156 @@
+#ifndef SUPERFREE_OUTPUTWRITER_H
+#define SUPERFREE_OUTPUTWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Forecast.h"
+#include "MemInfoParser.h"
+#include "Units.h"
+
+/// Output modes of superfree
+enum class OutputFormat {
+    Table,
+    Json,
+    Csv,
+    Prometheus,
+};
+
+/// Preallocated output buffer written to a descriptor with a single write(2)
+class OutputBuffer {
+public:
+
+    /// Bytes kept before flushing, enough for a full snapshot in any format
+    static const size_t CAPACITY = 16384;
+
+    /// Initialize an empty buffer
+    /// \param fd Descriptor written by flush(), negative to only keep the text in memory
+    explicit OutputBuffer(int fd);
+
+
+    /// Initialize an empty buffer whose flush() appends to a string, for text of any size
+    /// \param target String receiving the flushed text, must outlive the buffer
+    explicit OutputBuffer(std::string &target);
+
+
+    /// Appends raw text, flushing first if it does not fit. Text larger than CAPACITY is
+    /// written to the destination right after the pending text.
+    /// \param text Text to append
+    /// \param length Number of bytes of text
+    void append(const char *text, size_t length);
+
+
+    /// Appends a null terminated string
+    /// \param text Text to append
+    void append(const char *text) {
+        append(text, std::strlen(text));
+    }
+
+
+    /// Appends one character
+    /// \param c Character to append
+    void append(char c) {
+        append(&c, 1);
+    }
+
+
+    /// Appends an unsigned integer in decimal without going through printf or streams
+    /// \param value Value to append
+    void appendUint(uint64_t value);
+
+
+    /// Appends a fixed-point value with one decimal, e.g. 123 is written as 12.3
+    /// \param tenths Value multiplied by 10
+    void appendTenths(uint64_t tenths);
+
+
+    /// Appends used * 100 / total rounded to one decimal, 0.0 when total is 0
+    /// \param used Used amount
+    /// \param total Total amount
+    void appendPercent(uint64_t used, uint64_t total);
+
+
+    /// Writes the pending text to the descriptor
+    /// \return True if everything was written, otherwise false
+    bool flush();
+
+
+    /// Discards the pending text
+    void clear() {
+        length = 0;
+    }
+
+
+    /// Returns the pending text
+    const char *data() const {
+        return buffer;
+    }
+
+
+    /// Returns the number of pending bytes
+    size_t size() const {
+        return length;
+    }
+
+private:
+
+    /// Destination of flush()
+    int fd;
+
+    /// Destination of flush() instead of fd when not null
+    std::string *target = nullptr;
+
+    /// Number of pending bytes
+    size_t length = 0;
+
+    /// Pending text
+    char buffer[CAPACITY];
+
+    /// Writes text to the string or the descriptor, looping on short writes
+    /// \return True if everything was written, otherwise false
+    bool write(const char *text, size_t size);
+};
+
+
+/// Writes a snapshot as one JSON object per line
+/// \param out The buffer to write to
+/// \param data The parsed meminfo values
+/// \param timestamp Unix time of the snapshot, 0 for now
+/// \param units Unit of the sizes, -h is written in KiB (or kB)
+/// \param forecast Adds exhausted_in_seconds and change_per_second to memory and swap when set
+void writeJson(OutputBuffer &out, const MemInfoData &data, uint64_t timestamp = 0, const Units &units = Units{},
+               const ExhaustionForecast *forecast = nullptr);
+
+
+/// Writes the CSV header line matching writeCsv()
+/// \param out The buffer to write to
+void writeCsvHeader(OutputBuffer &out);
+
+
+/// Writes a snapshot as one CSV line
+/// \param out The buffer to write to
+/// \param data The parsed meminfo values
+/// \param timestamp Unix time of the snapshot, 0 for now
+/// \param units Unit of the sizes, -h is written in KiB (or kB)
+void writeCsv(OutputBuffer &out, const MemInfoData &data, uint64_t timestamp = 0, const Units &units = Units{});
+
+
+/// Writes a snapshot in the Prometheus text exposition format
+/// \param out The buffer to write to
+/// \param data The parsed meminfo values
+void writePrometheus(OutputBuffer &out, const MemInfoData &data);
+
+
+/// Writes a snapshot in one of the machine-readable formats, nothing for Table
+/// \param out The buffer to write to
+/// \param format Json, Csv or Prometheus
+/// \param data The parsed meminfo values
+/// \param first True for the first snapshot of the output, which gets the CSV header
+/// \param timestamp Unix time of the snapshot, 0 for now
+/// \param units Unit of the sizes, -h is written in KiB (or kB)
+/// \param forecast Written in JSON when set, see writeJson()
+void writeSnapshot(OutputBuffer &out, OutputFormat format, const MemInfoData &data, bool first, uint64_t timestamp = 0,
+                   const Units &units = Units{}, const ExhaustionForecast *forecast = nullptr);
+
+#endif //SUPERFREE_OUTPUTWRITER_H
@@ -0,0 +1,305 @@
+#include "PageCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iterator>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include "Parallel.h"
+
+namespace {
+
+/// Bytes of a file mapped at once, so the mincore(2) vector stays at 32 KiB with 4 KiB pages
+const uint64_t MINCORE_WINDOW = 128 * 1024 * 1024;
+
+/// Descriptors left to the rest of the process when sizing the pool
+const rlim_t RESERVED_FDS = 32;
+
+/// Number of independently locked parts of the index of files
+const size_t INDEX_SHARDS = 64;
+
+/// A directory to list, or a file given on the command line
+struct Task {
+    std::string path;
+    /// Entry of CacheScan::paths the files belong to
+    size_t group = 0;
+    bool directory = false;
+};
+
+struct FileKey {
+    uint64_t device;
+    uint64_t inode;
+
+    bool operator==(const FileKey &other) const {
+        return device == other.device && inode == other.inode;
+    }
+};
+
+struct FileKeyHash {
+    size_t operator()(const FileKey &key) const {
+        return static_cast<size_t>((key.inode * 0x9E3779B97F4A7C15ULL) ^ key.device);
+    }
+};
+
+/// What a file looked like at the previous scan
+struct FileState {
+    uint64_t size;
+    int64_t mtimeNs;
+    int64_t ctimeNs;
+    uint64_t cached;
+    /// Number of the scan that last saw the file, older entries are removed
+    unsigned int scan;
+};
+
+int64_t nanoseconds(const timespec &time) {
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+bool byCachedDescending(const CacheUsage &a, const CacheUsage &b) {
+    return a.cached > b.cached;
+}
+
+bool isDotEntry(const char *name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+/// Counts the bytes of an open file held in the page cache, mapping it window by window
+bool cachedBytes(int fd, uint64_t size, uint64_t pageSize, std::vector<unsigned char> &pages, uint64_t &cached) {
+    cached = 0;
+    for (uint64_t offset = 0; offset < size; offset += MINCORE_WINDOW) {
+        const size_t length = static_cast<size_t>(std::min(MINCORE_WINDOW, size - offset));
+        void *map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, static_cast<off_t>(offset));
+        if (map == MAP_FAILED)
+            return false;
+        const size_t count = (length + pageSize - 1) / pageSize;
+        pages.resize(count);
+        const bool ok = mincore(map, length, pages.data()) == 0;
+        munmap(map, length);
+        if (!ok)
+            return false;
+        uint64_t resident = 0;
+        for (size_t i = 0; i < count; ++i)
+            resident += pages[i] & 1;
+        cached += resident * pageSize;
+    }
+    // The last page is only partly in the file
+    cached = std::min(cached, size);
+    return true;
+}
+
+}
+
+struct PageCacheScanner::Index {
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<FileKey, FileState, FileKeyHash> files;
+    };
+    Shard shards[INDEX_SHARDS];
+
+    Shard &shard(const FileKey &key) {
+        return shards[FileKeyHash()(key) % INDEX_SHARDS];
+    }
+};
+
+namespace {
+
+/// Counters and buffers of one worker, merged at the end of the scan
+struct Worker {
+    std::vector<CacheUsage> groups;
+    /// Bounded min-heap of the most cached files
+    std::vector<CacheUsage> top;
+    std::vector<unsigned char> pages;
+    uint64_t unreadable = 0;
+    uint64_t skipped = 0;
+
+    void pushTop(const std::string &directory, const char *name, uint64_t size, uint64_t cached, size_t topCount) {
+        if (top.size() >= topCount && (topCount == 0 || cached <= top.front().cached))
+            return;
+        CacheUsage file;
+        file.path = name != nullptr ? directory + "/" + name : directory;
+        file.files = 1;
+        file.size = size;
+        file.cached = cached;
+        if (top.size() >= topCount) {
+            std::pop_heap(top.begin(), top.end(), byCachedDescending);
+            top.back() = std::move(file);
+        } else {
+            top.push_back(std::move(file));
+        }
+        std::push_heap(top.begin(), top.end(), byCachedDescending);
+    }
+};
+
+}
+
+PageCacheScanner::PageCacheScanner(std::vector<std::string> paths) : paths{std::move(paths)}, index{new Index} {
+}
+
+PageCacheScanner::~PageCacheScanner() = default;
+
+CacheScan PageCacheScanner::scan(size_t topCount, unsigned int threads) {
+    CacheScan result;
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const unsigned int scanNumber = ++scans;
+    const bool reuse = (scanNumber - 1) % CACHE_FULL_SCAN_INTERVAL != 0;
+
+    // The paths given and the entries of the directories given are the rows of the result
+    std::vector<Task> tasks;
+    for (const auto &path : paths) {
+        struct stat info;
+        if (stat(path.c_str(), &info) < 0) {
+            result.unreadable++;
+            continue;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            result.paths.push_back(CacheUsage{path});
+            tasks.push_back(Task{path, result.paths.size() - 1, false});
+            continue;
+        }
+        DIR *dir = opendir(path.c_str());
+        if (dir == nullptr) {
+            result.unreadable++;
+            continue;
+        }
+        const std::string prefix = path.back() == '/' ? path : path + "/";
+        while (dirent *entry = readdir(dir)) {
+            if (isDotEntry(entry->d_name))
+                continue;
+            const std::string child = prefix + entry->d_name;
+            struct stat childInfo;
+            if (lstat(child.c_str(), &childInfo) < 0 || (!S_ISDIR(childInfo.st_mode) && !S_ISREG(childInfo.st_mode)))
+                continue;
+            result.paths.push_back(CacheUsage{child});
+            tasks.push_back(Task{child, result.paths.size() - 1, S_ISDIR(childInfo.st_mode)});
+        }
+        closedir(dir);
+    }
+
+    // Every worker holds at most one directory and one file open
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > RESERVED_FDS)
+        threads = static_cast<unsigned int>(std::min<rlim_t>(threads, (limit.rlim_cur - RESERVED_FDS)
+                                                                      / CACHE_FDS_PER_WORKER));
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(std::max<size_t>(1, tasks.size()))));
+    std::vector<Worker> workers(threads);
+    for (auto &worker : workers)
+        worker.groups.resize(result.paths.size());
+
+    // Counts one regular file, relative to the directory it was found in
+    auto countFile = [&](Worker &worker, int dirFd, const std::string &directory, const char *name, size_t group) {
+        // A file given on the command line may be a symbolic link, the ones found below a directory are skipped
+        const char *path = name != nullptr ? name : directory.c_str();
+        const bool follow = name == nullptr;
+        struct stat info;
+        if (fstatat(dirFd, path, &info, follow ? 0 : AT_SYMLINK_NOFOLLOW) < 0 || !S_ISREG(info.st_mode))
+            return;
+        const uint64_t size = static_cast<uint64_t>(info.st_size);
+        const FileKey key{static_cast<uint64_t>(info.st_dev), static_cast<uint64_t>(info.st_ino)};
+        const int64_t mtime = nanoseconds(info.st_mtim);
+        const int64_t ctime = nanoseconds(info.st_ctim);
+        Index::Shard &shard = index->shard(key);
+        uint64_t cached = 0;
+        bool known = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto found = shard.files.find(key);
+            if (reuse && found != shard.files.end() && found->second.size == size && found->second.mtimeNs == mtime
+                    && found->second.ctimeNs == ctime) {
+                found->second.scan = scanNumber;
+                cached = found->second.cached;
+                known = true;
+            }
+        }
+        if (known) {
+            worker.skipped++;
+        } else if (size > 0) {
+            const int flags = O_RDONLY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW);
+            int fd = openat(dirFd, path, flags | O_NOATIME);
+            if (fd < 0 && errno == EPERM)
+                fd = openat(dirFd, path, flags);
+            const bool counted = fd >= 0 && cachedBytes(fd, size, pageSize, worker.pages, cached);
+            if (fd >= 0)
+                close(fd);
+            if (!counted) {
+                worker.unreadable++;
+                return;
+            }
+        }
+        if (!known) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.files[key] = FileState{size, mtime, ctime, cached, scanNumber};
+        }
+        CacheUsage &usage = worker.groups[group];
+        usage.files++;
+        usage.size += size;
+        usage.cached += cached;
+        if (cached > 0)
+            worker.pushTop(directory, name, size, cached, topCount);
+    };
+
+    parallelTasks(std::move(tasks), threads, [&](Task &task, unsigned int number, auto &spawn) {
+        Worker &worker = workers[number];
+        if (!task.directory) {
+            countFile(worker, AT_FDCWD, task.path, nullptr, task.group);
+            return;
+        }
+        DIR *dir = opendir(task.path.c_str());
+        if (dir == nullptr) {
+            worker.unreadable++;
+            return;
+        }
+        const int dirFd = dirfd(dir);
+        while (dirent *entry = readdir(dir)) {
+            if (isDotEntry(entry->d_name))
+                continue;
+            unsigned char type = entry->d_type;
+            if (type == DT_UNKNOWN) {
+                struct stat info;
+                if (fstatat(dirFd, entry->d_name, &info, AT_SYMLINK_NOFOLLOW) < 0)
+                    continue;
+                type = S_ISDIR(info.st_mode) ? DT_DIR : S_ISREG(info.st_mode) ? DT_REG : DT_LNK;
+            }
+            if (type == DT_DIR)
+                spawn(Task{task.path + "/" + entry->d_name, task.group, true});
+            else if (type == DT_REG)
+                countFile(worker, dirFd, task.path, entry->d_name, task.group);
+        }
+        closedir(dir);
+    });
+
+    // Forget the files that disappeared, so the index does not grow forever
+    for (auto &shard : index->shards) {
+        for (auto it = shard.files.begin(); it != shard.files.end();)
+            it = it->second.scan != scanNumber ? shard.files.erase(it) : std::next(it);
+    }
+
+    for (auto &worker : workers) {
+        for (size_t group = 0; group < result.paths.size(); ++group) {
+            result.paths[group].files += worker.groups[group].files;
+            result.paths[group].size += worker.groups[group].size;
+            result.paths[group].cached += worker.groups[group].cached;
+        }
+        result.files.insert(result.files.end(), std::make_move_iterator(worker.top.begin()),
+                            std::make_move_iterator(worker.top.end()));
+        result.unreadable += worker.unreadable;
+        result.skipped += worker.skipped;
+    }
+    result.total.path = "total";
+    for (const auto &usage : result.paths) {
+        result.total.files += usage.files;
+        result.total.size += usage.size;
+        result.total.cached += usage.cached;
+    }
+    std::stable_sort(result.paths.begin(), result.paths.end(), byCachedDescending);
+    const size_t keep = std::min(topCount, result.files.size());
+    std::partial_sort(result.files.begin(), result.files.begin() + keep, result.files.end(), byCachedDescending);
+    result.files.resize(keep);
+    return result;
+}
@@ -0,0 +1,76 @@
+#ifndef SUPERFREE_PAGECACHE_H
+#define SUPERFREE_PAGECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Number of refreshes after which files unchanged since the previous scan are checked
+/// again, their pages may have been read or reclaimed in the meantime
+const unsigned int CACHE_FULL_SCAN_INTERVAL = 10;
+
+/// Descriptors kept open by one worker at most: the directory it lists and the file it maps
+const unsigned int CACHE_FDS_PER_WORKER = 2;
+
+/// Page cache use of a file, or of every file below a path
+struct CacheUsage {
+    std::string path;
+    uint64_t files = 0;
+    /// Sum of the file sizes in bytes
+    uint64_t size = 0;
+    /// Bytes of the files held in the page cache
+    uint64_t cached = 0;
+};
+
+/// Result of a page cache scan
+struct CacheScan {
+    /// Every path given, and every entry of the directories given, by descending cached bytes
+    std::vector<CacheUsage> paths;
+    /// The files with most cached bytes, by descending cached bytes
+    std::vector<CacheUsage> files;
+    /// Totals of all the files scanned
+    CacheUsage total;
+    /// Files that could not be opened or mapped
+    uint64_t unreadable = 0;
+    /// Files unchanged since the previous scan whose previous count was kept
+    uint64_t skipped = 0;
+};
+
+
+/// Measures how much of files and directory trees is in the page cache, with mmap(2) and
+/// mincore(2). Directories are walked in parallel by a work-stealing pool and files are
+/// opened one at a time per worker, so millions of files never need more than
+/// CACHE_FDS_PER_WORKER descriptors per thread. Symbolic links below the paths given are
+/// not followed. When scanning again, files whose size, mtime and ctime did not change keep
+/// the count of the previous scan, except every CACHE_FULL_SCAN_INTERVAL scans.
+class PageCacheScanner {
+public:
+
+    /// \param paths Files and directories to scan
+    explicit PageCacheScanner(std::vector<std::string> paths);
+
+    ~PageCacheScanner();
+
+    PageCacheScanner(const PageCacheScanner &) = delete;
+    PageCacheScanner &operator=(const PageCacheScanner &) = delete;
+
+
+    /// Scans every path
+    /// \param topCount Number of files kept in CacheScan::files
+    /// \param threads Number of worker threads, lowered to fit the descriptor limit
+    /// \return The page cache use of the paths and of the most cached files
+    CacheScan scan(size_t topCount, unsigned int threads);
+
+private:
+
+    struct Index;
+
+    std::vector<std::string> paths;
+    /// Files seen by the previous scans, to skip the unchanged ones
+    std::unique_ptr<Index> index;
+    unsigned int scans = 0;
+};
+
+#endif //SUPERFREE_PAGECACHE_H
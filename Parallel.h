@@ -0,0 +1,119 @@
+#ifndef SUPERFREE_PARALLEL_H
+#define SUPERFREE_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Returns the number of worker threads used by default, one per CPU
+inline unsigned int defaultThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+
+/// Runs function(index, worker) for every index in [0, count) on up to threads threads.
+/// Indexes are handed out in small chunks from a shared counter so slow items do not
+/// leave other workers idle. The calling thread is worker 0.
+/// \param count Number of items
+/// \param threads Maximum number of threads, including the calling one
+/// \param function Callable taking the item index and the worker number
+template <typename F>
+void parallelFor(size_t count, unsigned int threads, F function) {
+    const size_t CHUNK = 16;
+    threads = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>(threads, (count + CHUNK - 1) / CHUNK)));
+    std::atomic<size_t> next{0};
+    auto work = [&](unsigned int worker) {
+        for (;;) {
+            size_t start = next.fetch_add(CHUNK, std::memory_order_relaxed);
+            if (start >= count)
+                return;
+            size_t end = std::min(start + CHUNK, count);
+            for (size_t i = start; i < end; ++i)
+                function(i, worker);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int worker = 1; worker < threads; ++worker)
+        pool.emplace_back(work, worker);
+    work(0);
+    for (auto &thread : pool)
+        thread.join();
+}
+
+
+/// Runs function(task, worker, spawn) for every task, where the function may call
+/// spawn(task) to add the tasks it discovers, e.g. the subdirectories of a directory.
+/// Every worker pushes and pops its own queue at the back, and idle workers steal from
+/// the front of the others, where the oldest and usually largest tasks are. Returns when
+/// every task, including the spawned ones, has run. The calling thread is worker 0.
+/// \param tasks Initial tasks, dealt round-robin to the workers
+/// \param threads Number of threads, including the calling one
+/// \param function Callable taking a Task &, the worker number and a spawn callable
+template <typename Task, typename F>
+void parallelTasks(std::vector<Task> tasks, unsigned int threads, F function) {
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    threads = std::max(1u, threads);
+    std::unique_ptr<Queue[]> queues(new Queue[threads]);
+    for (size_t i = 0; i < tasks.size(); ++i)
+        queues[i % threads].tasks.push_back(std::move(tasks[i]));
+    // Tasks queued or running, a worker may only leave when it reaches 0
+    std::atomic<size_t> pending{tasks.size()};
+
+    auto work = [&](unsigned int worker) {
+        Queue &own = queues[worker];
+        auto spawn = [&](Task task) {
+            pending.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.tasks.push_back(std::move(task));
+        };
+        for (;;) {
+            Task task;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    found = true;
+                }
+            }
+            for (unsigned int i = 1; !found && i < threads; ++i) {
+                Queue &victim = queues[(worker + i) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    found = true;
+                }
+            }
+            if (!found) {
+                if (pending.load(std::memory_order_acquire) == 0)
+                    return;
+                std::this_thread::yield();
+                continue;
+            }
+            function(task, worker, spawn);
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int worker = 1; worker < threads; ++worker)
+        pool.emplace_back(work, worker);
+    work(0);
+    for (auto &thread : pool)
+        thread.join();
+}
+
+#endif //SUPERFREE_PARALLEL_H
@@ -0,0 +1,121 @@
+#include "Pressure.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+/// Parses a decimal number such as 12.34 and advances pos past it
+double parseDecimal(const char *&pos, const char *end) {
+    double value = 0;
+    while (pos < end && static_cast<unsigned char>(*pos - '0') < 10)
+        value = value * 10 + (*pos++ - '0');
+    if (pos < end && *pos == '.') {
+        double scale = 0.1;
+        for (++pos; pos < end && static_cast<unsigned char>(*pos - '0') < 10; ++pos, scale /= 10)
+            value += (*pos - '0') * scale;
+    }
+    return value;
+}
+
+/// Parses "avg10=0.00 avg60=0.00 avg300=0.00 total=0" up to the end of the line
+void parseLine(const char *pos, const char *end, PressureLine &line) {
+    while (pos < end && *pos != '\n') {
+        const char *key = pos;
+        const char *equal = static_cast<const char *>(std::memchr(pos, '=', end - pos));
+        if (equal == nullptr)
+            return;
+        pos = equal + 1;
+        const size_t length = equal - key;
+        if (length == 5 && std::memcmp(key, "avg10", 5) == 0) {
+            line.avg10 = parseDecimal(pos, end);
+        } else if (length == 5 && std::memcmp(key, "avg60", 5) == 0) {
+            line.avg60 = parseDecimal(pos, end);
+        } else if (length == 6 && std::memcmp(key, "avg300", 6) == 0) {
+            line.avg300 = parseDecimal(pos, end);
+        } else if (length == 5 && std::memcmp(key, "total", 5) == 0) {
+            uint64_t total = 0;
+            while (pos < end && static_cast<unsigned char>(*pos - '0') < 10)
+                total = total * 10 + (*pos++ - '0');
+            line.total = total;
+        }
+        while (pos < end && *pos != ' ' && *pos != '\n')
+            pos++;
+        while (pos < end && *pos == ' ')
+            pos++;
+    }
+}
+
+}
+
+bool parsePressure(const char *buffer, size_t length, PressureData &data) {
+    data = PressureData{};
+    bool hasSome = false;
+    const char *pos = buffer;
+    const char *end = buffer + length;
+    while (pos < end) {
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        const char *lineEnd = newline != nullptr ? newline : end;
+        if (lineEnd - pos > 5 && std::memcmp(pos, "some ", 5) == 0) {
+            parseLine(pos + 5, lineEnd, data.some);
+            hasSome = true;
+        } else if (lineEnd - pos > 5 && std::memcmp(pos, "full ", 5) == 0) {
+            parseLine(pos + 5, lineEnd, data.full);
+            data.hasFull = true;
+        }
+        pos = lineEnd + 1;
+    }
+    return hasSome;
+}
+
+bool preadPressure(int fd, PressureData &data) {
+    char buffer[256];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    return parsePressure(buffer, static_cast<size_t>(n), data);
+}
+
+PressureTrigger::~PressureTrigger() {
+    if (triggerFd >= 0)
+        close(triggerFd);
+    if (readFd >= 0)
+        close(readFd);
+}
+
+bool PressureTrigger::open(const std::string &trigger, const char *path) {
+    triggerFd = ::open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (triggerFd < 0)
+        return false;
+    // The kernel expects the terminating null byte
+    if (write(triggerFd, trigger.c_str(), trigger.size() + 1) < 0) {
+        int error = errno;
+        close(triggerFd);
+        triggerFd = -1;
+        errno = error;
+        return false;
+    }
+    readFd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return readFd >= 0;
+}
+
+PressureEvent PressureTrigger::wait(int timeoutMs) {
+    pollfd descriptor{triggerFd, POLLPRI, 0};
+    int n = poll(&descriptor, 1, timeoutMs);
+    if (n < 0)
+        event = errno == EINTR ? PressureEvent::Interrupted : PressureEvent::Error;
+    else if (n == 0)
+        event = PressureEvent::Heartbeat;
+    else if (descriptor.revents & POLLERR)
+        event = PressureEvent::Error;
+    else
+        event = PressureEvent::Triggered;
+    return event;
+}
+
+bool PressureTrigger::read(PressureData &data) const {
+    return preadPressure(readFd, data);
+}
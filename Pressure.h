@@ -0,0 +1,113 @@
+#ifndef SUPERFREE_PRESSURE_H
+#define SUPERFREE_PRESSURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Trigger registered when none is given: 150 ms of partial stall within 1 s
+const char *const PRESSURE_DEFAULT_TRIGGER = "some 150000 1000000";
+
+/// Same stall share as PRESSURE_DEFAULT_TRIGGER, for unprivileged processes whose
+/// windows must be multiples of 2 s
+const char *const PRESSURE_UNPRIVILEGED_TRIGGER = "some 300000 2000000";
+
+/// One line of a pressure file
+struct PressureLine {
+    /// Share of time stalled over the last 10, 60 and 300 seconds, in percent
+    double avg10 = 0;
+    double avg60 = 0;
+    double avg300 = 0;
+    /// Total stall time since boot in microseconds
+    uint64_t total = 0;
+};
+
+/// Contents of /proc/pressure/memory
+struct PressureData {
+    /// Some tasks stalled on memory
+    PressureLine some;
+    /// All non-idle tasks stalled on memory at once
+    PressureLine full;
+    /// False on kernels that only report the some line
+    bool hasFull = false;
+};
+
+
+/// Parses the contents of a pressure file in place
+/// \param buffer Text of the file
+/// \param length Number of bytes in buffer
+/// \param data Receives the values
+/// \return True if the some line was found
+bool parsePressure(const char *buffer, size_t length, PressureData &data);
+
+
+/// Reads a pressure file through a descriptor kept open
+/// \param fd Descriptor of the pressure file
+/// \param data Receives the values
+/// \return True if the file could be read and parsed
+bool preadPressure(int fd, PressureData &data);
+
+
+/// Result of PressureTrigger::wait()
+enum class PressureEvent {
+    /// The stall threshold was crossed
+    Triggered,
+    /// The heartbeat timeout elapsed without pressure
+    Heartbeat,
+    /// poll(2) was interrupted by a signal
+    Interrupted,
+    /// The trigger is no longer usable
+    Error,
+};
+
+
+/// A PSI trigger on a pressure file: the kernel wakes poll(2) with POLLPRI when tasks
+/// stall longer than a threshold within a window, so waiting costs no wakeup while the
+/// system is idle
+class PressureTrigger {
+public:
+
+    PressureTrigger() = default;
+
+    ~PressureTrigger();
+
+    PressureTrigger(const PressureTrigger &) = delete;
+    PressureTrigger &operator=(const PressureTrigger &) = delete;
+
+
+    /// Registers the trigger, errno is kept on failure
+    /// \param trigger "<some|full> <stall us> <window us>", e.g. "some 150000 1000000"
+    /// \param path Path of the pressure file
+    /// \return True if the trigger was registered, otherwise false
+    bool open(const std::string &trigger, const char *path = "/proc/pressure/memory");
+
+
+    /// Blocks until the trigger fires or the timeout elapses
+    /// \param timeoutMs Heartbeat timeout in milliseconds
+    /// \return What ended the wait
+    PressureEvent wait(int timeoutMs);
+
+
+    /// Returns what ended the last wait(), Heartbeat before the first one
+    PressureEvent lastEvent() const {
+        return event;
+    }
+
+
+    /// Reads the current averages of the pressure file
+    /// \param data Receives the values
+    /// \return True if the file could be read, otherwise false
+    bool read(PressureData &data) const;
+
+private:
+
+    /// Descriptor holding the trigger
+    int triggerFd = -1;
+
+    /// Descriptor used to read the averages
+    int readFd = -1;
+
+    PressureEvent event = PressureEvent::Heartbeat;
+};
+
+#endif //SUPERFREE_PRESSURE_H
@@ -0,0 +1,152 @@
+#include "ProcScan.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MemInfoParser.h"
+#include "Parallel.h"
+
+namespace {
+
+/// Size of the stack buffer used to read smaps_rollup
+const size_t ROLLUP_BUFFER_SIZE = 4096;
+
+bool byPssDescending(const ProcessMemory &a, const ProcessMemory &b) {
+    return a.pss > b.pss;
+}
+
+/// Lists the numeric entries of the proc directory
+std::vector<int> listPids(int procFd) {
+    std::vector<int> pids;
+    int fd = dup(procFd);
+    if (fd < 0)
+        return pids;
+    DIR *dir = fdopendir(fd);
+    if (dir == nullptr) {
+        close(fd);
+        return pids;
+    }
+    while (dirent *entry = readdir(dir)) {
+        const char *name = entry->d_name;
+        if (name[0] < '1' || name[0] > '9')
+            continue;
+        int pid = 0;
+        for (; *name >= '0' && *name <= '9'; ++name)
+            pid = pid * 10 + (*name - '0');
+        if (*name == '\0')
+            pids.push_back(pid);
+    }
+    closedir(dir);
+    return pids;
+}
+
+/// Reads a small file relative to procFd into buffer, returns the number of bytes read
+ssize_t readAt(int procFd, const char *path, char *buffer, size_t size) {
+    int fd = openat(procFd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    ssize_t n = read(fd, buffer, size);
+    const int error = errno;
+    close(fd);
+    errno = error;
+    return n;
+}
+
+#define KEY_IS(literal) (length == sizeof(literal) - 1 && std::memcmp(key, literal, length) == 0)
+
+bool readProcess(int procFd, int pid, ProcessMemory &process) {
+    char path[32];
+    char buffer[ROLLUP_BUFFER_SIZE];
+    std::snprintf(path, sizeof(path), "%d/smaps_rollup", pid);
+    ssize_t n = readAt(procFd, path, buffer, sizeof(buffer));
+    // Kernel threads have no mm, smaps_rollup fails with ESRCH or is empty
+    if (n < 0 && errno != ESRCH)
+        return false;
+    if (n < 0)
+        n = 0;
+
+    std::memset(&process, 0, sizeof(process));
+    process.pid = pid;
+    scanKeyValues(buffer, static_cast<size_t>(n), [&](const char *key, size_t length, uint64_t value, bool) {
+        if (KEY_IS("Rss"))
+            process.rss = value;
+        else if (KEY_IS("Pss"))
+            process.pss = value;
+        else if (KEY_IS("Pss_Anon"))
+            process.pssAnon = value;
+        else if (KEY_IS("Pss_File"))
+            process.pssFile = value;
+        else if (KEY_IS("Pss_Shmem"))
+            process.pssShmem = value;
+        else if (KEY_IS("Swap"))
+            process.swap = value;
+        else if (KEY_IS("SwapPss"))
+            process.swapPss = value;
+    });
+
+    std::snprintf(path, sizeof(path), "%d/comm", pid);
+    n = readAt(procFd, path, process.command, sizeof(process.command) - 1);
+    if (n > 0 && process.command[n - 1] == '\n')
+        n--;
+    process.command[n > 0 ? n : 0] = '\0';
+    return true;
+}
+
+#undef KEY_IS
+
+/// Bounded min-heap of the processes with the highest PSS seen by one worker
+struct TopHeap {
+    std::vector<ProcessMemory> heap;
+    size_t withoutMemory = 0;
+    size_t unreadable = 0;
+
+    void push(const ProcessMemory &process, size_t topCount) {
+        if (heap.size() < topCount) {
+            heap.push_back(process);
+            std::push_heap(heap.begin(), heap.end(), byPssDescending);
+        } else if (topCount > 0 && process.pss > heap.front().pss) {
+            std::pop_heap(heap.begin(), heap.end(), byPssDescending);
+            heap.back() = process;
+            std::push_heap(heap.begin(), heap.end(), byPssDescending);
+        }
+    }
+};
+
+}
+
+ProcessScan scanProcesses(const char *procRoot, size_t topCount, unsigned int threads) {
+    ProcessScan scan;
+    int procFd = open(procRoot, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (procFd < 0)
+        return scan;
+
+    const std::vector<int> pids = listPids(procFd);
+    scan.processes = pids.size();
+    if (threads == 0)
+        threads = 1;
+    std::vector<TopHeap> heaps(threads);
+    parallelFor(pids.size(), threads, [&](size_t index, unsigned int worker) {
+        ProcessMemory process;
+        if (!readProcess(procFd, pids[index], process))
+            heaps[worker].unreadable++;
+        else if (process.rss == 0)
+            heaps[worker].withoutMemory++;
+        else
+            heaps[worker].push(process, topCount);
+    });
+    close(procFd);
+
+    for (const auto &heap : heaps) {
+        scan.withoutMemory += heap.withoutMemory;
+        scan.unreadable += heap.unreadable;
+        scan.top.insert(scan.top.end(), heap.heap.begin(), heap.heap.end());
+    }
+    size_t keep = std::min(topCount, scan.top.size());
+    std::partial_sort(scan.top.begin(), scan.top.begin() + keep, scan.top.end(), byPssDescending);
+    scan.top.resize(keep);
+    return scan;
+}
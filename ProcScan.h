@@ -0,0 +1,46 @@
+#ifndef SUPERFREE_PROCSCAN_H
+#define SUPERFREE_PROCSCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Maximum length of a process name kept from /proc/<pid>/comm
+const size_t PROCESS_COMMAND_SIZE = 32;
+
+/// Memory of one process read from /proc/<pid>/smaps_rollup, in kB
+struct ProcessMemory {
+    int pid;
+    uint64_t rss;
+    uint64_t pss;
+    uint64_t pssAnon;
+    uint64_t pssFile;
+    uint64_t pssShmem;
+    uint64_t swap;
+    uint64_t swapPss;
+    char command[PROCESS_COMMAND_SIZE];
+};
+
+/// Result of a process scan
+struct ProcessScan {
+    /// The processes with the highest PSS, sorted by descending PSS
+    std::vector<ProcessMemory> top;
+    /// Number of process directories found
+    size_t processes = 0;
+    /// Number of processes without resident memory, e.g. kernel threads or zombies
+    size_t withoutMemory = 0;
+    /// Number of processes whose smaps_rollup could not be read (permissions, exited)
+    size_t unreadable = 0;
+};
+
+
+/// Reads smaps_rollup of every process of a proc tree in parallel and keeps the top N by PSS.
+/// Files are opened with openat(2) relative to one descriptor of the proc directory, each
+/// worker keeps its own bounded heap and the heaps are merged at the end.
+/// \param procRoot Directory to scan, usually /proc
+/// \param topCount Number of processes to keep
+/// \param threads Number of worker threads
+/// \return The processes with the highest PSS and the scan counters
+ProcessScan scanProcesses(const char *procRoot, size_t topCount, unsigned int threads);
+
+#endif //SUPERFREE_PROCSCAN_H
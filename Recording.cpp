@@ -0,0 +1,341 @@
+#include "Recording.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'S', 'F', 'R', 'E', 'C', 'O', 'R', 'D'};
+const uint32_t VERSION = 2;
+
+/// Words of the bitmap of the meminfo fields the kernel reported, recorded as values so
+/// they cost a bit per sample while they do not change
+const size_t PRESENT_WORDS = (MEMINFO_FIELD_COUNT + 63) / 64;
+
+/// Every recorded value: the meminfo fields, the vmstat counters and the present bitmap
+const size_t FIELD_COUNT = MEMINFO_FIELD_COUNT + VMSTAT_FIELD_COUNT + PRESENT_WORDS;
+const size_t PRESENT_OFFSET = MEMINFO_FIELD_COUNT + VMSTAT_FIELD_COUNT;
+const size_t BITMAP_SIZE = (FIELD_COUNT + 7) / 8;
+
+/// Worst case size of one encoded sample: a time delta, the bitmap and a 10 byte varint per field
+const size_t MAX_SAMPLE_SIZE = 10 + BITMAP_SIZE + 10 * FIELD_COUNT;
+
+/// First bytes of the file, the rest of the first block is unused
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t blockCount;
+    uint32_t meminfoFields;
+    uint32_t vmstatFields;
+};
+
+/// First bytes of every block. count and bytes are published with release stores after
+/// the sample they cover, so a reader never decodes a sample that is being written.
+struct BlockHeader {
+    /// Order of the block in the ring, 0 when the block was never written
+    uint64_t sequence;
+    int64_t firstTimeMs;
+    int64_t lastTimeMs;
+    uint32_t count;
+    uint32_t bytes;
+};
+
+const size_t PAYLOAD_SIZE = RECORDING_BLOCK_SIZE - sizeof(BlockHeader);
+
+static_assert(MAX_SAMPLE_SIZE <= PAYLOAD_SIZE, "A sample must fit in an empty block");
+
+BlockHeader *blockAt(char *map, size_t index) {
+    return reinterpret_cast<BlockHeader *>(map + (index + 1) * RECORDING_BLOCK_SIZE);
+}
+
+const BlockHeader *blockAt(const char *map, size_t index) {
+    return reinterpret_cast<const BlockHeader *>(map + (index + 1) * RECORDING_BLOCK_SIZE);
+}
+
+char *encodeVarint(char *pos, uint64_t value) {
+    while (value >= 0x80) {
+        *pos++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *pos++ = static_cast<char>(value);
+    return pos;
+}
+
+const char *decodeVarint(const char *pos, const char *end, uint64_t &value) {
+    value = 0;
+    for (unsigned int shift = 0; pos < end && shift < 64; shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(*pos++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return pos;
+    }
+    return nullptr;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void gather(const MemInfoData &meminfo, const VmStatData &vmstat, uint64_t *values) {
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++)
+        values[i] = meminfo.get(static_cast<MemInfoField>(i));
+    std::memcpy(values + MEMINFO_FIELD_COUNT, vmstat.values, sizeof(vmstat.values));
+    std::fill(values + PRESENT_OFFSET, values + FIELD_COUNT, 0);
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        if (meminfo.present.test(i))
+            values[PRESENT_OFFSET + i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+    }
+}
+
+void scatter(const uint64_t *values, int64_t timeMs, RecordedSample &sample) {
+    sample.timeMs = timeMs;
+    sample.meminfo = MemInfoData{};
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        sample.meminfo.set(static_cast<MemInfoField>(i), values[i]);
+        sample.meminfo.present.set(i, (values[PRESENT_OFFSET + i / 64] >> (i % 64)) & 1);
+    }
+    std::memcpy(sample.vmstat.values, values + MEMINFO_FIELD_COUNT, sizeof(sample.vmstat.values));
+    sample.vmstat.time.tv_sec = timeMs / 1000;
+    sample.vmstat.time.tv_nsec = (timeMs % 1000) * 1000000;
+}
+
+void checkHeader(const FileHeader &header, size_t fileSize, const std::string &path) {
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw std::runtime_error{path + " is not a superfree recording"};
+    if (header.version != VERSION || header.blockSize != RECORDING_BLOCK_SIZE
+            || header.meminfoFields != MEMINFO_FIELD_COUNT || header.vmstatFields != VMSTAT_FIELD_COUNT)
+        throw std::runtime_error{path + " was recorded by another version of superfree"};
+    if ((header.blockCount + 1) * RECORDING_BLOCK_SIZE > fileSize)
+        throw std::runtime_error{path + " is truncated"};
+}
+
+}
+
+Recorder::Recorder(const std::string &path, size_t size) : previous(FIELD_COUNT, 0) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error{"Unable to open " + path + ": " + std::strerror(errno)};
+    struct stat status;
+    fstat(fd, &status);
+    const bool created = status.st_size == 0;
+    if (created) {
+        size = std::max(size / RECORDING_BLOCK_SIZE, static_cast<size_t>(3)) * RECORDING_BLOCK_SIZE;
+        int error = posix_fallocate(fd, 0, static_cast<off_t>(size));
+        if (error != 0) {
+            close(fd);
+            throw std::runtime_error{"Unable to allocate " + path + ": " + std::strerror(error)};
+        }
+    } else {
+        size = static_cast<size_t>(status.st_size);
+    }
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error{"Unable to map " + path + ": " + std::strerror(errno)};
+    }
+    map = static_cast<char *>(address);
+    mapSize = size;
+
+    FileHeader &header = *reinterpret_cast<FileHeader *>(map);
+    if (created) {
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.blockSize = RECORDING_BLOCK_SIZE;
+        header.blockCount = size / RECORDING_BLOCK_SIZE - 1;
+        header.meminfoFields = MEMINFO_FIELD_COUNT;
+        header.vmstatFields = VMSTAT_FIELD_COUNT;
+    } else {
+        try {
+            checkHeader(header, size, path);
+        } catch (...) {
+            munmap(map, mapSize);
+            close(fd);
+            throw;
+        }
+    }
+
+    // Continue after the newest block, a block is never appended to after a restart
+    uint64_t newest = 0;
+    block = blockCount() - 1;
+    for (size_t i = 0; i < blockCount(); i++) {
+        uint64_t sequence = blockAt(map, i)->sequence;
+        if (sequence > newest) {
+            newest = sequence;
+            block = i;
+        }
+    }
+    nextBlock();
+}
+
+Recorder::~Recorder() {
+    if (map != nullptr)
+        munmap(map, mapSize);
+    if (fd >= 0)
+        close(fd);
+}
+
+size_t Recorder::blockCount() const {
+    return reinterpret_cast<const FileHeader *>(map)->blockCount;
+}
+
+void Recorder::nextBlock() {
+    const uint64_t sequence = blockAt(map, block)->sequence + 1;
+    block = (block + 1) % blockCount();
+    BlockHeader *header = blockAt(map, block);
+    __atomic_store_n(&header->count, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->bytes, 0, __ATOMIC_RELEASE);
+    header->firstTimeMs = 0;
+    header->lastTimeMs = 0;
+    __atomic_store_n(&header->sequence, sequence, __ATOMIC_RELEASE);
+    std::fill(previous.begin(), previous.end(), 0);
+    previousTimeMs = 0;
+}
+
+void Recorder::append(int64_t timeMs, const MemInfoData &meminfo, const VmStatData &vmstat) {
+    uint64_t values[FIELD_COUNT];
+    gather(meminfo, vmstat, values);
+
+    BlockHeader *header = blockAt(map, block);
+    if (header->bytes + MAX_SAMPLE_SIZE > PAYLOAD_SIZE) {
+        nextBlock();
+        header = blockAt(map, block);
+    }
+    char *start = reinterpret_cast<char *>(header + 1) + header->bytes;
+    char *pos = encodeVarint(start, zigzag(timeMs - previousTimeMs));
+    char *bitmap = pos;
+    std::memset(bitmap, 0, BITMAP_SIZE);
+    pos += BITMAP_SIZE;
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (values[i] == previous[i])
+            continue;
+        bitmap[i / 8] |= static_cast<char>(1 << (i % 8));
+        pos = encodeVarint(pos, zigzag(static_cast<int64_t>(values[i] - previous[i])));
+        previous[i] = values[i];
+    }
+    previousTimeMs = timeMs;
+
+    if (header->count == 0)
+        header->firstTimeMs = timeMs;
+    header->lastTimeMs = timeMs;
+    __atomic_store_n(&header->bytes, static_cast<uint32_t>(pos - reinterpret_cast<char *>(header + 1)),
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&header->count, header->count + 1, __ATOMIC_RELEASE);
+}
+
+Replay::Replay(const std::string &path) {
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error{"Unable to open " + path + ": " + std::strerror(errno)};
+    struct stat status;
+    fstat(fd, &status);
+    mapSize = static_cast<size_t>(status.st_size);
+    if (mapSize < sizeof(FileHeader)) {
+        close(fd);
+        throw std::runtime_error{path + " is not a superfree recording"};
+    }
+    void *address = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error{"Unable to map " + path + ": " + std::strerror(errno)};
+    }
+    map = static_cast<const char *>(address);
+    try {
+        checkHeader(*reinterpret_cast<const FileHeader *>(map), mapSize, path);
+    } catch (...) {
+        munmap(const_cast<char *>(map), mapSize);
+        close(fd);
+        throw;
+    }
+}
+
+Replay::~Replay() {
+    munmap(const_cast<char *>(map), mapSize);
+    close(fd);
+}
+
+size_t Replay::forEach(int64_t fromMs, int64_t toMs,
+                       const std::function<bool(const RecordedSample &)> &callback) const {
+    const FileHeader &header = *reinterpret_cast<const FileHeader *>(map);
+    std::vector<std::pair<uint64_t, size_t>> blocks;
+    for (size_t i = 0; i < header.blockCount; i++) {
+        const BlockHeader *block = blockAt(map, i);
+        uint64_t sequence = __atomic_load_n(&block->sequence, __ATOMIC_ACQUIRE);
+        if (sequence != 0 && __atomic_load_n(&block->count, __ATOMIC_ACQUIRE) > 0
+                && block->lastTimeMs >= fromMs && block->firstTimeMs <= toMs)
+            blocks.emplace_back(sequence, i);
+    }
+    std::sort(blocks.begin(), blocks.end());
+
+    size_t delivered = 0;
+    RecordedSample sample;
+    uint64_t values[FIELD_COUNT];
+    for (const auto &entry : blocks) {
+        const BlockHeader *block = blockAt(map, entry.second);
+        const uint32_t count = __atomic_load_n(&block->count, __ATOMIC_ACQUIRE);
+        const uint32_t bytes = __atomic_load_n(&block->bytes, __ATOMIC_ACQUIRE);
+        const char *pos = reinterpret_cast<const char *>(block + 1);
+        const char *end = pos + std::min<size_t>(bytes, PAYLOAD_SIZE);
+        std::memset(values, 0, sizeof(values));
+        int64_t timeMs = 0;
+        for (uint32_t n = 0; n < count && pos != nullptr && pos < end; n++) {
+            uint64_t delta;
+            pos = decodeVarint(pos, end, delta);
+            if (pos == nullptr || end - pos < static_cast<ptrdiff_t>(BITMAP_SIZE))
+                break;
+            timeMs += unzigzag(delta);
+            const unsigned char *bitmap = reinterpret_cast<const unsigned char *>(pos);
+            pos += BITMAP_SIZE;
+            for (size_t i = 0; i < FIELD_COUNT && pos != nullptr; i++) {
+                if (bitmap[i / 8] & (1 << (i % 8))) {
+                    pos = decodeVarint(pos, end, delta);
+                    values[i] += static_cast<uint64_t>(unzigzag(delta));
+                }
+            }
+            if (pos == nullptr || timeMs < fromMs)
+                continue;
+            if (timeMs > toMs)
+                break;
+            scatter(values, timeMs, sample);
+            delivered++;
+            if (!callback(sample))
+                return delivered;
+        }
+    }
+    return delivered;
+}
+
+bool Replay::at(int64_t timeMs, RecordedSample &sample) const {
+    // Only the newest block that starts before timeMs needs to be decoded
+    const FileHeader &header = *reinterpret_cast<const FileHeader *>(map);
+    uint64_t newest = 0;
+    int64_t fromMs = 0;
+    for (size_t i = 0; i < header.blockCount; i++) {
+        const BlockHeader *block = blockAt(map, i);
+        uint64_t sequence = __atomic_load_n(&block->sequence, __ATOMIC_ACQUIRE);
+        if (sequence > newest && __atomic_load_n(&block->count, __ATOMIC_ACQUIRE) > 0
+                && block->firstTimeMs <= timeMs) {
+            newest = sequence;
+            fromMs = block->firstTimeMs;
+        }
+    }
+    if (newest == 0)
+        return false;
+    bool found = false;
+    forEach(fromMs, timeMs, [&](const RecordedSample &recorded) {
+        sample = recorded;
+        found = true;
+        return true;
+    });
+    return found;
+}
@@ -0,0 +1,112 @@
+#ifndef SUPERFREE_RECORDING_H
+#define SUPERFREE_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "MemInfoParser.h"
+#include "VmStat.h"
+
+/// Size of the file header and of every block of a recording
+const size_t RECORDING_BLOCK_SIZE = 4096;
+
+/// Size of a recording when --record-size is not given, about a week of 1 s samples
+const size_t RECORDING_DEFAULT_SIZE = 32 * 1024 * 1024;
+
+/// One sample of a recording
+struct RecordedSample {
+    /// Wall clock time of the sample in milliseconds since the epoch
+    int64_t timeMs;
+    MemInfoData meminfo;
+    VmStatData vmstat;
+};
+
+
+/// Appends samples to a recording file: a header followed by a ring of fixed-size blocks.
+/// Every block starts from zero, so its first sample is a keyframe, and the next ones
+/// only store a bitmap of the fields that changed and their deltas as zigzag varints.
+/// Which meminfo fields the kernel reported is recorded with the values.
+/// The file is preallocated and mapped, appending a sample makes no system call; once
+/// the ring is full the oldest block is overwritten.
+class Recorder {
+public:
+
+    /// Opens a recording, creating it when it does not exist. An existing recording
+    /// keeps its size and is continued after its newest block.
+    /// Throws std::runtime_error if the file cannot be created or is not a recording
+    /// of this version of superfree.
+    /// \param path Path of the file
+    /// \param size Size of a new file in bytes, at least two blocks
+    Recorder(const std::string &path, size_t size);
+
+    ~Recorder();
+
+    Recorder(const Recorder &) = delete;
+    Recorder &operator=(const Recorder &) = delete;
+
+
+    /// Appends one sample
+    /// \param timeMs Wall clock time of the sample in milliseconds since the epoch
+    /// \param meminfo The parsed meminfo values
+    /// \param vmstat The vmstat counters
+    void append(int64_t timeMs, const MemInfoData &meminfo, const VmStatData &vmstat);
+
+
+    /// Returns the number of blocks of the ring
+    size_t blockCount() const;
+
+private:
+
+    int fd = -1;
+    char *map = nullptr;
+    size_t mapSize = 0;
+    /// Index of the block being filled
+    size_t block = 0;
+    /// Values of the previous sample of the block, the base of the deltas
+    std::vector<uint64_t> previous;
+    int64_t previousTimeMs = 0;
+
+    /// Starts the block after the current one
+    void nextBlock();
+};
+
+
+/// Reads a recording written by Recorder, possibly while it is still being written
+class Replay {
+public:
+
+    /// Maps a recording read-only.
+    /// Throws std::runtime_error if the file cannot be read or is not a recording.
+    /// \param path Path of the file
+    explicit Replay(const std::string &path);
+
+    ~Replay();
+
+    Replay(const Replay &) = delete;
+    Replay &operator=(const Replay &) = delete;
+
+
+    /// Calls callback for every sample between two times, oldest first
+    /// \param fromMs First time in milliseconds since the epoch
+    /// \param toMs Last time in milliseconds since the epoch
+    /// \param callback Called as callback(sample), returning false stops the replay
+    /// \return Number of samples passed to callback
+    size_t forEach(int64_t fromMs, int64_t toMs, const std::function<bool(const RecordedSample &)> &callback) const;
+
+
+    /// Finds the newest sample at or before a time
+    /// \param timeMs Time in milliseconds since the epoch
+    /// \param sample Receives the sample
+    /// \return False if the recording has no sample before timeMs
+    bool at(int64_t timeMs, RecordedSample &sample) const;
+
+private:
+
+    int fd = -1;
+    const char *map = nullptr;
+    size_t mapSize = 0;
+};
+
+#endif //SUPERFREE_RECORDING_H
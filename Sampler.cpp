@@ -0,0 +1,104 @@
+#include "Sampler.h"
+
+#include <ctime>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+const char *const PATH_MEMINFO = "/proc/meminfo";
+
+uint64_t realtimeMs() {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+}
+
+MemInfoReader::MemInfoReader(bool cgroupAware, const std::string &path) {
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error{"Unable to open " + path};
+    if (cgroupAware)
+        limited = limits.open();
+}
+
+MemInfoReader::~MemInfoReader() {
+    if (fd >= 0)
+        close(fd);
+}
+
+bool MemInfoReader::read(MemInfoData &data) const {
+    if (!preadMemInfo(fd, data))
+        return false;
+    if (limited)
+        limits.apply(data);
+    return true;
+}
+
+Sampler::Sampler(unsigned int intervalMs, bool cgroupAware)
+        : reader{cgroupAware}, interval{intervalMs > 0 ? intervalMs : 1} {
+    sample();
+    if (current.load() == nullptr)
+        throw std::runtime_error{std::string{"Unable to read "} + PATH_MEMINFO};
+    thread = std::thread{&Sampler::run, this};
+}
+
+Sampler::~Sampler() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    wakeUp.notify_one();
+    thread.join();
+}
+
+void Sampler::read(Snapshot &snapshot) const {
+    for (;;) {
+        Slot *slot = current.load(std::memory_order_seq_cst);
+        slot->readers.fetch_add(1, std::memory_order_seq_cst);
+        // The slot may have been retired and picked by sample() before readers was raised
+        if (current.load(std::memory_order_seq_cst) == slot) {
+            snapshot = slot->snapshot;
+            slot->readers.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        slot->readers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void Sampler::run() {
+    // Absolute deadlines so the interval does not drift, as watch mode does with timerfd
+    auto deadline = std::chrono::steady_clock::now() + interval;
+    std::unique_lock<std::mutex> lock{mutex};
+    while (!wakeUp.wait_until(lock, deadline, [this] { return stopping; })) {
+        lock.unlock();
+        sample();
+        lock.lock();
+        deadline += interval;
+        const auto now = std::chrono::steady_clock::now();
+        if (deadline < now)
+            deadline = now + interval;
+    }
+}
+
+void Sampler::sample() {
+    Slot *published = current.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    for (Slot &candidate : slots) {
+        if (&candidate != published && candidate.readers.load(std::memory_order_seq_cst) == 0) {
+            slot = &candidate;
+            break;
+        }
+    }
+    // Every other slot is held by a stalled reader: skip this sample rather than wait
+    if (slot == nullptr)
+        return;
+    if (!reader.read(slot->snapshot.meminfo))
+        return;
+    slot->snapshot.timeMs = realtimeMs();
+    slot->snapshot.sequence = ++sequence;
+    current.store(slot, std::memory_order_seq_cst);
+}
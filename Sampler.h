@@ -0,0 +1,154 @@
+#ifndef SUPERFREE_SAMPLER_H
+#define SUPERFREE_SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "CgroupTree.h"
+#include "MemInfoParser.h"
+
+/// Reads /proc/meminfo through a descriptor kept open, replacing the host totals with the
+/// limits of the enclosing cgroup v2 when asked to
+class MemInfoReader {
+public:
+
+    /// Opens a meminfo file, throws std::runtime_error if it cannot be opened
+    /// \param cgroupAware Report the limits of the enclosing cgroup v2 instead of the host
+    /// \param path Path of the file, another one than /proc/meminfo for captured trees
+    explicit MemInfoReader(bool cgroupAware, const std::string &path = "/proc/meminfo");
+
+    ~MemInfoReader();
+
+    MemInfoReader(const MemInfoReader &) = delete;
+    MemInfoReader &operator=(const MemInfoReader &) = delete;
+
+
+    /// Reads the current values with a single pread(2)
+    /// \param data Receives the values, in kB
+    /// \return False if the file could not be read
+    bool read(MemInfoData &data) const;
+
+
+    /// Returns the path of the cgroup whose limits are reported, empty for the host
+    std::string cgroupPath() const {
+        return limited ? limits.path() : "";
+    }
+
+private:
+
+    int fd = -1;
+    CgroupLimits limits;
+    bool limited = false;
+};
+
+
+/// One sample with the figures of the Memory and Swap tables computed
+struct Snapshot {
+    /// Wall clock time of the sample in milliseconds since the epoch
+    uint64_t timeMs = 0;
+    /// Number of the sample, starting at 1
+    uint64_t sequence = 0;
+    /// Every value of /proc/meminfo, in kB or pages
+    MemInfoData meminfo{};
+
+    uint64_t memTotal() const {
+        return meminfo.memTotal;
+    }
+
+    uint64_t memUsed() const {
+        return memInfoUsed(meminfo);
+    }
+
+    uint64_t memAvailable() const {
+        return memInfoAvailable(meminfo);
+    }
+
+    uint64_t swapTotal() const {
+        return meminfo.swapTotal;
+    }
+
+    uint64_t swapUsed() const {
+        return meminfo.swapTotal > meminfo.swapFree ? meminfo.swapTotal - meminfo.swapFree : 0;
+    }
+
+    /// Used memory in tenths of a percent, rounded
+    uint32_t memUsedPermille() const {
+        return permille(memUsed(), memTotal());
+    }
+
+    /// Used swap in tenths of a percent, rounded, 0 without swap
+    uint32_t swapUsedPermille() const {
+        return permille(swapUsed(), swapTotal());
+    }
+
+private:
+
+    static uint32_t permille(uint64_t used, uint64_t total) {
+        return total > 0 ? static_cast<uint32_t>((used * 1000 + total / 2) / total) : 0;
+    }
+};
+
+
+/// Samples /proc/meminfo on a background thread. Every sample is written to a free slot
+/// which is then published with an atomic pointer swap, so read() never blocks, allocates
+/// or makes a syscall, from any number of threads.
+class Sampler {
+public:
+
+    /// Takes a first sample and starts the thread, throws std::runtime_error on failure
+    /// \param intervalMs Milliseconds between samples
+    /// \param cgroupAware Report the limits of the enclosing cgroup v2 instead of the host
+    explicit Sampler(unsigned int intervalMs, bool cgroupAware = true);
+
+    /// Stops the thread
+    ~Sampler();
+
+    Sampler(const Sampler &) = delete;
+    Sampler &operator=(const Sampler &) = delete;
+
+
+    /// Copies the latest sample, lock-free and safe to call from any thread
+    /// \param snapshot Receives the sample
+    void read(Snapshot &snapshot) const;
+
+
+    /// Returns the path of the cgroup whose limits are reported, empty for the host
+    std::string cgroupPath() const {
+        return reader.cgroupPath();
+    }
+
+private:
+
+    /// Slots a sample can be written to while readers copy the published one. A slot is
+    /// reused only when no reader holds it, so one more than the published slot is enough
+    /// unless readers stall for a whole interval.
+    static const size_t SLOT_COUNT = 4;
+
+    struct alignas(64) Slot {
+        /// Readers copying this slot
+        mutable std::atomic<unsigned int> readers{0};
+        Snapshot snapshot;
+    };
+
+    void run();
+
+    /// Takes a sample into a slot no reader holds and publishes it
+    void sample();
+
+    MemInfoReader reader;
+    std::chrono::milliseconds interval;
+    Slot slots[SLOT_COUNT];
+    std::atomic<Slot *> current{nullptr};
+    uint64_t sequence = 0;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+    std::thread thread;
+};
+
+#endif //SUPERFREE_SAMPLER_H
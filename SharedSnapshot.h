@@ -0,0 +1,149 @@
+#ifndef SUPERFREE_SHAREDSNAPSHOT_H
+#define SUPERFREE_SHAREDSNAPSHOT_H
+
+// Layout of the shared-memory segment written by superfree --publish, and a header-only
+// reader for other processes. Link with -lrt on old glibc for shm_open.
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "MemInfoParser.h"
+
+/// Name of the segment when --publish is given without one
+const char *const SHARED_SNAPSHOT_NAME = "/superfree";
+
+/// "SFSNAPSH" in little endian, set once the segment is initialized
+const uint64_t SHARED_SNAPSHOT_MAGIC = 0x4853504153534653ULL;
+
+/// Version of the layout, changes whenever SharedSnapshot does
+const uint32_t SHARED_SNAPSHOT_VERSION = 1;
+
+/// One snapshot, only made of 64-bit words so that readers can copy it with atomic loads
+struct SharedSnapshot {
+    /// Wall clock time of the sample in milliseconds since the epoch
+    uint64_t timeMs;
+    /// Figures of the Memory and Swap tables, in kB
+    uint64_t memTotal;
+    uint64_t memUsed;
+    uint64_t memFree;
+    uint64_t memShared;
+    uint64_t memBuffCache;
+    uint64_t memAvailable;
+    uint64_t swapTotal;
+    uint64_t swapUsed;
+    uint64_t swapFree;
+    /// Bit i is set when field i of MemInfoField was reported by the kernel
+    uint64_t present[(MEMINFO_FIELD_COUNT + 63) / 64];
+    /// Every meminfo field, indexed by MemInfoField
+    uint64_t meminfo[MEMINFO_FIELD_COUNT];
+
+    /// Returns a meminfo field, 0 when the kernel does not report it
+    uint64_t get(MemInfoField field) const {
+        return meminfo[static_cast<size_t>(field)];
+    }
+};
+
+/// The shared-memory segment, a seqlock around one snapshot
+struct SharedSnapshotSegment {
+    uint64_t magic;
+    uint32_t version;
+    /// MEMINFO_FIELD_COUNT of the publisher
+    uint32_t fieldCount;
+    /// Odd while the publisher writes, incremented twice per snapshot
+    alignas(64) uint64_t sequence;
+    alignas(64) uint64_t words[sizeof(SharedSnapshot) / sizeof(uint64_t)];
+};
+
+static_assert(sizeof(SharedSnapshot) % sizeof(uint64_t) == 0, "SharedSnapshot must only hold 64-bit words");
+
+
+/// Writes a snapshot, only one process may publish to a segment
+/// \param segment The mapped segment
+/// \param snapshot The values to publish
+inline void writeSharedSnapshot(SharedSnapshotSegment &segment, const SharedSnapshot &snapshot) {
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(&snapshot);
+    const uint64_t sequence = __atomic_load_n(&segment.sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&segment.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 0; i < sizeof(segment.words) / sizeof(uint64_t); i++)
+        __atomic_store_n(&segment.words[i], words[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&segment.sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+
+/// Copies a consistent snapshot without locking, retrying while the publisher writes
+/// \param segment The mapped segment
+/// \param snapshot Receives the values
+/// \param maxRetries Attempts before giving up
+/// \return False if no consistent snapshot was read, or nothing was published yet
+inline bool readSharedSnapshot(const SharedSnapshotSegment &segment, SharedSnapshot &snapshot,
+                               unsigned int maxRetries = 1000) {
+    uint64_t *words = reinterpret_cast<uint64_t *>(&snapshot);
+    for (unsigned int attempt = 0; attempt < maxRetries; attempt++) {
+        const uint64_t before = __atomic_load_n(&segment.sequence, __ATOMIC_ACQUIRE);
+        if (before == 0)
+            return false;
+        if (before & 1)
+            continue;
+        for (size_t i = 0; i < sizeof(segment.words) / sizeof(uint64_t); i++)
+            words[i] = __atomic_load_n(&segment.words[i], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segment.sequence, __ATOMIC_RELAXED) == before)
+            return true;
+    }
+    return false;
+}
+
+
+/// Maps the segment of a running superfree --publish read-only
+class SharedSnapshotReader {
+public:
+
+    SharedSnapshotReader() = default;
+
+    ~SharedSnapshotReader() {
+        if (segment != nullptr)
+            munmap(const_cast<SharedSnapshotSegment *>(segment), sizeof(SharedSnapshotSegment));
+    }
+
+    SharedSnapshotReader(const SharedSnapshotReader &) = delete;
+    SharedSnapshotReader &operator=(const SharedSnapshotReader &) = delete;
+
+
+    /// Maps the segment
+    /// \param name Name given to --publish
+    /// \return False if the segment does not exist or has another layout
+    bool open(const char *name = SHARED_SNAPSHOT_NAME) {
+        int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        void *address = mmap(nullptr, sizeof(SharedSnapshotSegment), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+            return false;
+        const SharedSnapshotSegment *mapped = static_cast<const SharedSnapshotSegment *>(address);
+        if (__atomic_load_n(&mapped->magic, __ATOMIC_ACQUIRE) != SHARED_SNAPSHOT_MAGIC
+                || mapped->version != SHARED_SNAPSHOT_VERSION || mapped->fieldCount != MEMINFO_FIELD_COUNT) {
+            munmap(address, sizeof(SharedSnapshotSegment));
+            return false;
+        }
+        segment = mapped;
+        return true;
+    }
+
+
+    /// Copies the latest snapshot, see readSharedSnapshot()
+    /// \param snapshot Receives the values
+    /// \return False if no consistent snapshot was read
+    bool read(SharedSnapshot &snapshot) const {
+        return segment != nullptr && readSharedSnapshot(*segment, snapshot);
+    }
+
+private:
+
+    const SharedSnapshotSegment *segment = nullptr;
+};
+
+#endif //SUPERFREE_SHAREDSNAPSHOT_H
@@ -0,0 +1,74 @@
+#include "SnapshotPublisher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <sys/file.h>
+
+void makeSharedSnapshot(const MemInfoData &data, uint64_t timeMs, SharedSnapshot &snapshot) {
+    std::memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.timeMs = timeMs;
+    snapshot.memTotal = data.memTotal;
+    snapshot.memUsed = memInfoUsed(data);
+    snapshot.memFree = data.memFree;
+    snapshot.memShared = data.shmem;
+    snapshot.memBuffCache = memInfoBuffCache(data);
+    snapshot.memAvailable = memInfoAvailable(data);
+    snapshot.swapTotal = data.swapTotal;
+    snapshot.swapUsed = data.swapTotal > data.swapFree ? data.swapTotal - data.swapFree : 0;
+    snapshot.swapFree = data.swapFree;
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (!data.has(field))
+            continue;
+        snapshot.present[i / 64] |= 1ULL << (i % 64);
+        snapshot.meminfo[i] = data.get(field);
+    }
+}
+
+SnapshotPublisher::SnapshotPublisher(const std::string &name) : name{name} {
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error{"Unable to create shared memory " + name + ": " + std::strerror(errno)};
+    // Two writers would break the seqlock, and the first one to exit would remove the segment
+    if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+        int error = errno;
+        close(fd);
+        if (error == EWOULDBLOCK)
+            throw std::runtime_error{"Shared memory " + name + " is already published by another process"};
+        throw std::runtime_error{"Unable to lock shared memory " + name + ": " + std::strerror(error)};
+    }
+    if (ftruncate(fd, sizeof(SharedSnapshotSegment)) < 0) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error{"Unable to size shared memory " + name + ": " + std::strerror(error)};
+    }
+    void *address = mmap(nullptr, sizeof(SharedSnapshotSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error{"Unable to map shared memory " + name + ": " + std::strerror(error)};
+    }
+    segment = static_cast<SharedSnapshotSegment *>(address);
+    segment->version = SHARED_SNAPSHOT_VERSION;
+    segment->fieldCount = MEMINFO_FIELD_COUNT;
+    // A previous publisher may have died while writing: readers see nothing until the first publish
+    __atomic_store_n(&segment->sequence, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&segment->magic, SHARED_SNAPSHOT_MAGIC, __ATOMIC_RELEASE);
+}
+
+SnapshotPublisher::~SnapshotPublisher() {
+    munmap(segment, sizeof(SharedSnapshotSegment));
+    // Removed before the lock is released, so the next publisher creates a new segment
+    shm_unlink(name.c_str());
+    close(fd);
+}
+
+void SnapshotPublisher::publish(const MemInfoData &data) {
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    SharedSnapshot snapshot;
+    makeSharedSnapshot(data, static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000, snapshot);
+    writeSharedSnapshot(*segment, snapshot);
+}
@@ -0,0 +1,44 @@
+#ifndef SUPERFREE_SNAPSHOTPUBLISHER_H
+#define SUPERFREE_SNAPSHOTPUBLISHER_H
+
+#include <string>
+#include "MemInfoParser.h"
+#include "SharedSnapshot.h"
+
+/// Fills a shared snapshot from parsed meminfo values
+/// \param data The parsed meminfo values
+/// \param timeMs Wall clock time of the sample in milliseconds since the epoch
+/// \param snapshot Receives the values
+void makeSharedSnapshot(const MemInfoData &data, uint64_t timeMs, SharedSnapshot &snapshot);
+
+
+/// Owns the shared-memory segment of superfree --publish, removed again on destruction
+class SnapshotPublisher {
+public:
+
+    /// Creates the segment, or takes over the one of a previous publisher that exited. The
+    /// segment stays locked with flock(2) while published, so a second publisher cannot
+    /// write it at the same time. Throws std::runtime_error if it cannot be created, locked
+    /// or mapped.
+    /// \param name POSIX shared memory name, starting with '/'
+    explicit SnapshotPublisher(const std::string &name = SHARED_SNAPSHOT_NAME);
+
+    ~SnapshotPublisher();
+
+    SnapshotPublisher(const SnapshotPublisher &) = delete;
+    SnapshotPublisher &operator=(const SnapshotPublisher &) = delete;
+
+
+    /// Publishes a sample
+    /// \param data The parsed meminfo values
+    void publish(const MemInfoData &data);
+
+private:
+
+    std::string name;
+    /// Descriptor of the segment, kept open to hold the lock
+    int fd = -1;
+    SharedSnapshotSegment *segment = nullptr;
+};
+
+#endif //SUPERFREE_SNAPSHOTPUBLISHER_H
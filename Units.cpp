@@ -0,0 +1,96 @@
+#include "Units.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+const char *const BINARY_UNITS[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB"};
+const char *const SI_UNITS[] = {"B", "kB", "MB", "GB", "TB", "PB", "EB"};
+const unsigned int LARGEST_UNIT = 6;
+
+/// Appends a space and the name of a unit
+size_t appendUnit(char *text, size_t length, const Units &units, unsigned int exponent) {
+    const char *name = (units.si ? SI_UNITS : BINARY_UNITS)[exponent];
+    const size_t size = std::strlen(name);
+    text[length] = ' ';
+    std::memcpy(text + length + 1, name, size);
+    return length + 1 + size;
+}
+
+size_t appendUint(char *text, size_t length, uint64_t value) {
+    return std::to_chars(text + length, text + QUANTITY_TEXT_SIZE, value).ptr - text;
+}
+
+/// Appends a value below 100 given in tenths, e.g. 76 as 7.6
+size_t appendTenths(char *text, size_t length, uint64_t tenths) {
+    length = appendUint(text, length, tenths / 10);
+    text[length] = '.';
+    text[length + 1] = static_cast<char>('0' + tenths % 10);
+    return length + 2;
+}
+
+unsigned int exponentOf(UnitScale scale) {
+    switch (scale) {
+    case UnitScale::Bytes:
+        return 0;
+    case UnitScale::Mega:
+        return 2;
+    case UnitScale::Giga:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+}
+
+uint64_t Units::divisor() const {
+    const uint64_t base = si ? 1000 : 1024;
+    uint64_t result = 1;
+    for (unsigned int i = exponentOf(scale); i > 0; i--)
+        result *= base;
+    return result;
+}
+
+const char *Units::name() const {
+    return (si ? SI_UNITS : BINARY_UNITS)[exponentOf(scale)];
+}
+
+size_t formatQuantity(char *text, Quantity quantity, const Units &units) {
+    const uint64_t bytes = quantity.bytes();
+    if (units.scale != UnitScale::Human)
+        return appendUnit(text, appendUint(text, 0, units.count(quantity)), units, exponentOf(units.scale));
+
+    // Three significant digits at most, like free -h: 512 B, 7.6 GiB, 15 GiB
+    const uint64_t base = units.si ? 1000 : 1024;
+    unsigned int exponent = 0;
+    uint64_t divisor = 1;
+    while (exponent < LARGEST_UNIT && bytes / divisor >= base) {
+        divisor *= base;
+        exponent++;
+    }
+    const uint64_t whole = bytes / divisor;
+    const uint64_t remainder = bytes % divisor;
+    if (exponent > 0 && whole < 10) {
+        const uint64_t tenths = whole * 10 + (remainder * 10 + divisor / 2) / divisor;
+        if (tenths < 100)
+            return appendUnit(text, appendTenths(text, 0, tenths), units, exponent);
+    }
+    const uint64_t rounded = whole + (remainder >= divisor - remainder ? 1 : 0);
+    if (rounded >= base && exponent < LARGEST_UNIT)
+        return appendUnit(text, appendTenths(text, 0, 10), units, exponent + 1);
+    return appendUnit(text, appendUint(text, 0, rounded), units, exponent);
+}
+
+std::string formatQuantity(Quantity quantity, const Units &units) {
+    char text[QUANTITY_TEXT_SIZE];
+    return std::string(text, formatQuantity(text, quantity, units));
+}
+
+size_t formatPercent(char *text, Percent percent) {
+    size_t length = std::to_chars(text, text + 10, percent.tenths() / 10).ptr - text;
+    text[length] = '.';
+    text[length + 1] = static_cast<char>('0' + percent.tenths() % 10);
+    return length + 2;
+}
@@ -0,0 +1,179 @@
+#ifndef SUPERFREE_UNITS_H
+#define SUPERFREE_UNITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// A size in bytes. /proc reports kB, which are kibibytes.
+class Quantity {
+public:
+
+    constexpr Quantity() = default;
+
+
+    /// \param bytes Size in bytes
+    /// \return The quantity
+    static constexpr Quantity fromBytes(uint64_t bytes) {
+        return Quantity{bytes};
+    }
+
+
+    /// \param kib Size in kibibytes, the "kB" of /proc
+    /// \return The quantity
+    static constexpr Quantity fromKiB(uint64_t kib) {
+        return Quantity{kib * 1024};
+    }
+
+
+    constexpr uint64_t bytes() const {
+        return value;
+    }
+
+
+    constexpr Quantity operator+(Quantity other) const {
+        return Quantity{value + other.value};
+    }
+
+
+    /// Subtracts, saturating at 0
+    constexpr Quantity operator-(Quantity other) const {
+        return Quantity{value > other.value ? value - other.value : 0};
+    }
+
+
+    constexpr bool operator==(Quantity other) const {
+        return value == other.value;
+    }
+
+
+    constexpr bool operator!=(Quantity other) const {
+        return value != other.value;
+    }
+
+private:
+
+    constexpr explicit Quantity(uint64_t bytes) : value{bytes} {
+    }
+
+    uint64_t value = 0;
+};
+
+
+/// A fixed-point percentage in tenths of a percent, e.g. 453 is 45.3 %
+class Percent {
+public:
+
+    constexpr Percent() = default;
+
+
+    /// Returns used / total rounded to a tenth of a percent, 0 when total is 0
+    /// \param used Used amount
+    /// \param total Total amount, in the same unit as used
+    static constexpr Percent of(uint64_t used, uint64_t total) {
+        // Amounts above 16 Pi are scaled down so that used * 1000 cannot overflow
+        while (used > UINT64_MAX / 2000 || total > UINT64_MAX / 2000) {
+            used >>= 10;
+            total >>= 10;
+        }
+        return Percent{static_cast<uint32_t>(total > 0 ? (used * 1000 + total / 2) / total : 0)};
+    }
+
+
+    static constexpr Percent of(Quantity used, Quantity total) {
+        return of(used.bytes(), total.bytes());
+    }
+
+
+    constexpr uint32_t tenths() const {
+        return value;
+    }
+
+
+    /// Returns the percentage as a floating-point number, for the alert thresholds
+    constexpr double toDouble() const {
+        return value / 10.0;
+    }
+
+
+    /// Returns the number of the given cells filled by the percentage, rounded
+    /// \param cells Cells of a full bar
+    constexpr unsigned int cells(unsigned int cells) const {
+        return static_cast<unsigned int>((static_cast<uint64_t>(value) * cells + 500) / 1000);
+    }
+
+private:
+
+    constexpr explicit Percent(uint32_t tenths) : value{tenths} {
+    }
+
+    uint32_t value = 0;
+};
+
+
+/// Unit of the sizes shown, as the -b, -k, -m, -g and -h options of free(1)
+enum class UnitScale {
+    Bytes,
+    Kilo,
+    Mega,
+    Giga,
+    /// The largest unit keeping the value below 1024 (1000 with si), e.g. 7.6 GiB
+    Human,
+};
+
+
+/// How sizes are shown by every table and output format but Prometheus, which is
+/// always in bytes
+struct Units {
+    UnitScale scale = UnitScale::Kilo;
+    /// Powers of 1000 (kB, MB, GB) instead of 1024 (KiB, MiB, GiB)
+    bool si = false;
+
+    /// Returns the fixed unit used where a number is expected (JSON, CSV): Human becomes Kilo
+    Units fixed() const {
+        return Units{scale == UnitScale::Human ? UnitScale::Kilo : scale, si};
+    }
+
+
+    /// Returns the number of bytes of one unit of a fixed scale
+    uint64_t divisor() const;
+
+
+    /// Returns the name of a fixed scale, e.g. "KiB", or "kB" with si
+    const char *name() const;
+
+
+    /// Returns a quantity as an integer number of units of a fixed scale, truncated like free(1)
+    uint64_t count(Quantity quantity) const {
+        return quantity.bytes() / divisor();
+    }
+};
+
+
+/// Longest text written by formatQuantity(), a 20 digit byte count and " B"
+const size_t QUANTITY_TEXT_SIZE = 24;
+
+
+/// Formats a size as a number and a unit, e.g. "16324036 KiB" or "15.6 GiB", without
+/// allocating
+/// \param text Receives the text, at least QUANTITY_TEXT_SIZE bytes, not null terminated
+/// \param quantity Size to format
+/// \param units Unit to use
+/// \return Number of bytes written
+size_t formatQuantity(char *text, Quantity quantity, const Units &units);
+
+
+/// Formats a size as a number and a unit for a table cell
+/// \param quantity Size to format
+/// \param units Unit to use
+/// \return The text, e.g. "16324036 KiB"
+std::string formatQuantity(Quantity quantity, const Units &units);
+
+
+/// Formats a percentage with one decimal, e.g. "45.3"
+/// \param text Receives the text, at least 12 bytes, not null terminated
+/// \param percent Percentage to format
+/// \return Number of bytes written
+size_t formatPercent(char *text, Percent percent);
+
+#endif //SUPERFREE_UNITS_H
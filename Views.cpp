@@ -0,0 +1,300 @@
+#include "Views.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include "ConsoleTable.h"
+#include "Parallel.h"
+#include "ProcScan.h"
+
+void renderProcesses(std::string &out, const char *procRoot, size_t top, const Units &units) {
+    ProcessScan scan = scanProcesses(procRoot, top, defaultThreadCount());
+
+    ConsoleTable table{"PID", "COMMAND", "RSS", "PSS", "ANON", "FILE", "SHMEM", "SWAP"};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("Processes (top " + std::to_string(scan.top.size()) + " of "
+                    + std::to_string(scan.processes) + " by PSS, "
+                    + std::to_string(scan.withoutMemory) + " without memory, "
+                    + std::to_string(scan.unreadable) + " unreadable)");
+    auto size = [&](uint64_t kib) { return formatQuantity(Quantity::fromKiB(kib), units); };
+    for (const auto &process : scan.top) {
+        table.addRow(std::vector<std::string>{
+            std::to_string(process.pid),
+            process.command,
+            size(process.rss),
+            "\e[38;5;75m" + size(process.pss) + "\e[0m",
+            size(process.pssAnon),
+            size(process.pssFile),
+            size(process.pssShmem),
+            size(process.swap)});
+    }
+    table.render(out);
+}
+
+void renderCgroups(std::string &out, MemInfo &info, CgroupScanner &scanner) {
+    std::vector<CgroupMemory> cgroups = scanner.scan(defaultThreadCount());
+
+    ConsoleTable table{"CGROUP", "CURRENT", "MAX", "ANON", "FILE", "SHMEM", "SLAB", "SWAP", "USE%"};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("Cgroups (" + std::to_string(cgroups.size()) + ")");
+    auto size = [&](uint64_t bytes) { return info.format(Quantity::fromBytes(bytes)); };
+    for (const auto &cgroup : cgroups) {
+        std::string name = std::string(cgroup.depth * 2, ' ') + (cgroup.path.empty() ? "/" : cgroup.name);
+        if (!cgroup.hasMemory) {
+            if (cgroup.path.empty())
+                table.addRow(std::vector<std::string>{name, info.format(info.memUsed), info.format(info.memTotal),
+                        "-", "-", "-", "-", info.format(info.swapUsed), info.printBar(MemInfo::Memory)});
+            else
+                table.addRow(std::vector<std::string>{name, "-", "-", "-", "-", "-", "-", "-", "-"});
+            continue;
+        }
+        bool limited = cgroup.max != CGROUP_UNLIMITED;
+        const Quantity total = limited ? Quantity::fromBytes(cgroup.max) : info.memTotal;
+        table.addRow(std::vector<std::string>{
+            name,
+            "\e[38;5;75m" + size(cgroup.current) + "\e[0m",
+            limited ? size(cgroup.max) : "max",
+            size(cgroup.anon),
+            size(cgroup.file),
+            size(cgroup.shmem),
+            size(cgroup.slab),
+            size(cgroup.swapCurrent),
+            info.genericPrintBar(Quantity::fromBytes(cgroup.current), total)});
+    }
+    table.render(out);
+}
+
+void renderNuma(std::string &out, MemInfo &info, const NumaNodes &reader, NumaSamples &samples, bool repeat) {
+    std::vector<NumaNode> nodes;
+    reader.read(nodes);
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const double elapsed = (now.tv_sec - samples.time.tv_sec) + (now.tv_nsec - samples.time.tv_nsec) / 1e9;
+    const bool rates = repeat && samples.previous.size() == nodes.size() && elapsed > 0;
+
+    ConsoleTable table{"NODE", "TOTAL", "USED", "FREE", "FILE", "ANON",
+                       repeat ? "MISS/s" : "MISS", repeat ? "FOREIGN/s" : "FOREIGN", "USE%"};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("NUMA nodes (" + std::to_string(nodes.size()) + ")");
+    auto size = [&](uint64_t kib) { return info.format(Quantity::fromKiB(kib)); };
+    auto counter = [&](uint64_t current, uint64_t previous) {
+        if (!repeat)
+            return std::to_string(current);
+        if (!rates)
+            return std::string("-");
+        uint64_t delta = current >= previous ? current - previous : 0;
+        return std::to_string(static_cast<uint64_t>(delta / elapsed + 0.5)) + "/s";
+    };
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const NumaNode &node = nodes[i];
+        const MemInfoData &meminfo = node.meminfo;
+        uint64_t used;
+        if (!memInfoExtra(meminfo, "MemUsed", used))
+            used = meminfo.memTotal > meminfo.memFree ? meminfo.memTotal - meminfo.memFree : 0;
+        uint64_t filePages;
+        if (!memInfoExtra(meminfo, "FilePages", filePages))
+            filePages = meminfo.activeFile + meminfo.inactiveFile;
+        const NumaNode *previous = rates ? &samples.previous[i] : nullptr;
+        table.addRow(std::vector<std::string>{
+            std::to_string(node.id),
+            "\e[38;5;75m" + size(meminfo.memTotal) + "\e[0m",
+            size(used),
+            size(meminfo.memFree),
+            size(filePages),
+            size(meminfo.anonPages),
+            counter(node.numaMiss, previous ? previous->numaMiss : 0),
+            counter(node.numaForeign, previous ? previous->numaForeign : 0),
+            info.genericPrintBar(Quantity::fromKiB(used), Quantity::fromKiB(meminfo.memTotal))});
+    }
+    samples.previous.swap(nodes);
+    samples.time = now;
+
+    table.render(out);
+}
+
+void renderKernel(std::string &out, MemInfo &info, SlabInfoReader &slabinfo, size_t top) {
+    const KernelBreakdown kernel = kernelBreakdown(info.data);
+    ConsoleTable table{"KIND", "SIZE", "OF USED"};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("Kernel memory (" + info.format(Quantity::fromKiB(kernel.total())) + " of "
+                    + info.format(info.memUsed) + " used)");
+    auto addRow = [&](const std::string &kind, uint64_t kib) {
+        const Quantity size = Quantity::fromKiB(kib);
+        char percent[12];
+        const size_t length = formatPercent(percent, Percent::of(size, info.memUsed));
+        table.addRow(std::vector<std::string>{kind, info.format(size), std::string(percent, length) + " %"});
+    };
+    addRow("Slab, reclaimable", kernel.slabReclaimable);
+    addRow("Slab, unreclaimable", kernel.slabUnreclaimable);
+    addRow("Kernel stacks", kernel.kernelStack);
+    addRow("Page tables", kernel.pageTables);
+    if (kernel.secPageTables > 0)
+        addRow("Secondary page tables", kernel.secPageTables);
+    addRow("Vmalloc", kernel.vmalloc);
+    addRow("Per-CPU", kernel.percpu);
+    addRow("Huge pages (" + info.format(Quantity::fromKiB(kernel.hugePagesUsed)) + " mapped)", kernel.hugePages);
+
+    table.render(out);
+
+    SlabScan scan;
+    if (slabinfo.read(top, scan)) {
+        ConsoleTable slabs{"CACHE", "SIZE", "OBJECTS", "ACTIVE", "OBJECT SIZE"};
+        slabs.setPadding(1);
+        slabs.setStyle(4);
+        slabs.setTittle("Slab caches (top " + std::to_string(scan.top.size()) + " of " + std::to_string(scan.caches)
+                        + ", " + info.format(Quantity::fromBytes(scan.bytes)) + " in total)");
+        for (const auto &cache : scan.top) {
+            slabs.addRow(std::vector<std::string>{
+                cache.name,
+                "\e[38;5;75m" + info.format(Quantity::fromBytes(cache.bytes)) + "\e[0m",
+                std::to_string(cache.objects),
+                std::to_string(cache.activeObjects),
+                std::to_string(cache.objectSize) + " B"});
+        }
+        slabs.render(out);
+    } else {
+        out += "Slab caches: slabinfo is not readable";
+        if (slabinfo.openError() != 0)
+            out += std::string(" (") + std::strerror(slabinfo.openError()) + ")";
+        out += slabinfo.openError() == EACCES ? ", run as root\n" : "\n";
+    }
+}
+
+void renderCache(std::string &out, MemInfo &info, PageCacheScanner &scanner, size_t top) {
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const CacheScan scan = scanner.scan(top, defaultThreadCount());
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const long elapsedMs = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+
+    auto percent = [](const CacheUsage &usage) {
+        char text[12];
+        const size_t length = formatPercent(text, Percent::of(usage.cached, usage.size));
+        return std::string(text, length) + " %";
+    };
+    ConsoleTable table{"PATH", "FILES", "SIZE", "CACHED", "CACHED%"};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("Page cache (" + info.format(Quantity::fromBytes(scan.total.cached)) + " of "
+                    + info.format(info.buffCached) + " buff/cache)");
+    for (size_t i = 0; i < scan.paths.size() && i < top; ++i) {
+        const CacheUsage &usage = scan.paths[i];
+        table.addRow(std::vector<std::string>{usage.path, std::to_string(usage.files),
+                info.format(Quantity::fromBytes(usage.size)),
+                "\e[38;5;75m" + info.format(Quantity::fromBytes(usage.cached)) + "\e[0m", percent(usage)});
+    }
+    if (scan.paths.size() > 1)
+        table.addRow(std::vector<std::string>{"total", std::to_string(scan.total.files),
+                info.format(Quantity::fromBytes(scan.total.size)),
+                info.format(Quantity::fromBytes(scan.total.cached)), percent(scan.total)});
+
+    ConsoleTable files{"FILE", "SIZE", "CACHED", "CACHED%"};
+    files.setPadding(1);
+    files.setStyle(4);
+    files.setTittle("Most cached files (top " + std::to_string(scan.files.size()) + ")");
+    for (const auto &file : scan.files) {
+        files.addRow(std::vector<std::string>{file.path, info.format(Quantity::fromBytes(file.size)),
+                "\e[38;5;75m" + info.format(Quantity::fromBytes(file.cached)) + "\e[0m", percent(file)});
+    }
+
+    table.render(out);
+    if (!scan.files.empty())
+        files.render(out);
+    out += std::to_string(scan.total.files) + " files in " + std::to_string(elapsedMs) + " ms, "
+           + std::to_string(scan.skipped) + " unchanged since the last scan, " + std::to_string(scan.unreadable)
+           + " unreadable\n";
+}
+
+void renderFragmentation(std::string &out, MemInfo &info, FragmentationReader &reader, CompactionSamples &samples,
+                         bool repeat) {
+    std::vector<ZoneFreeBlocks> zones;
+    reader.read(zones);
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    unsigned int orders = 0;
+    for (const auto &zone : zones)
+        orders = std::max(orders, zone.orders);
+    // Order of a huge page, 9 for 2 MiB on 4 KiB pages
+    unsigned int hugeOrder = 0;
+    while ((pageSize << (hugeOrder + 1)) <= info.data.hugepageSize * 1024)
+        hugeOrder++;
+    if (hugeOrder == 0 || hugeOrder >= orders)
+        hugeOrder = orders > 0 ? std::min(9u, orders - 1) : 0;
+
+    // Block sizes as short column headers: 4K, 8K, ... 4M
+    auto blockSize = [&](unsigned int order) {
+        const uint64_t kib = (pageSize << order) / 1024;
+        return kib >= 1024 * 1024 ? std::to_string(kib / (1024 * 1024)) + "G"
+               : kib >= 1024 ? std::to_string(kib / 1024) + "M" : std::to_string(kib) + "K";
+    };
+    auto pages = [&](uint64_t count) { return Quantity::fromBytes(count * pageSize); };
+
+    ConsoleTable::Headers headers{"NODE", "ZONE", "FREE"};
+    for (unsigned int order = 0; order < orders; ++order)
+        headers.push_back(blockSize(order));
+    ConsoleTable blocks(headers);
+    blocks.setPadding(1);
+    blocks.setStyle(4);
+    blocks.setTittle("Free blocks per size (/proc/buddyinfo)");
+
+    ConsoleTable table{"NODE", "ZONE", "FREE", "LOW WMARK", "LARGEST",
+                       "UNUSABLE FOR " + blockSize(COSTLY_ORDER), "UNUSABLE FOR " + blockSize(hugeOrder)};
+    table.setPadding(1);
+    table.setStyle(4);
+    table.setTittle("Fragmentation (free memory in blocks too small for an allocation)");
+
+    for (const auto &zone : zones) {
+        const uint64_t free = zone.freePages();
+        std::vector<std::string> row{std::to_string(zone.node), zone.zone, info.format(pages(free))};
+        for (unsigned int order = 0; order < orders; ++order)
+            row.push_back(order < zone.orders ? std::to_string(zone.blocks[order]) : "-");
+        blocks.addRow(row);
+
+        const int largest = zone.largestOrder();
+        table.addRow(std::vector<std::string>{
+            std::to_string(zone.node),
+            zone.zone,
+            "\e[38;5;75m" + info.format(pages(free)) + "\e[0m",
+            zone.managed > 0 ? info.format(pages(zone.watermarkLow)) : "-",
+            largest >= 0 ? blockSize(static_cast<unsigned int>(largest)) : "-",
+            info.genericPrintBar(pages(zone.unusablePages(COSTLY_ORDER)), pages(free)),
+            info.genericPrintBar(pages(zone.unusablePages(hugeOrder)), pages(free))});
+    }
+
+    if (zones.empty())
+        out += "No zone found in buddyinfo\n";
+    blocks.render(out);
+    table.render(out);
+
+    CompactionStats current;
+    if (repeat && reader.readCompaction(current)) {
+        ConsoleTable compaction{"STALLS", "FAILURES", "SUCCESSES", "MIGRATE SCANNED", "FREE SCANNED",
+                                "KCOMPACTD WAKEUPS"};
+        compaction.setPadding(1);
+        compaction.setStyle(4);
+        compaction.setTittle("Compaction (per second)");
+        const double seconds = (current.time.tv_sec - samples.previous.time.tv_sec)
+                               + (current.time.tv_nsec - samples.previous.time.tv_nsec) / 1e9;
+        auto rate = [&](uint64_t now, uint64_t before) {
+            if (!samples.valid || seconds <= 0)
+                return std::string("-");
+            return std::to_string(static_cast<uint64_t>((now > before ? now - before : 0) / seconds + 0.5));
+        };
+        const CompactionStats &previous = samples.previous;
+        const std::string stalls = rate(current.stall, previous.stall);
+        compaction.addRow(std::vector<std::string>{
+            stalls != "0" && stalls != "-" ? "\e[38;5;197m" + stalls + "\e[0m" : stalls,
+            rate(current.fail, previous.fail),
+            rate(current.success, previous.success),
+            rate(current.migrateScanned, previous.migrateScanned),
+            rate(current.freeScanned, previous.freeScanned),
+            rate(current.daemonWake, previous.daemonWake)});
+        compaction.render(out);
+        samples.previous = current;
+        samples.valid = true;
+    }
+}
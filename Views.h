@@ -0,0 +1,86 @@
+#ifndef SUPERFREE_VIEWS_H
+#define SUPERFREE_VIEWS_H
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "CgroupTree.h"
+#include "Fragmentation.h"
+#include "KernelMemory.h"
+#include "MemInfo.h"
+#include "NumaNodes.h"
+#include "PageCache.h"
+#include "Units.h"
+
+// The detailed views of superfree rendered as text. Every function reads its source and
+// appends the tables to out; clearing the screen and writing the text is left to the caller.
+
+
+/// Appends the processes with the highest PSS
+/// \param out Receives the table
+/// \param procRoot Directory to scan, usually /proc
+/// \param top Number of processes shown
+/// \param units Unit of the sizes
+void renderProcesses(std::string &out, const char *procRoot, size_t top, const Units &units);
+
+
+/// Appends the cgroup tree with a usage bar against memory.max, or against the host
+/// memory for unlimited cgroups
+/// \param out Receives the table
+/// \param info Host memory, for the root and the unlimited cgroups
+/// \param scanner Scanner of the cgroup v2 hierarchy
+void renderCgroups(std::string &out, MemInfo &info, CgroupScanner &scanner);
+
+
+/// NUMA counters of the previous refresh, to show numa_miss and numa_foreign rates
+struct NumaSamples {
+    std::vector<NumaNode> previous;
+    timespec time{};
+};
+
+
+/// Appends one row per NUMA node
+/// \param out Receives the table
+/// \param info Unit and bar thresholds
+/// \param reader Reader of /sys/devices/system/node
+/// \param samples Counters of the previous refresh, updated
+/// \param repeat Show numa_miss and numa_foreign in pages per second between refreshes
+/// instead of counters since boot
+void renderNuma(std::string &out, MemInfo &info, const NumaNodes &reader, NumaSamples &samples, bool repeat);
+
+
+/// Appends the kernel memory of meminfo and the slab caches holding most memory
+/// \param out Receives the tables
+/// \param info Memory of the host
+/// \param slabinfo Reader of /proc/slabinfo
+/// \param top Number of slab caches shown
+void renderKernel(std::string &out, MemInfo &info, SlabInfoReader &slabinfo, size_t top);
+
+
+/// Appends the page cache use of the paths scanned and of the most cached files
+/// \param out Receives the tables and a line of scan counters
+/// \param info Memory of the host
+/// \param scanner Scanner of the paths
+/// \param top Number of paths and files shown
+void renderCache(std::string &out, MemInfo &info, PageCacheScanner &scanner, size_t top);
+
+
+/// Compaction counters of the previous refresh, to show rates
+struct CompactionSamples {
+    CompactionStats previous;
+    bool valid = false;
+};
+
+
+/// Appends the free blocks of every zone per order and the share of free memory too
+/// fragmented for costly and huge page allocations
+/// \param out Receives the tables
+/// \param info Memory of the host, for the huge page size
+/// \param reader Reader of buddyinfo, zoneinfo and vmstat
+/// \param samples Compaction counters of the previous refresh, updated
+/// \param repeat Append the compaction rates since the previous refresh
+void renderFragmentation(std::string &out, MemInfo &info, FragmentationReader &reader, CompactionSamples &samples,
+                         bool repeat);
+
+#endif //SUPERFREE_VIEWS_H
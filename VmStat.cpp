@@ -0,0 +1,135 @@
+#include "VmStat.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "MemInfoParser.h"
+
+namespace {
+
+struct FieldInfo {
+    const char *key;
+    size_t length;
+};
+
+const FieldInfo FIELDS[] = {
+#define SUPERFREE_VMSTAT_INFO(key, member) {key, sizeof(key) - 1},
+    SUPERFREE_VMSTAT_FIELDS(SUPERFREE_VMSTAT_INFO)
+#undef SUPERFREE_VMSTAT_INFO
+};
+
+static_assert(sizeof(FIELDS) / sizeof(FIELDS[0]) == VMSTAT_FIELD_COUNT, "Field table out of sync");
+
+/// Marks a line that holds no counter of interest
+const uint8_t NO_FIELD = 0xFF;
+
+/// Finds the counter of a key, only used while resolving the layout
+uint8_t resolveKey(const char *key, size_t length) {
+    for (size_t i = 0; i < VMSTAT_FIELD_COUNT; i++) {
+        if (FIELDS[i].length == length && std::memcmp(FIELDS[i].key, key, length) == 0)
+            return static_cast<uint8_t>(i);
+    }
+    return NO_FIELD;
+}
+
+double perSecond(uint64_t previous, uint64_t current, double seconds) {
+    return current > previous ? (current - previous) / seconds : 0;
+}
+
+}
+
+const char *vmStatKey(VmStatField field) {
+    return FIELDS[static_cast<size_t>(field)].key;
+}
+
+VmStatRates vmStatRates(const VmStatData &previous, const VmStatData &current) {
+    VmStatRates rates{};
+    const double seconds = (current.time.tv_sec - previous.time.tv_sec)
+                           + (current.time.tv_nsec - previous.time.tv_nsec) / 1e9;
+    if (seconds <= 0)
+        return rates;
+    auto rate = [&](VmStatField field) {
+        return perSecond(previous.get(field), current.get(field), seconds);
+    };
+    rates.pgfault = rate(VmStatField::pgfault);
+    rates.pgmajfault = rate(VmStatField::pgmajfault);
+    rates.pswpin = rate(VmStatField::pswpin);
+    rates.pswpout = rate(VmStatField::pswpout);
+    rates.pgscanDirect = rate(VmStatField::pgscanDirect);
+    rates.pgscan = rate(VmStatField::pgscanKswapd) + rates.pgscanDirect
+                   + rate(VmStatField::pgscanKhugepaged) + rate(VmStatField::pgscanProactive);
+    rates.pgsteal = rate(VmStatField::pgstealKswapd) + rate(VmStatField::pgstealDirect)
+                    + rate(VmStatField::pgstealKhugepaged) + rate(VmStatField::pgstealProactive);
+    uint64_t kills = current.get(VmStatField::oomKill);
+    rates.oomKill = kills > previous.get(VmStatField::oomKill) ? kills - previous.get(VmStatField::oomKill) : 0;
+    return rates;
+}
+
+VmStatReader::~VmStatReader() {
+    if (fd >= 0)
+        close(fd);
+}
+
+bool VmStatReader::open(const char *path) {
+    if (fd >= 0)
+        close(fd);
+    layout.clear();
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return fd >= 0;
+}
+
+bool VmStatReader::read(VmStatData &data) {
+    char buffer[VMSTAT_BUFFER_SIZE];
+    ssize_t n = pread(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+        return false;
+    clock_gettime(CLOCK_MONOTONIC, &data.time);
+    parse(buffer, static_cast<size_t>(n), data);
+    return true;
+}
+
+void VmStatReader::parse(const char *buffer, size_t length, VmStatData &data) {
+    if (layout.empty() || !parseCached(buffer, length, data))
+        parseResolving(buffer, length, data);
+}
+
+bool VmStatReader::parseCached(const char *buffer, size_t length, VmStatData &data) const {
+    std::memset(data.values, 0, sizeof(data.values));
+    const char *pos = buffer;
+    const char *end = buffer + length;
+    size_t line = 0;
+    while (pos < end) {
+        if (line == layout.size())
+            return false;
+        const LineSlot slot = layout[line++];
+        const char *key = pos;
+        const char *space = static_cast<const char *>(std::memchr(pos, ' ', end - pos));
+        if (space == nullptr || static_cast<size_t>(space - key) != slot.keyLength)
+            return false;
+        pos = space + 1;
+        if (slot.field != NO_FIELD) {
+            uint64_t value = 0;
+            while (pos < end && static_cast<unsigned char>(*pos - '0') < 10) {
+                value = value * 10 + (*pos - '0');
+                pos++;
+            }
+            data.values[slot.field] = value;
+        }
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (newline == nullptr)
+            break;
+        pos = newline + 1;
+    }
+    return line == layout.size();
+}
+
+void VmStatReader::parseResolving(const char *buffer, size_t length, VmStatData &data) {
+    std::memset(data.values, 0, sizeof(data.values));
+    layout.clear();
+    scanSpaceKeyValues(buffer, length, [&](const char *key, size_t keyLength, uint64_t value) {
+        uint8_t field = resolveKey(key, keyLength);
+        layout.push_back({static_cast<uint16_t>(keyLength), field});
+        if (field != NO_FIELD)
+            data.values[field] = value;
+    });
+}
@@ -0,0 +1,136 @@
+#ifndef SUPERFREE_VMSTAT_H
+#define SUPERFREE_VMSTAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+/// Size of the stack buffer /proc/vmstat is read into, about 200 lines on recent kernels
+const size_t VMSTAT_BUFFER_SIZE = 16384;
+
+/// Counters of /proc/vmstat used by superfree: X(kernel key, member name)
+#define SUPERFREE_VMSTAT_FIELDS(X) \
+    X("pgfault", pgfault) \
+    X("pgmajfault", pgmajfault) \
+    X("pswpin", pswpin) \
+    X("pswpout", pswpout) \
+    X("pgscan_kswapd", pgscanKswapd) \
+    X("pgscan_direct", pgscanDirect) \
+    X("pgscan_khugepaged", pgscanKhugepaged) \
+    X("pgscan_proactive", pgscanProactive) \
+    X("pgsteal_kswapd", pgstealKswapd) \
+    X("pgsteal_direct", pgstealDirect) \
+    X("pgsteal_khugepaged", pgstealKhugepaged) \
+    X("pgsteal_proactive", pgstealProactive) \
+    X("oom_kill", oomKill)
+
+/// Index of every counter of SUPERFREE_VMSTAT_FIELDS
+enum class VmStatField {
+#define SUPERFREE_VMSTAT_ENUM(key, member) member,
+    SUPERFREE_VMSTAT_FIELDS(SUPERFREE_VMSTAT_ENUM)
+#undef SUPERFREE_VMSTAT_ENUM
+};
+
+/// Number of counters of SUPERFREE_VMSTAT_FIELDS
+const size_t VMSTAT_FIELD_COUNT = 0
+#define SUPERFREE_VMSTAT_COUNT(key, member) + 1
+    SUPERFREE_VMSTAT_FIELDS(SUPERFREE_VMSTAT_COUNT)
+#undef SUPERFREE_VMSTAT_COUNT
+    ;
+
+/// One sample of the counters, missing ones stay 0
+struct VmStatData {
+    uint64_t values[VMSTAT_FIELD_COUNT];
+    /// CLOCK_MONOTONIC time of the read
+    timespec time;
+
+    /// Returns the value of a counter
+    uint64_t get(VmStatField field) const {
+        return values[static_cast<size_t>(field)];
+    }
+};
+
+
+/// Returns the kernel key of a counter, e.g. "pgmajfault"
+const char *vmStatKey(VmStatField field);
+
+
+/// Activity between two samples, in events per second
+struct VmStatRates {
+    double pgfault;
+    double pgmajfault;
+    double pswpin;
+    double pswpout;
+    /// Pages scanned by kswapd, direct reclaim, khugepaged and proactive reclaim
+    double pgscan;
+    /// Pages scanned by direct reclaim alone, the allocations that stalled
+    double pgscanDirect;
+    /// Pages reclaimed by every reclaimer
+    double pgsteal;
+    /// OOM kills between the samples, not a rate
+    uint64_t oomKill;
+};
+
+
+/// Computes the rates between two samples of the same reader
+/// \param previous The older sample
+/// \param current The newer sample
+/// \return The rates, all 0 when the samples have the same time
+VmStatRates vmStatRates(const VmStatData &previous, const VmStatData &current);
+
+
+/// Reads /proc/vmstat incrementally. The first read resolves every key and remembers
+/// which line holds which counter; later reads only check the key length of each line
+/// and parse the values of the lines that hold a counter. The layout is resolved again
+/// if it ever changes.
+class VmStatReader {
+public:
+
+    VmStatReader() = default;
+
+    ~VmStatReader();
+
+    VmStatReader(const VmStatReader &) = delete;
+    VmStatReader &operator=(const VmStatReader &) = delete;
+
+
+    /// Opens the file, kept open so that read() only needs a pread(2)
+    /// \param path Path of the file, usually /proc/vmstat
+    /// \return True if the file could be opened, otherwise false
+    bool open(const char *path = "/proc/vmstat");
+
+
+    /// Reads a new sample
+    /// \param data Receives the counters and the time of the read
+    /// \return True if the file could be read, otherwise false
+    bool read(VmStatData &data);
+
+
+    /// Parses vmstat text with the cached layout, resolving it first when needed
+    /// \param buffer Text of the file
+    /// \param length Number of bytes in buffer
+    /// \param data Receives the counters
+    void parse(const char *buffer, size_t length, VmStatData &data);
+
+private:
+
+    /// What the cached layout knows about one line
+    struct LineSlot {
+        uint16_t keyLength;
+        uint8_t field;
+    };
+
+    int fd = -1;
+
+    /// One entry per line of the file, in order
+    std::vector<LineSlot> layout;
+
+    /// Parses with the cached layout, returns false when the layout does not match
+    bool parseCached(const char *buffer, size_t length, VmStatData &data) const;
+
+    /// Parses by resolving every key and rebuilds the layout
+    void parseResolving(const char *buffer, size_t length, VmStatData &data);
+};
+
+#endif //SUPERFREE_VMSTAT_H
@@ -0,0 +1,60 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "Bench.h"
+
+// Replaces the global operator new so that measure() can report allocations per operation.
+// Over-aligned allocations keep the library implementation and are not counted.
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+void *allocate(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *pointer = std::malloc(size != 0 ? size : 1);
+    if (pointer == nullptr)
+        throw std::bad_alloc{};
+    return pointer;
+}
+
+}
+
+uint64_t bench::allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size != 0 ? size : 1);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,56 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "Results.h"
+
+bench::InstructionCounter::InstructionCounter() {
+    perf_event_attr attributes{};
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+bench::InstructionCounter::~InstructionCounter() {
+    if (fd >= 0)
+        close(fd);
+}
+
+uint64_t bench::InstructionCounter::read() const {
+    uint64_t count = 0;
+    if (fd < 0 || ::read(fd, &count, sizeof(count)) != sizeof(count))
+        return 0;
+    return count;
+}
+
+namespace {
+
+unsigned int failures = 0;
+
+}
+
+void bench::fail(const std::string &message) {
+    std::printf("FAILED: %s\n", message.c_str());
+    failures++;
+}
+
+unsigned int bench::failureCount() {
+    return failures;
+}
+
+void bench::report(const std::string &name, const Result &result) {
+    char allocations[32] = "-";
+    if (result.allocationsPerOp >= 0)
+        std::snprintf(allocations, sizeof(allocations), "%.1f", result.allocationsPerOp);
+    char instructions[32] = "-";
+    if (result.instructionsPerOp >= 0)
+        std::snprintf(instructions, sizeof(instructions), "%.0f", result.instructionsPerOp);
+    std::printf("%-48s %14.1f ns/op %10s allocs/op %12s instr/op\n", name.c_str(), result.nsPerOp, allocations,
+                instructions);
+    recordResult(name, result);
+}
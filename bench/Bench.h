@@ -0,0 +1,159 @@
+#ifndef SUPERFREE_BENCH_H
+#define SUPERFREE_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/// Signature of a registered benchmark
+typedef void (*BenchFunction)();
+
+/// A named benchmark of the registry
+struct BenchCase {
+    const char *name;
+    BenchFunction function;
+};
+
+/// Returns every benchmark registered with BENCH()
+inline std::vector<BenchCase> &registry() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+/// Adds a benchmark to the registry during static initialization
+struct Registrar {
+    Registrar(const char *name, BenchFunction function) {
+        registry().push_back({name, function});
+    }
+};
+
+/// Prevents the compiler from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+/// Cost of one operation, negative figures are unknown
+struct Result {
+    double nsPerOp = 0;
+    /// Calls to operator new, on every thread
+    double allocationsPerOp = -1;
+    /// Instructions retired by the calling thread, -1 without perf_event_open
+    double instructionsPerOp = -1;
+
+    /// Scales every figure, e.g. to report the cost of one row of a table
+    Result operator/(double divisor) const {
+        Result result = *this;
+        result.nsPerOp /= divisor;
+        if (result.allocationsPerOp >= 0)
+            result.allocationsPerOp /= divisor;
+        if (result.instructionsPerOp >= 0)
+            result.instructionsPerOp /= divisor;
+        return result;
+    }
+};
+
+
+/// Returns the number of calls to operator new so far, counted by Allocations.cpp
+uint64_t allocationCount();
+
+
+/// Counts the instructions retired by the calling thread with perf_event_open(2)
+class InstructionCounter {
+public:
+
+    /// Opens the counter, available() is false when the kernel or the sandbox refuses it
+    InstructionCounter();
+
+    ~InstructionCounter();
+
+    InstructionCounter(const InstructionCounter &) = delete;
+    InstructionCounter &operator=(const InstructionCounter &) = delete;
+
+    bool available() const {
+        return fd >= 0;
+    }
+
+    /// Returns the instructions retired since the counter was opened, 0 when unavailable
+    uint64_t read() const;
+
+private:
+
+    int fd = -1;
+};
+
+
+/// Runs function until at least minTime has elapsed and returns its cost per call
+/// \param function Callable that performs one operation
+/// \param minTime Minimum measured time in milliseconds
+/// \return Average time, allocations and instructions per operation
+template <typename F>
+Result measure(F function, unsigned int minTime = 200) {
+    typedef std::chrono::steady_clock Clock;
+    for (int i = 0; i < 16; i++)
+        function();
+    static const InstructionCounter instructions;
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    Clock::duration elapsed{};
+    const auto limit = std::chrono::milliseconds(minTime);
+    const uint64_t allocationsBefore = allocationCount();
+    const uint64_t instructionsBefore = instructions.read();
+    while (elapsed < limit) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < batch; i++)
+            function();
+        elapsed += Clock::now() - start;
+        iterations += batch;
+        batch *= 2;
+    }
+    Result result;
+    result.instructionsPerOp = instructions.available()
+        ? static_cast<double>(instructions.read() - instructionsBefore) / iterations : -1;
+    result.allocationsPerOp = static_cast<double>(allocationCount() - allocationsBefore) / iterations;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    return result;
+}
+
+
+/// Prints one result line and keeps it for --save and --compare
+/// \param name Name of the measured operation
+/// \param result Cost of one operation
+void report(const std::string &name, const Result &result);
+
+
+/// Reports a failed check, the run then exits with 1 once every benchmark ran
+/// \param message What went wrong
+void fail(const std::string &message);
+
+
+/// Returns the number of checks failed so far
+unsigned int failureCount();
+
+
+/// Prints one result line measured by hand, without allocation or instruction counts
+/// \param name Name of the measured operation
+/// \param nsPerOp Nanoseconds per operation
+inline void report(const std::string &name, double nsPerOp) {
+    Result result;
+    result.nsPerOp = nsPerOp;
+    report(name, result);
+}
+
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+/// Defines and registers a benchmark function
+#define BENCH(name) \
+    static void name(); \
+    static bench::Registrar BENCH_CONCAT(registrar_, name)(#name, name); \
+    static void name()
+
+#endif //SUPERFREE_BENCH_H
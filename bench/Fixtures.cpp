@@ -0,0 +1,100 @@
+#include "Fixtures.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace {
+
+const char *const CGROUP_FILES[] = {
+    "memory.current", "memory.max", "memory.stat", "memory.swap.current", "memory.swap.max",
+};
+
+void writeFile(const std::string &path, const std::string &content) {
+    std::ofstream(path) << content;
+}
+
+std::string makeTempDirectory(const char *prefix) {
+    std::string pattern = std::string{"/tmp/"} + prefix + "-XXXXXX";
+    if (mkdtemp(&pattern[0]) == nullptr)
+        return "";
+    return pattern;
+}
+
+void writeCgroup(const std::string &dir, const std::string (&contents)[5]) {
+    mkdir(dir.c_str(), 0755);
+    for (size_t i = 0; i < 5; i++)
+        writeFile(dir + "/" + CGROUP_FILES[i], contents[i]);
+}
+
+}
+
+std::string bench::fixturePath(const std::string &name) {
+    return std::string{SUPERFREE_FIXTURES} + "/" + name;
+}
+
+std::string bench::readFixture(const std::string &name) {
+    std::ifstream in(fixturePath(name));
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+std::string bench::createProcTree(unsigned int processes, const std::string &kernel) {
+    const std::string rollup = readFixture("smaps_rollup/" + kernel);
+    std::string root = makeTempDirectory("superfree-proc");
+    for (unsigned int pid = 1; pid <= processes; ++pid) {
+        const std::string dir = root + "/" + std::to_string(pid);
+        mkdir(dir.c_str(), 0755);
+        writeFile(dir + "/smaps_rollup", rollup);
+        writeFile(dir + "/comm", "process-" + std::to_string(pid) + "\n");
+    }
+    return root;
+}
+
+std::string bench::createCgroupTree(unsigned int slices, unsigned int servicesPerSlice) {
+    std::string contents[5];
+    for (size_t i = 0; i < 5; i++)
+        contents[i] = readFixture(std::string{"cgroup/"} + CGROUP_FILES[i]);
+    std::string root = makeTempDirectory("superfree-cgroup");
+    for (unsigned int slice = 0; slice < slices; ++slice) {
+        const std::string sliceDir = root + "/slice" + std::to_string(slice) + ".slice";
+        writeCgroup(sliceDir, contents);
+        for (unsigned int service = 0; service < servicesPerSlice; ++service)
+            writeCgroup(sliceDir + "/service" + std::to_string(service) + ".service", contents);
+    }
+    return root;
+}
+
+std::string bench::createCaptureTree(unsigned int hosts, const std::string &kernel) {
+    const std::string meminfo = readFixture("meminfo/" + kernel);
+    std::string root = makeTempDirectory("superfree-captures");
+    for (unsigned int host = 0; host < hosts; ++host) {
+        const std::string dir = root + "/host" + std::to_string(host);
+        mkdir(dir.c_str(), 0755);
+        mkdir((dir + "/proc").c_str(), 0755);
+        writeFile(dir + "/proc/meminfo", meminfo);
+    }
+    return root;
+}
+
+std::string bench::createFileTree(unsigned int directories, unsigned int filesPerDirectory, size_t fileSize) {
+    const std::string content(fileSize, 'x');
+    std::string root = makeTempDirectory("superfree-files");
+    for (unsigned int directory = 0; directory < directories; ++directory) {
+        // Ten top-level directories, the others below them
+        const std::string parent = root + "/dir" + std::to_string(directory % 10);
+        mkdir(parent.c_str(), 0755);
+        const std::string dir = directory < 10 ? parent : parent + "/sub" + std::to_string(directory);
+        mkdir(dir.c_str(), 0755);
+        for (unsigned int file = 0; file < filesPerDirectory; ++file)
+            writeFile(dir + "/file" + std::to_string(file), content);
+    }
+    return root;
+}
+
+void bench::removeTree(const std::string &root) {
+    if (root.compare(0, 5, "/tmp/") == 0)
+        std::system(("rm -rf '" + root + "'").c_str());
+}
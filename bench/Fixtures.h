@@ -0,0 +1,58 @@
+#ifndef SUPERFREE_BENCH_FIXTURES_H
+#define SUPERFREE_BENCH_FIXTURES_H
+
+#include <cstddef>
+#include <string>
+
+// Files recorded from real kernels under bench/fixtures, so results do not depend on the
+// machine running the benchmarks: meminfo/<kernel>, vmstat/<kernel>, smaps_rollup/<kernel>,
+// slabinfo/<kernel>, buddyinfo/<kernel>, zoneinfo/<kernel> and the memory files of one
+// cgroup v2 in cgroup/.
+
+namespace bench {
+
+/// Returns the path of a recorded file, e.g. fixturePath("meminfo/linux-6.18")
+std::string fixturePath(const std::string &name);
+
+
+/// Returns the content of a recorded file, empty if it is missing
+std::string readFixture(const std::string &name);
+
+
+/// Creates a /proc-like tree whose processes all have the recorded smaps_rollup of a kernel
+/// \param processes Number of process directories
+/// \param kernel Fixture name below smaps_rollup/
+/// \return Path of the tree, remove it with removeTree()
+std::string createProcTree(unsigned int processes, const std::string &kernel = "linux-6.18");
+
+
+/// Creates a cgroup v2-like tree of slices holding services, every cgroup with the recorded
+/// memory files of cgroup/
+/// \param slices Number of cgroups below the root
+/// \param servicesPerSlice Number of cgroups below every slice
+/// \return Path of the tree, remove it with removeTree()
+std::string createCgroupTree(unsigned int slices, unsigned int servicesPerSlice);
+
+
+/// Creates a directory of captured hosts, each one with the recorded meminfo of a kernel
+/// as <host>/proc/meminfo, the layout of extracted sosreports
+/// \param hosts Number of host directories
+/// \param kernel Fixture name below meminfo/
+/// \return Path of the tree, remove it with removeTree()
+std::string createCaptureTree(unsigned int hosts, const std::string &kernel = "linux-6.18");
+
+
+/// Creates a tree of directories holding small files, for the page cache scan
+/// \param directories Number of directories, nested two levels deep
+/// \param filesPerDirectory Number of files of every directory
+/// \param fileSize Size of every file in bytes
+/// \return Path of the tree, remove it with removeTree()
+std::string createFileTree(unsigned int directories, unsigned int filesPerDirectory, size_t fileSize);
+
+
+/// Removes a tree created by one of the functions above
+void removeTree(const std::string &root);
+
+}
+
+#endif //SUPERFREE_BENCH_FIXTURES_H
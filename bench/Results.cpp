@@ -0,0 +1,72 @@
+#include "Results.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::string currentBenchmark;
+
+std::vector<bench::NamedResult> &results() {
+    static std::vector<bench::NamedResult> recorded;
+    return recorded;
+}
+
+}
+
+void bench::setCurrentBenchmark(const char *name) {
+    currentBenchmark = name;
+}
+
+void bench::recordResult(const std::string &name, const Result &result) {
+    results().push_back({currentBenchmark + "/" + name, result});
+}
+
+const std::vector<bench::NamedResult> &bench::recordedResults() {
+    return results();
+}
+
+bool bench::saveResults(const char *path) {
+    std::ofstream out(path);
+    for (const auto &entry : results())
+        out << entry.name << '\t' << entry.result.nsPerOp << '\t' << entry.result.allocationsPerOp << '\t'
+            << entry.result.instructionsPerOp << '\n';
+    return static_cast<bool>(out);
+}
+
+bool bench::compareResults(const char *path, double tolerance, unsigned int &regressions) {
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    regressions = 0;
+    const double factor = 1 + tolerance / 100;
+    for (std::string line; std::getline(in, line);) {
+        std::istringstream fields(line);
+        std::string name;
+        Result base;
+        if (!std::getline(fields, name, '\t')
+                || !(fields >> base.nsPerOp >> base.allocationsPerOp >> base.instructionsPerOp))
+            continue;
+        for (const auto &entry : results()) {
+            if (entry.name != name)
+                continue;
+            const Result &now = entry.result;
+            const char *reason = nullptr;
+            if (base.allocationsPerOp >= 0 && now.allocationsPerOp >= 0
+                    && now.allocationsPerOp > base.allocationsPerOp + 0.5)
+                reason = "allocations";
+            else if (base.instructionsPerOp >= 0 && now.instructionsPerOp >= 0)
+                reason = now.instructionsPerOp > base.instructionsPerOp * factor ? "instructions" : nullptr;
+            else if (now.nsPerOp > base.nsPerOp * factor)
+                reason = "time";
+            if (reason != nullptr) {
+                regressions++;
+                std::printf("REGRESSION %-60s %s: %.1f ns %.1f allocs %.0f instr, baseline %.1f ns %.1f allocs "
+                            "%.0f instr\n", name.c_str(), reason, now.nsPerOp, now.allocationsPerOp,
+                            now.instructionsPerOp, base.nsPerOp, base.allocationsPerOp, base.instructionsPerOp);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef SUPERFREE_BENCH_RESULTS_H
+#define SUPERFREE_BENCH_RESULTS_H
+
+#include <string>
+#include <vector>
+#include "Bench.h"
+
+namespace bench {
+
+/// A reported result, named "<benchmark>/<operation>"
+struct NamedResult {
+    std::string name;
+    Result result;
+};
+
+
+/// Sets the benchmark whose results report() records next
+void setCurrentBenchmark(const char *name);
+
+
+/// Keeps a result for saveResults() and compareResults()
+void recordResult(const std::string &name, const Result &result);
+
+
+/// Returns every result recorded so far
+const std::vector<NamedResult> &recordedResults();
+
+
+/// Writes the recorded results as tab separated lines: name, ns/op, allocs/op, instr/op
+/// \param path File to write
+/// \return False if the file could not be written
+bool saveResults(const char *path);
+
+
+/// Compares the recorded results with a file written by saveResults(). A result regresses
+/// when its time grows by more than tolerance percent, when it allocates more, or when it
+/// retires more than tolerance percent more instructions. Results missing from either side
+/// are ignored.
+/// \param path Baseline file
+/// \param tolerance Allowed growth of time and instructions, in percent
+/// \param regressions Receives the number of regressed results
+/// \return False if the baseline could not be read
+bool compareResults(const char *path, double tolerance, unsigned int &regressions);
+
+}
+
+#endif //SUPERFREE_BENCH_RESULTS_H
@@ -0,0 +1,32 @@
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../BatchAnalysis.h"
+#include "../Parallel.h"
+
+BENCH(batch) {
+    std::vector<unsigned int> threadCounts = {1};
+    if (defaultThreadCount() > 1)
+        threadCounts.push_back(defaultThreadCount());
+
+    for (unsigned int hosts : {100u, 5000u}) {
+        const std::string root = bench::createCaptureTree(hosts);
+        for (unsigned int threads : threadCounts) {
+            bench::report("analyze " + std::to_string(hosts) + " captured hosts, " + std::to_string(threads)
+                          + " threads", bench::measure([&] {
+                size_t files;
+                bench::doNotOptimize(analyzeCaptures({root}, threads, files).size());
+            }, 1000));
+        }
+        bench::removeTree(root);
+    }
+
+    std::string log;
+    const std::string dump = bench::readFixture("meminfo/linux-6.18");
+    for (unsigned int i = 0; i < 1000; i++)
+        log += dump;
+    bench::report("split and parse a log of 1000 dumps", bench::measure([&] {
+        bench::doNotOptimize(forEachMemInfoSnapshot(log.data(), log.size(), [](const MemInfoData &) {}));
+    }));
+}
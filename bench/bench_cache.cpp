@@ -0,0 +1,29 @@
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../PageCache.h"
+#include "../Parallel.h"
+
+BENCH(cache) {
+    std::vector<unsigned int> threadCounts = {1};
+    if (defaultThreadCount() > 1)
+        threadCounts.push_back(defaultThreadCount());
+
+    // 20000 files of 8 KiB in 200 directories
+    const std::string root = bench::createFileTree(200, 100, 8192);
+    for (unsigned int threads : threadCounts) {
+        bench::report("full scan of 20000 files, " + std::to_string(threads) + " threads", bench::measure([&] {
+            PageCacheScanner scanner({root});
+            bench::doNotOptimize(scanner.scan(20, threads).total.cached);
+        }, 1000));
+
+        PageCacheScanner scanner({root});
+        scanner.scan(20, threads);
+        bench::report("rescan of 20000 unchanged files, " + std::to_string(threads) + " threads",
+                      bench::measure([&] {
+            bench::doNotOptimize(scanner.scan(20, threads).skipped);
+        }, 1000));
+    }
+    bench::removeTree(root);
+}
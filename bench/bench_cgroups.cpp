@@ -0,0 +1,53 @@
+#include <fstream>
+#include <string>
+#include <utility>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../CgroupTree.h"
+#include "../MemInfoParser.h"
+#include "../Parallel.h"
+
+BENCH(cgroups) {
+    const std::pair<unsigned int, unsigned int> sizes[] = {{10, 10}, {30, 100}};
+    for (const auto &size : sizes) {
+        const std::string root = bench::createCgroupTree(size.first, size.second);
+        const std::string count = std::to_string(size.first * size.second + size.first);
+        bench::report("first scan of " + count + " cgroups (open every directory)", bench::measure([&] {
+            CgroupScanner scanner(root);
+            bench::doNotOptimize(scanner.scan(defaultThreadCount()).size());
+        }, 1000));
+        CgroupScanner scanner(root);
+        scanner.scan(defaultThreadCount());
+        bench::report("repeat scan of " + count + " cgroups (reused fds)", bench::measure([&] {
+            bench::doNotOptimize(scanner.scan(defaultThreadCount()).size());
+        }, 1000));
+        bench::removeTree(root);
+    }
+}
+
+BENCH(cgroup_limits) {
+    // A container root limited to 2 GiB whose processes run in an unlimited child
+    const std::string root = bench::createCgroupTree(1, 1);
+    const std::string path = "/slice0.slice/service0.service";
+    std::ofstream(root + "/slice0.slice/memory.max") << "2147483648\n";
+    std::ofstream(root + path + "/memory.max") << "max\n";
+    const std::string meminfo = bench::readFixture("meminfo/linux-6.18");
+    MemInfoData host{};
+    parseMemInfo(meminfo.data(), meminfo.size(), host);
+
+    CgroupLimits limits;
+    MemInfoData data = host;
+    if (!limits.open(root, path) || !limits.apply(data) || data.memTotal != 2097152)
+        bench::fail("the 2 GiB limit of the parent gives a total of " + std::to_string(data.memTotal)
+                    + " kB to its unlimited child");
+
+    bench::report("open the limits of a cgroup 2 levels deep", bench::measure([&] {
+        CgroupLimits opened;
+        bench::doNotOptimize(opened.open(root, path));
+    }, 1000));
+    bench::report("apply the limits (pread memory.current + memory.stat)", bench::measure([&] {
+        data = host;
+        bench::doNotOptimize(limits.apply(data));
+    }, 100000));
+    bench::removeTree(root);
+}
@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <vector>
+#include "Bench.h"
+#include "../MemInfo.h"
+#include "../MemoryTables.h"
+#include "../OutputWriter.h"
+
+extern char **environ;
+
+namespace {
+
+/// Runs of the binary per startup figure
+const unsigned int STARTUP_RUNS = 50;
+
+/// Refreshes of the watch mode runs, the per-tick cost is the CPU time above a single print
+const unsigned int WATCH_TICKS = 500;
+
+/// Process cost measured by wait4(2)
+struct RunCost {
+    double wallNs = 0;
+    double cpuNs = 0;
+};
+
+double toNs(const timeval &time) {
+    return time.tv_sec * 1e9 + time.tv_usec * 1e3;
+}
+
+/// Runs superfree with its output sent to /dev/null
+bool runSuperfree(const std::vector<std::string> &arguments, RunCost &cost) {
+    std::vector<char *> argv;
+    std::string binary = SUPERFREE_BINARY;
+    argv.push_back(&binary[0]);
+    std::vector<std::string> copies = arguments;
+    for (auto &argument : copies)
+        argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+    const auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int error = posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0)
+        return false;
+    int status;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0)
+        return false;
+    cost.wallNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    cost.cpuNs = toNs(usage.ru_utime) + toNs(usage.ru_stime);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/// Average cost of runs of superfree
+bool averageRuns(const std::vector<std::string> &arguments, unsigned int runs, RunCost &average) {
+    average = RunCost{};
+    for (unsigned int i = 0; i < runs; i++) {
+        RunCost cost;
+        if (!runSuperfree(arguments, cost))
+            return false;
+        average.wallNs += cost.wallNs / runs;
+        average.cpuNs += cost.cpuNs / runs;
+    }
+    return true;
+}
+
+}
+
+BENCH(cli) {
+    bench::report("MemInfo construction (open, cgroup, first read)", bench::measure([] {
+        MemInfo info(true);
+        bench::doNotOptimize(info.data.memTotal);
+    }));
+
+    MemInfo info(true);
+    bench::report("MemInfo::refresh (pread, parse, convert)", bench::measure([&] {
+        info.refresh();
+        bench::doNotOptimize(info.memUsed.bytes());
+    }));
+    bench::report("genericPrintBar (percentage and hashes)", bench::measure([&] {
+        bench::doNotOptimize(info.genericPrintBar(info.memUsed, info.memTotal).size());
+    }));
+
+    MemoryTables tables;
+    std::ostringstream out;
+    tables.update(info);
+    tables.print(out);
+    bench::report("table print (update + render 3 tables)", bench::measure([&] {
+        out.str(std::string());
+        tables.update(info);
+        tables.print(out);
+        bench::doNotOptimize(out.tellp());
+    }));
+    bench::report("watch tick, tables (refresh + update + redraw)", bench::measure([&] {
+        out.str(std::string());
+        info.refresh();
+        tables.update(info);
+        tables.redraw(out);
+        bench::doNotOptimize(out.tellp());
+    }));
+    OutputBuffer buffer(-1);
+    bench::report("watch tick, --json (refresh + writeJson)", bench::measure([&] {
+        info.refresh();
+        writeJson(buffer, info.data);
+        buffer.clear();
+    }));
+}
+
+BENCH(startup) {
+    // End to end through the real binary, what regressions are gated on
+    const std::vector<std::vector<std::string>> modes = {{}, {"--json"}, {"--prom"}};
+    for (const auto &mode : modes) {
+        const std::string name = "superfree" + (mode.empty() ? std::string{} : " " + mode[0]);
+        RunCost cost;
+        if (!averageRuns(mode, STARTUP_RUNS, cost)) {
+            std::printf("unable to run %s\n", SUPERFREE_BINARY);
+            return;
+        }
+        bench::report("startup to exit, wall: " + name, cost.wallNs);
+        bench::report("startup to exit, CPU: " + name, cost.cpuNs);
+    }
+
+    const std::string ticks = std::to_string(WATCH_TICKS + 1);
+    const std::vector<std::vector<std::string>> watchModes = {{}, {"--json"}};
+    for (const auto &mode : watchModes) {
+        std::vector<std::string> once = mode;
+        once.insert(once.end(), {"-s", "0.001", "-c", "1"});
+        std::vector<std::string> watch = mode;
+        watch.insert(watch.end(), {"-s", "0.001", "-c", ticks});
+        RunCost single;
+        RunCost repeated;
+        if (!averageRuns(once, 10, single) || !averageRuns(watch, 3, repeated))
+            return;
+        const std::string name = "superfree -s" + (mode.empty() ? std::string{} : " " + mode[0]);
+        bench::report("watch tick CPU: " + name, (repeated.cpuNs - single.cpuNs) / WATCH_TICKS);
+    }
+}
@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <random>
+#include <string>
+#include "Bench.h"
+#include "../DisplayWidth.h"
+
+namespace {
+
+/// Pieces mixed by the property check: ASCII, escapes, multi-byte, wide, combining and invalid bytes
+const char *const PIECES[] = {
+    "a", "Z", " ", "0123456789abcdef", "\e[38;5;148m", "\e[0m", "\e[1;31m", "\e]0;title\a", "\ec",
+    "\x7f", "\t", "━", "╭", "─", "é", "e\xcc\x81", "日本", "한", "😀", "\xff", "\xc3", "\xe2\x94",
+    "\xf0\x9f\x98", "\e", "\e[", "[##......]", "6147400 kB",
+};
+
+std::string randomText(std::mt19937 &random, size_t pieces) {
+    std::string text;
+    std::uniform_int_distribution<size_t> pick(0, sizeof(PIECES) / sizeof(PIECES[0]) - 1);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (size_t i = 0; i < pieces; ++i) {
+        if (random() % 8 == 0)
+            text += static_cast<char>(byte(random));
+        else
+            text += PIECES[pick(random)];
+    }
+    return text;
+}
+
+/// Writes a text with every byte outside printable ASCII as \xNN, for the failure message
+std::string escaped(const std::string &text) {
+    std::string out;
+    for (unsigned char c : text) {
+        if (c >= 0x20 && c < 0x7F && c != '\\') {
+            out += static_cast<char>(c);
+        } else {
+            char hex[5];
+            std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out += hex;
+        }
+    }
+    return out;
+}
+
+}
+
+BENCH(display_width) {
+    // Every implementation the CPU supports, not only the one displayWidth() selects
+    const struct {
+        DisplayWidthPath path;
+        const char *name;
+    } paths[] = {{DisplayWidthPath::Sse2, "SSE2"}, {DisplayWidthPath::Avx2, "AVX2"}};
+    const size_t CASES = 200000;
+    for (const auto &path : paths) {
+        if (!displayWidthAvailable(path.path))
+            continue;
+        std::mt19937 random(42);
+        bool matches = true;
+        for (size_t i = 0; i < CASES && matches; ++i) {
+            std::string text = randomText(random, random() % 40);
+            for (size_t start = 0; start < 3 && start <= text.size() && matches; ++start) {
+                size_t expected = displayWidthScalar(text.data() + start, text.size() - start);
+                size_t actual = displayWidthWith(path.path, text.data() + start, text.size() - start);
+                if (expected != actual) {
+                    bench::fail(std::string{path.name} + " displayWidth is " + std::to_string(actual)
+                                + " instead of " + std::to_string(expected) + " for \""
+                                + escaped(text.substr(start)) + "\"");
+                    matches = false;
+                }
+            }
+        }
+        if (matches)
+            std::printf("%-48s %14zu cases\n", (std::string{path.name} + " matches scalar reference").c_str(), CASES);
+    }
+
+    const std::string ascii(4096, 'x');
+    const std::string cell = "\e[38;5;148m[##....................] 8.0 %\e[0m";
+    bench::report("displayWidthScalar 4 KiB ASCII", bench::measure([&] {
+        bench::doNotOptimize(displayWidthScalar(ascii.data(), ascii.size()));
+    }));
+    bench::report("displayWidth 4 KiB ASCII", bench::measure([&] {
+        bench::doNotOptimize(displayWidth(ascii.data(), ascii.size()));
+    }));
+    bench::report("displayWidthScalar colored bar cell", bench::measure([&] {
+        bench::doNotOptimize(displayWidthScalar(cell.data(), cell.size()));
+    }));
+    bench::report("displayWidth colored bar cell", bench::measure([&] {
+        bench::doNotOptimize(displayWidth(cell.data(), cell.size()));
+    }));
+}
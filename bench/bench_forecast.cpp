@@ -0,0 +1,86 @@
+#include <cmath>
+#include <deque>
+#include <string>
+#include <utility>
+#include "Bench.h"
+#include "../Forecast.h"
+
+namespace {
+
+/// Fits the whole window again at every sample, kept as reference
+class RefitTrend {
+public:
+
+    void add(double seconds, double value) {
+        samples.emplace_back(seconds, value);
+        if (samples.size() > FORECAST_WINDOW)
+            samples.pop_front();
+    }
+
+    double slope() const {
+        double meanT = 0, meanV = 0;
+        for (const auto &sample : samples) {
+            meanT += sample.first;
+            meanV += sample.second;
+        }
+        meanT /= samples.size();
+        meanV /= samples.size();
+        double covariance = 0, variance = 0;
+        for (const auto &sample : samples) {
+            covariance += (sample.first - meanT) * (sample.second - meanV);
+            variance += (sample.first - meanT) * (sample.first - meanT);
+        }
+        return variance > 0 ? covariance / variance : 0;
+    }
+
+private:
+
+    std::deque<std::pair<double, double>> samples;
+};
+
+/// Available memory of a host with 64 GiB leaking 1 MiB per second, with noise
+double sampleValue(uint64_t i) {
+    return 48.0 * 1024 * 1024 * 1024 - static_cast<double>(i) * 1024 * 1024
+           + static_cast<double>((i * 7919) % 4096) * 4096;
+}
+
+}
+
+BENCH(forecast) {
+    // The incremental sums must give the slope of a full fit, also after days of samples
+    Trend trend;
+    RefitTrend refit;
+    const double start = 3.0e6;
+    double worst = 0;
+    for (uint64_t i = 0; i < 200000; i++) {
+        trend.add(start + static_cast<double>(i), sampleValue(i));
+        refit.add(start + static_cast<double>(i), sampleValue(i));
+        if (i % 997 == 0)
+            worst = std::fmax(worst, std::fabs(trend.slope() - refit.slope()));
+    }
+    if (worst > 1e-3 * 1024 * 1024)
+        bench::fail("the incremental fit differs from a full fit by " + std::to_string(worst) + " bytes/s");
+
+    uint64_t i = 0;
+    bench::report("full refit of the window per sample", bench::measure([&] {
+        refit.add(start + static_cast<double>(i), sampleValue(i));
+        bench::doNotOptimize(refit.slope());
+        i++;
+    }));
+    i = 0;
+    bench::report("Trend::add + slope per sample", bench::measure([&] {
+        trend.add(start + static_cast<double>(i), sampleValue(i));
+        bench::doNotOptimize(trend.slope());
+        i++;
+    }));
+
+    ExhaustionForecast forecast(5);
+    const Quantity total = Quantity::fromKiB(64 * 1024 * 1024);
+    i = 0;
+    bench::report("ExhaustionForecast::addAt + memory + swap", bench::measure([&] {
+        forecast.addAt(start + static_cast<double>(i), Quantity::fromBytes(static_cast<uint64_t>(sampleValue(i))),
+                       total, total, total);
+        bench::doNotOptimize(forecast.memory().seconds + forecast.swap().seconds);
+        i++;
+    }));
+}
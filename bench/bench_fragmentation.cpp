@@ -0,0 +1,60 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../Fragmentation.h"
+
+namespace {
+
+/// A straightforward istringstream parser of buddyinfo, kept as reference
+uint64_t streamFreePages(const std::string &text) {
+    uint64_t pages = 0;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string label, node, zoneLabel, zone;
+        fields >> label >> node >> zoneLabel >> zone;
+        uint64_t count;
+        for (unsigned int order = 0; fields >> count; ++order)
+            pages += count << order;
+    }
+    return pages;
+}
+
+}
+
+BENCH(fragmentation) {
+    const std::string buddyinfo = bench::readFixture("buddyinfo/linux-6.18");
+    const std::string zoneinfo = bench::readFixture("zoneinfo/linux-6.18");
+
+    bench::report("istringstream buddyinfo", bench::measure([&] {
+        bench::doNotOptimize(streamFreePages(buddyinfo));
+    }));
+
+    std::vector<ZoneFreeBlocks> zones;
+    bench::report("parseBuddyInfo", bench::measure([&] {
+        parseBuddyInfo(buddyinfo.data(), buddyinfo.size(), zones);
+        bench::doNotOptimize(zones.front().freePages());
+    }));
+
+    bench::report("parseBuddyInfo + parseZoneInfo", bench::measure([&] {
+        parseBuddyInfo(buddyinfo.data(), buddyinfo.size(), zones);
+        parseZoneInfo(zoneinfo.data(), zoneinfo.size(), zones);
+        bench::doNotOptimize(zones.front().watermarkLow);
+    }));
+
+    FragmentationReader reader;
+    if (reader.isOpen()) {
+        bench::report("FragmentationReader::read /proc", bench::measure([&] {
+            reader.read(zones);
+            bench::doNotOptimize(zones.size());
+        }));
+        CompactionStats stats;
+        bench::report("FragmentationReader::readCompaction /proc", bench::measure([&] {
+            reader.readCompaction(stats);
+            bench::doNotOptimize(stats.stall);
+        }));
+    }
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../KernelMemory.h"
+
+namespace {
+
+/// A straightforward istringstream parser with a full sort, kept as reference
+std::vector<std::pair<uint64_t, std::string>> streamTopSlabs(const std::string &text, uint64_t pageSize,
+                                                             size_t topCount) {
+    std::vector<std::pair<uint64_t, std::string>> caches;
+    std::istringstream in(text);
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        std::string name, label;
+        uint64_t active, objects, size, perSlab, pagesPerSlab, limit, batch, shared, activeSlabs, slabs;
+        fields >> name >> active >> objects >> size >> perSlab >> pagesPerSlab >> label >> label >> limit >> batch
+               >> shared >> label >> label >> activeSlabs >> slabs;
+        caches.emplace_back(slabs * pagesPerSlab * pageSize, name);
+    }
+    std::sort(caches.begin(), caches.end(), std::greater<std::pair<uint64_t, std::string>>());
+    caches.resize(std::min(topCount, caches.size()));
+    return caches;
+}
+
+}
+
+BENCH(kernel) {
+    const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const std::string fixture = bench::readFixture("slabinfo/linux-6.18");
+
+    bench::report("istringstream slabinfo + full sort, top 20", bench::measure([&] {
+        bench::doNotOptimize(streamTopSlabs(fixture, pageSize, 20).size());
+    }));
+
+    std::vector<SlabCache> caches;
+    SlabScan scan;
+    bench::report("parseSlabInfo + partial sort, top 20", bench::measure([&] {
+        parseSlabInfo(fixture.data(), fixture.size(), pageSize, caches);
+        selectTopSlabs(caches, 20, scan);
+        bench::doNotOptimize(scan.bytes);
+    }));
+
+    SlabInfoReader reader;
+    if (reader.isOpen()) {
+        bench::report("SlabInfoReader::read /proc/slabinfo, top 20", bench::measure([&] {
+            reader.read(20, scan);
+            bench::doNotOptimize(scan.bytes);
+        }));
+    }
+}
@@ -0,0 +1,101 @@
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../MemInfoParser.h"
+
+namespace {
+
+const char *PATH_MEMINFO = "/proc/meminfo";
+
+/// Copy of the original std::ifstream / std::map / std::string parser, kept as reference
+struct LegacyMemInfo {
+    std::string memTotal, memFree, memAvailable, memBuffers, memCached, swapTotal, swapFree;
+
+    const std::map<std::string, std::string LegacyMemInfo::*> optionStrings {
+        {"MemTotal", &LegacyMemInfo::memTotal},
+        {"MemFree", &LegacyMemInfo::memFree},
+        {"MemAvailable", &LegacyMemInfo::memAvailable},
+        {"Buffers", &LegacyMemInfo::memBuffers},
+        {"Cached", &LegacyMemInfo::memCached},
+        {"SwapTotal", &LegacyMemInfo::swapTotal},
+        {"SwapFree", &LegacyMemInfo::swapFree}
+    };
+
+    static std::string cleanData(const std::string &str) {
+        std::string data = str.substr(str.find(':') + 1);
+        data.erase(0, data.find_first_not_of(' '));
+        data.resize(data.size() - 3);
+        return data;
+    }
+
+    void parse(std::istream &in) {
+        for (std::string line; getline(in, line);) {
+            auto itr = optionStrings.find(line.substr(0, line.find(':')));
+            if (itr != optionStrings.end())
+                this->*(itr->second) = cleanData(line);
+        }
+    }
+
+    long used() const {
+        return std::stol(memTotal) - std::stol(memAvailable);
+    }
+};
+
+std::string slurp(const char *path) {
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+}
+
+BENCH(meminfo) {
+    const std::string content = slurp(PATH_MEMINFO);
+
+    bench::report("legacy parse (istringstream + map)", bench::measure([&] {
+        std::istringstream in(content);
+        LegacyMemInfo info;
+        info.parse(in);
+        bench::doNotOptimize(info.used());
+    }));
+
+    bench::report("parseMemInfo (in place)", bench::measure([&] {
+        MemInfoData data;
+        parseMemInfo(content.data(), content.size(), data);
+        bench::doNotOptimize(data.memTotal - data.memAvailable);
+    }));
+
+    bench::report("legacy read (ifstream + getline)", bench::measure([&] {
+        std::ifstream in(PATH_MEMINFO);
+        LegacyMemInfo info;
+        info.parse(in);
+        bench::doNotOptimize(info.used());
+    }));
+
+    bench::report("readMemInfo (open + read)", bench::measure([&] {
+        MemInfoData data;
+        readMemInfo(PATH_MEMINFO, data);
+        bench::doNotOptimize(data.memTotal - data.memAvailable);
+    }));
+
+    for (const char *kernel : {"linux-3.10", "linux-6.18"}) {
+        const std::string fixture = bench::readFixture(std::string{"meminfo/"} + kernel);
+        bench::report(std::string{"parseMemInfo (fixture "} + kernel + ")", bench::measure([&] {
+            MemInfoData data;
+            parseMemInfo(fixture.data(), fixture.size(), data);
+            bench::doNotOptimize(data.memTotal - data.memAvailable);
+        }));
+    }
+
+    const std::string nodeContent = slurp("/sys/devices/system/node/node0/meminfo");
+    if (!nodeContent.empty()) {
+        bench::report("parseNodeMemInfo (node0, in place)", bench::measure([&] {
+            MemInfoData data;
+            parseNodeMemInfo(nodeContent.data(), nodeContent.size(), data);
+            bench::doNotOptimize(data.memTotal - data.memFree);
+        }));
+    }
+}
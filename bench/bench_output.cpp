@@ -0,0 +1,109 @@
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "Bench.h"
+#include "../ConsoleTable.h"
+#include "../MemInfoParser.h"
+#include "../OutputWriter.h"
+#include "../Units.h"
+
+namespace {
+
+/// The percentage formatting of calculatePercentage() in main.cpp
+std::string streamPercentage(long used, long total) {
+    float x = total > 0 ? (used * 100) / total : 0;
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(1) << x;
+    return stream.str();
+}
+
+}
+
+BENCH(output) {
+    MemInfoData data;
+    readMemInfo("/proc/meminfo", data);
+    OutputBuffer out(-1);
+
+    bench::report("stringstream percentage", bench::measure([&] {
+        bench::doNotOptimize(streamPercentage(data.memTotal - data.memAvailable, data.memTotal));
+    }));
+
+    bench::report("appendPercent", bench::measure([&] {
+        out.clear();
+        out.appendPercent(data.memTotal - data.memAvailable, data.memTotal);
+        bench::doNotOptimize(out.size());
+    }));
+
+    const Quantity used = Quantity::fromKiB(memInfoUsed(data));
+    char text[QUANTITY_TEXT_SIZE];
+    bench::report("formatQuantity KiB", bench::measure([&] {
+        bench::doNotOptimize(formatQuantity(text, used, Units{}));
+    }));
+    bench::report("formatQuantity -h", bench::measure([&] {
+        bench::doNotOptimize(formatQuantity(text, used, Units{UnitScale::Human, false}));
+    }));
+
+    bench::report("ConsoleTable Memory table", bench::measure([&] {
+        ConsoleTable table{"TOTAL", "USED", "FREE", "BUF/CACHE", "AVAILABLE", "USE%"};
+        table.setStyle(4);
+        table.setTittle("Memory");
+        table += {std::to_string(data.memTotal) + " kB", std::to_string(memInfoUsed(data)) + " kB",
+                  std::to_string(data.memFree) + " kB", std::to_string(memInfoBuffCache(data)) + " kB",
+                  std::to_string(memInfoAvailable(data)) + " kB",
+                  streamPercentage(memInfoUsed(data), data.memTotal) + " %"};
+        std::ostringstream stream;
+        stream << table;
+        bench::doNotOptimize(stream.str().size());
+    }));
+
+    // Text larger than the buffer must arrive whole, after what was pending
+    std::string large(3 * OutputBuffer::CAPACITY + 123, ' ');
+    for (size_t i = 0; i < large.size(); i++)
+        large[i] = static_cast<char>('a' + i % 26);
+    std::string target;
+    {
+        OutputBuffer collected(target);
+        collected.append("head ");
+        collected.append(large.data(), large.size());
+        collected.append(" tail");
+        collected.flush();
+    }
+    if (target != "head " + large + " tail")
+        bench::fail("appending " + std::to_string(large.size()) + " bytes gave " + std::to_string(target.size())
+                    + " bytes of text");
+    int pipeFds[2];
+    if (pipe(pipeFds) == 0) {
+        OutputBuffer written(pipeFds[1]);
+        written.append("head ");
+        written.append(large.data(), large.size());
+        written.flush();
+        close(pipeFds[1]);
+        std::string received;
+        char chunk[4096];
+        for (ssize_t n; (n = read(pipeFds[0], chunk, sizeof(chunk))) > 0;)
+            received.append(chunk, static_cast<size_t>(n));
+        close(pipeFds[0]);
+        if (received != "head " + large)
+            bench::fail("writing " + std::to_string(large.size()) + " bytes to a pipe gave "
+                        + std::to_string(received.size()) + " bytes");
+    }
+
+    bench::report("writeJson", bench::measure([&] {
+        out.clear();
+        writeJson(out, data);
+        bench::doNotOptimize(out.size());
+    }));
+
+    bench::report("writeCsv", bench::measure([&] {
+        out.clear();
+        writeCsv(out, data);
+        bench::doNotOptimize(out.size());
+    }));
+
+    bench::report("writePrometheus", bench::measure([&] {
+        out.clear();
+        writePrometheus(out, data);
+        bench::doNotOptimize(out.size());
+    }));
+}
@@ -0,0 +1,21 @@
+#include <string>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../Parallel.h"
+#include "../ProcScan.h"
+
+BENCH(procs) {
+    for (unsigned int processes : {250u, 2500u}) {
+        const std::string root = bench::createProcTree(processes);
+        for (unsigned int threads : {1u, defaultThreadCount()}) {
+            bench::report("scan " + std::to_string(processes) + " fixture processes, "
+                          + std::to_string(threads) + " threads", bench::measure([&] {
+                bench::doNotOptimize(scanProcesses(root.c_str(), 20, threads).top.size());
+            }, 1000));
+        }
+        bench::removeTree(root);
+    }
+    bench::report("scan /proc, " + std::to_string(defaultThreadCount()) + " threads", bench::measure([&] {
+        bench::doNotOptimize(scanProcesses("/proc", 20, defaultThreadCount()).top.size());
+    }, 1000));
+}
@@ -0,0 +1,130 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Bench.h"
+#include "../Recording.h"
+
+namespace {
+
+const size_t SAMPLES = 20000;
+
+/// Builds samples that drift like a busy machine: a few fields change every second
+std::vector<RecordedSample> syntheticSamples() {
+    MemInfoData base;
+    readMemInfo("/proc/meminfo", base);
+    // Reported fields whose value is 0 must come back reported
+    base.set(MemInfoField::hugePagesTotal, 0);
+    base.set(MemInfoField::zswap, 0);
+    VmStatReader reader;
+    VmStatData counters{};
+    if (reader.open())
+        reader.read(counters);
+    std::vector<RecordedSample> samples(SAMPLES);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < SAMPLES; i++) {
+        RecordedSample &sample = samples[i];
+        sample.timeMs = 1700000000000LL + static_cast<int64_t>(i) * 1000;
+        sample.meminfo = base;
+        sample.meminfo.memFree = base.memFree - (rand_r(&seed) % 4096);
+        sample.meminfo.memAvailable = base.memAvailable - (rand_r(&seed) % 4096);
+        sample.meminfo.cached = base.cached + (rand_r(&seed) % 1024);
+        sample.meminfo.dirty = rand_r(&seed) % 512;
+        sample.meminfo.activeAnon = base.activeAnon + (rand_r(&seed) % 2048);
+        // MemAvailable reaches 0 now and then, and disappears like on a kernel without it
+        if (i % 100 == 0)
+            sample.meminfo.memAvailable = 0;
+        else if (i % 100 == 50)
+            sample.meminfo.present.reset(static_cast<size_t>(MemInfoField::memAvailable));
+        counters.values[static_cast<size_t>(VmStatField::pgfault)] += rand_r(&seed) % 5000;
+        counters.values[static_cast<size_t>(VmStatField::pgmajfault)] += rand_r(&seed) % 3;
+        sample.vmstat = counters;
+    }
+    return samples;
+}
+
+bool sameSample(const RecordedSample &a, const RecordedSample &b) {
+    if (a.timeMs != b.timeMs || std::memcmp(a.vmstat.values, b.vmstat.values, sizeof(a.vmstat.values)) != 0
+            || a.meminfo.present != b.meminfo.present)
+        return false;
+    for (size_t i = 0; i < MEMINFO_FIELD_COUNT; i++) {
+        MemInfoField field = static_cast<MemInfoField>(i);
+        if (a.meminfo.get(field) != b.meminfo.get(field))
+            return false;
+    }
+    return true;
+}
+
+}
+
+BENCH(recording) {
+    const std::vector<RecordedSample> samples = syntheticSamples();
+    char path[] = "/tmp/superfree-recording-XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    unlink(path);
+
+    // Large enough for every sample, the ring never wraps
+    const size_t size = 64 * 1024 * 1024;
+    {
+        Recorder recorder(path, size);
+        for (const auto &sample : samples)
+            recorder.append(sample.timeMs, sample.meminfo, sample.vmstat);
+    }
+
+    // Every replayed sample must match the recorded one
+    Replay replay(path);
+    size_t index = 0;
+    size_t mismatches = 0;
+    replay.forEach(INT64_MIN, INT64_MAX, [&](const RecordedSample &sample) {
+        if (index >= samples.size() || !sameSample(sample, samples[index]))
+            mismatches++;
+        index++;
+        return true;
+    });
+    if (mismatches != 0 || index != samples.size())
+        bench::fail("replay: " + std::to_string(index) + " of " + std::to_string(samples.size())
+                    + " samples replayed, " + std::to_string(mismatches) + " differ");
+
+    // A small ring wraps and keeps the newest samples, which gives the size of a sample
+    std::remove(path);
+    const size_t smallSize = 256 * 1024;
+    {
+        Recorder recorder(path, smallSize);
+        for (const auto &sample : samples)
+            recorder.append(sample.timeMs, sample.meminfo, sample.vmstat);
+    }
+    size_t kept = 0;
+    mismatches = 0;
+    {
+        Replay wrapped(path);
+        wrapped.forEach(INT64_MIN, INT64_MAX, [&](const RecordedSample &) { kept++; return true; });
+        index = samples.size() - kept;
+        wrapped.forEach(INT64_MIN, INT64_MAX, [&](const RecordedSample &sample) {
+            if (!sameSample(sample, samples[index++]))
+                mismatches++;
+            return true;
+        });
+    }
+    if (mismatches != 0 || kept == 0)
+        bench::fail("replay after wrapping: " + std::to_string(mismatches) + " of " + std::to_string(kept)
+                    + " samples differ");
+    std::printf("%zu samples kept in %zu bytes, %.1f bytes per sample, %.1f MiB per week at 1 s\n",
+                kept, smallSize, static_cast<double>(smallSize - RECORDING_BLOCK_SIZE) / kept,
+                (smallSize - RECORDING_BLOCK_SIZE) / static_cast<double>(kept) * 604800 / (1024 * 1024));
+
+    std::remove(path);
+    Recorder recorder(path, size);
+    size_t next = 0;
+    bench::report("append one sample (mmap, no syscall)", bench::measure([&] {
+        const RecordedSample &sample = samples[next++ % samples.size()];
+        recorder.append(sample.timeMs, sample.meminfo, sample.vmstat);
+    }));
+    RecordedSample found;
+    bench::report("find the sample at a time", bench::measure([&] {
+        bench::doNotOptimize(replay.at(samples[samples.size() / 2].timeMs, found));
+    }));
+    std::remove(path);
+}
@@ -0,0 +1,70 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../Sampler.h"
+#include "../superfree.h"
+
+namespace {
+
+const unsigned int READERS = 4;
+const auto STRESS_TIME = std::chrono::milliseconds(500);
+
+}
+
+BENCH(sampler) {
+    // Stress: readers copy while the thread samples every millisecond, a torn copy would mix
+    // the sequence of one sample with the meminfo of another, so check the time only grows
+    Sampler sampler{1};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> backwards{0};
+    std::vector<std::thread> readers;
+    for (unsigned int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            Snapshot snapshot;
+            uint64_t lastSequence = 0;
+            uint64_t localReads = 0;
+            uint64_t localBackwards = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sampler.read(snapshot);
+                if (snapshot.sequence < lastSequence || snapshot.meminfo.memTotal == 0)
+                    localBackwards++;
+                lastSequence = snapshot.sequence;
+                localReads++;
+            }
+            reads += localReads;
+            backwards += localBackwards;
+        });
+    }
+    std::this_thread::sleep_for(STRESS_TIME);
+    stop = true;
+    for (auto &reader : readers)
+        reader.join();
+    Snapshot last;
+    sampler.read(last);
+    std::printf("stress: %llu samples, %llu reads by %u readers, %llu inconsistent\n",
+                static_cast<unsigned long long>(last.sequence), static_cast<unsigned long long>(reads.load()),
+                READERS, static_cast<unsigned long long>(backwards.load()));
+
+    Snapshot snapshot;
+    bench::report("Sampler::read (C++)", bench::measure([&] {
+        sampler.read(snapshot);
+        bench::doNotOptimize(snapshot.sequence);
+    }));
+
+    sf_sampler *handle = sf_sampler_start(1000, 0);
+    if (handle == nullptr) {
+        std::printf("sf_sampler_start failed\n");
+        return;
+    }
+    sf_snapshot copy;
+    bench::report("sf_snapshot_read (C, sampler)", bench::measure([&] {
+        bench::doNotOptimize(sf_snapshot_read(handle, &copy));
+    }));
+    sf_sampler_stop(handle);
+    bench::report("sf_snapshot_read (C, no sampler)", bench::measure([&] {
+        bench::doNotOptimize(sf_snapshot_read(nullptr, &copy));
+    }));
+}
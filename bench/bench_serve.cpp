@@ -0,0 +1,99 @@
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "Bench.h"
+#include "../MetricsServer.h"
+
+namespace {
+
+const unsigned int SCRAPERS = 8;
+const unsigned int SCRAPES = 200;
+
+/// Connects to the server on the loopback interface
+int connectTo(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Sends one keep-alive GET /metrics and reads the whole response
+/// \return True if the response is a 200 whose body ends with "# EOF"
+bool scrape(int fd, std::string &response) {
+    static const char REQUEST[] = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (send(fd, REQUEST, sizeof(REQUEST) - 1, MSG_NOSIGNAL) < 0)
+        return false;
+    response.clear();
+    size_t expected = std::string::npos;
+    char buffer[16384];
+    while (expected == std::string::npos || response.size() < expected) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0)
+            return false;
+        response.append(buffer, static_cast<size_t>(n));
+        const size_t headerEnd = response.find("\r\n\r\n");
+        if (expected == std::string::npos && headerEnd != std::string::npos) {
+            const size_t length = response.find("Content-Length: ");
+            if (length == std::string::npos || length > headerEnd)
+                return false;
+            expected = headerEnd + 4 + std::strtoul(response.c_str() + length + 16, nullptr, 10);
+        }
+    }
+    return response.compare(0, 15, "HTTP/1.1 200 OK") == 0
+        && response.compare(response.size() - 6, 6, "# EOF\n") == 0;
+}
+
+}
+
+BENCH(serve) {
+    MetricsServer server{"127.0.0.1:0", METRICS_DEFAULT_COALESCE_MS, true};
+    volatile sig_atomic_t stop = 0;
+    std::thread serving{[&] { server.run(stop); }};
+
+    // Bundled client: concurrent keep-alive scrapers, all served from the coalesced collection
+    std::atomic<unsigned int> failures{0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> scrapers;
+    for (unsigned int s = 0; s < SCRAPERS; s++) {
+        scrapers.emplace_back([&] {
+            int fd = connectTo(server.port());
+            std::string response;
+            for (unsigned int i = 0; i < SCRAPES; i++) {
+                if (fd < 0 || !scrape(fd, response))
+                    failures++;
+            }
+            if (fd >= 0)
+                close(fd);
+        });
+    }
+    for (auto &scraper : scrapers)
+        scraper.join();
+    const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%u scrapes by %u clients: %u failed, %llu collections\n", SCRAPERS * SCRAPES, SCRAPERS,
+                failures.load(), static_cast<unsigned long long>(server.collections()));
+    bench::report("coalesced scrape (8 clients, keep-alive)", elapsed / (SCRAPERS * SCRAPES));
+
+    std::string body;
+    MetricsCollector collector{true};
+    bench::report("collection (meminfo, vmstat, PSI, cgroups)", bench::measure([&] {
+        body.clear();
+        collector.collect(body);
+        bench::doNotOptimize(body.size());
+    }));
+
+    stop = 1;
+    serving.join();
+}
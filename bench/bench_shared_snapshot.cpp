@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../SharedSnapshot.h"
+#include "../SnapshotPublisher.h"
+
+namespace {
+
+const unsigned int READERS = 4;
+const auto STRESS_TIME = std::chrono::milliseconds(500);
+
+/// A snapshot whose every word derives from value, so a torn copy is detectable
+void fillSnapshot(SharedSnapshot &snapshot, uint64_t value) {
+    uint64_t *words = reinterpret_cast<uint64_t *>(&snapshot);
+    for (size_t i = 0; i < sizeof(snapshot) / sizeof(uint64_t); i++)
+        words[i] = value * 31 + i;
+}
+
+bool consistent(const SharedSnapshot &snapshot) {
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(&snapshot);
+    const uint64_t value = words[0] / 31;
+    for (size_t i = 0; i < sizeof(snapshot) / sizeof(uint64_t); i++) {
+        if (words[i] != value * 31 + i)
+            return false;
+    }
+    return true;
+}
+
+}
+
+BENCH(shared_snapshot) {
+    // Stress: one writer publishing as fast as it can, several readers checking every copy
+    SharedSnapshotSegment *segment = new SharedSnapshotSegment{};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> failed{0};
+    SharedSnapshot first;
+    fillSnapshot(first, 0);
+    writeSharedSnapshot(*segment, first);
+
+    std::vector<std::thread> readers;
+    for (unsigned int r = 0; r < READERS; r++) {
+        readers.emplace_back([&] {
+            SharedSnapshot snapshot;
+            uint64_t localReads = 0;
+            uint64_t localTorn = 0;
+            uint64_t localFailed = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!readSharedSnapshot(*segment, snapshot)) {
+                    localFailed++;
+                    continue;
+                }
+                localReads++;
+                if (!consistent(snapshot))
+                    localTorn++;
+            }
+            reads += localReads;
+            torn += localTorn;
+            failed += localFailed;
+        });
+    }
+    uint64_t writes = 0;
+    SharedSnapshot snapshot;
+    const auto end = std::chrono::steady_clock::now() + STRESS_TIME;
+    while (std::chrono::steady_clock::now() < end) {
+        fillSnapshot(snapshot, ++writes);
+        writeSharedSnapshot(*segment, snapshot);
+    }
+    stop = true;
+    for (auto &reader : readers)
+        reader.join();
+    std::printf("stress: %llu writes, %llu reads by %u readers, %llu torn, %llu gave up\n",
+                static_cast<unsigned long long>(writes), static_cast<unsigned long long>(reads.load()), READERS,
+                static_cast<unsigned long long>(torn.load()), static_cast<unsigned long long>(failed.load()));
+    if (torn != 0)
+        bench::fail("torn reads detected, the seqlock let a reader see a partial write");
+    delete segment;
+
+    // Latency through a real POSIX shared memory segment
+    const std::string name = "/superfree-bench-" + std::to_string(getpid());
+    MemInfoData data;
+    readMemInfo("/proc/meminfo", data);
+    SnapshotPublisher publisher(name);
+    publisher.publish(data);
+    // A second publisher of the same segment would break the seqlock
+    try {
+        SnapshotPublisher second(name);
+        bench::fail("a second publisher took over " + name);
+    } catch (const std::runtime_error &) {
+    }
+    SharedSnapshotReader reader;
+    if (!reader.open(name.c_str())) {
+        std::printf("unable to open %s\n", name.c_str());
+        return;
+    }
+    SharedSnapshot copy;
+    bench::report("read a snapshot (seqlock, no syscall)", bench::measure([&] {
+        bench::doNotOptimize(reader.read(copy));
+    }));
+    bench::report("publish a snapshot", bench::measure([&] {
+        publisher.publish(data);
+    }));
+    bench::report("parse /proc/meminfo instead", bench::measure([&] {
+        MemInfoData parsed;
+        readMemInfo("/proc/meminfo", parsed);
+        bench::doNotOptimize(parsed.memTotal);
+    }));
+}
@@ -0,0 +1,98 @@
+#include <sstream>
+#include "Bench.h"
+#include "../ConsoleTable.h"
+#include "../DisplayWidth.h"
+
+namespace {
+
+const unsigned int TABLE_ROWS = 100000;
+
+ConsoleTable buildTable() {
+    ConsoleTable table{"PID", "USER", "RSS", "PSS", "SWAP", "ANON", "FILE", "COMMAND"};
+    table.setStyle(4);
+    table.setTittle("Processes");
+    for (unsigned int i = 0; i < TABLE_ROWS; ++i) {
+        std::string n = std::to_string(i);
+        table += {n, "user" + std::to_string(i % 50), n + "0 kB", n + "1 kB", "0 kB",
+                  "\e[38;5;75m" + n + " kB\e[0m", n + "2 kB", "/usr/bin/process-" + n};
+    }
+    return table;
+}
+
+}
+
+BENCH(table) {
+    bench::report("addRow 100k x 8 (per table)", bench::measure([] {
+        ConsoleTable table = buildTable();
+        bench::doNotOptimize(table.rowCount());
+    }, 1000));
+
+    const ConsoleTable table = buildTable();
+    std::string out;
+    bench::report("render 100k x 8 (per table)", bench::measure([&] {
+        out.clear();
+        table.render(out);
+        bench::doNotOptimize(out.size());
+    }, 1000));
+    bench::report("render 100k x 8 (per row)", bench::measure([&] {
+        out.clear();
+        table.render(out);
+        bench::doNotOptimize(out.size());
+    }, 1000) / TABLE_ROWS);
+    std::printf("%-48s %14zu bytes\n", "rendered size", out.size());
+
+    // Removing the row one past the end must be refused, then the last one removed
+    ConsoleTable small{"PID", "COMMAND"};
+    small += {"1", "init"};
+    small += {"2", "kthreadd"};
+    if (small.removeRow(2) || small.rowCount() != 2 || !small.removeRow(1) || small.rowCount() != 1)
+        bench::fail("removeRow() past the end of a 2 row table left " + std::to_string(small.rowCount()) + " rows");
+}
+
+BENCH(table_stream) {
+    std::ostringstream out;
+    bench::report("stream 100k x 8, 100 sampled rows (per table)", bench::measure([&] {
+        out.str(std::string());
+        ConsoleTable table{"PID", "USER", "RSS", "PSS", "SWAP", "ANON", "FILE", "COMMAND"};
+        table.setStyle(4);
+        table.setTittle("Processes");
+        table.beginStream(out, 100);
+        for (unsigned int i = 0; i < TABLE_ROWS; ++i) {
+            std::string n = std::to_string(i);
+            table += {n, "user" + std::to_string(i % 50), n + "0 kB", n + "1 kB", "0 kB",
+                      "\e[38;5;75m" + n + " kB\e[0m", n + "2 kB", "/usr/bin/process-" + n};
+        }
+        table.endStream();
+        bench::doNotOptimize(out.tellp());
+    }, 1000));
+
+    // Fixed widths narrower than the headers must widen the columns, not break the lines
+    out.str(std::string());
+    ConsoleTable narrow{"PID", "COMMAND"};
+    narrow.setStyle(4);
+    narrow.beginStream(out, ConsoleTable::Widths{1, 4});
+    narrow += {"12345", "/usr/bin/process"};
+    narrow.endStream();
+    std::istringstream lines(out.str());
+    std::string line;
+    std::getline(lines, line);
+    const size_t width = displayWidth(line);
+    while (std::getline(lines, line)) {
+        if (displayWidth(line) != width)
+            bench::fail("streamed table with fixed widths has lines of different widths:\n" + out.str());
+    }
+    bench::report("stream 100k x 8, fixed widths (per table)", bench::measure([&] {
+        out.str(std::string());
+        ConsoleTable table{"PID", "USER", "RSS", "PSS", "SWAP", "ANON", "FILE", "COMMAND"};
+        table.setStyle(4);
+        table.setTittle("Processes");
+        table.beginStream(out, ConsoleTable::Widths{6, 8, 10, 10, 6, 10, 10, 20});
+        for (unsigned int i = 0; i < TABLE_ROWS; ++i) {
+            std::string n = std::to_string(i);
+            table += {n, "user" + std::to_string(i % 50), n + "0 kB", n + "1 kB", "0 kB",
+                      "\e[38;5;75m" + n + " kB\e[0m", n + "2 kB", "/usr/bin/process-" + n};
+        }
+        table.endStream();
+        bench::doNotOptimize(out.tellp());
+    }, 1000));
+}
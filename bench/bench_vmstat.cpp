@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "Bench.h"
+#include "Fixtures.h"
+#include "../VmStat.h"
+
+namespace {
+
+std::string slurp(const char *path) {
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+}
+
+BENCH(vmstat) {
+    const std::string content = slurp("/proc/vmstat");
+    if (content.empty()) {
+        std::printf("/proc/vmstat is not readable, skipped\n");
+        return;
+    }
+
+    // The cached layout must give the same counters as resolving every key
+    VmStatReader resolving;
+    VmStatReader cached;
+    VmStatData expected;
+    VmStatData actual;
+    cached.parse(content.data(), content.size(), actual);
+    resolving.parse(content.data(), content.size(), expected);
+    cached.parse(content.data(), content.size(), actual);
+    if (std::memcmp(expected.values, actual.values, sizeof(expected.values)) != 0)
+        bench::fail("the cached vmstat layout differs from a full resolve");
+
+    bench::report("parse resolving every key", bench::measure([&] {
+        VmStatReader reader;
+        VmStatData data;
+        reader.parse(content.data(), content.size(), data);
+        bench::doNotOptimize(data.values[0]);
+    }));
+    bench::report("parse with the cached layout", bench::measure([&] {
+        VmStatData data;
+        cached.parse(content.data(), content.size(), data);
+        bench::doNotOptimize(data.values[0]);
+    }));
+    for (const char *kernel : {"linux-3.10", "linux-6.18"}) {
+        const std::string fixture = bench::readFixture(std::string{"vmstat/"} + kernel);
+        VmStatReader fixtureReader;
+        VmStatData data;
+        fixtureReader.parse(fixture.data(), fixture.size(), data);
+        bench::report(std::string{"parse with the cached layout (fixture "} + kernel + ")", bench::measure([&] {
+            fixtureReader.parse(fixture.data(), fixture.size(), data);
+            bench::doNotOptimize(data.values[0]);
+        }));
+    }
+    VmStatReader reader;
+    reader.open();
+    bench::report("read /proc/vmstat (pread + cached parse)", bench::measure([&] {
+        VmStatData data;
+        reader.read(data);
+        bench::doNotOptimize(data.values[0]);
+    }));
+}
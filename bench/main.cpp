@@ -0,0 +1,56 @@
+#include <cstdlib>
+#include <cstring>
+#include "Bench.h"
+#include "Results.h"
+
+/// Runs every registered benchmark whose name contains the filter, exits with 1 when one of
+/// their checks failed. --save <file> keeps the results as a baseline, --compare <file> exits with 2 when a
+/// result regressed against one by more than --tolerance percent (default 10).
+int main(int argc, char *argv[]) {
+    const char *filter = "";
+    const char *savePath = nullptr;
+    const char *comparePath = nullptr;
+    double tolerance = 10;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            comparePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = std::strtod(argv[++i], nullptr);
+        } else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "Usage: %s [--save <file>] [--compare <file> [--tolerance <percent>]] [filter]\n",
+                         argv[0]);
+            return 1;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    for (const auto &benchCase : bench::registry()) {
+        if (std::strstr(benchCase.name, filter) == nullptr)
+            continue;
+        std::printf("[%s]\n", benchCase.name);
+        bench::setCurrentBenchmark(benchCase.name);
+        benchCase.function();
+    }
+
+    if (bench::failureCount() > 0) {
+        std::fprintf(stderr, "superfree_bench: %u check(s) failed\n", bench::failureCount());
+        return 1;
+    }
+    if (savePath != nullptr && !bench::saveResults(savePath)) {
+        std::fprintf(stderr, "superfree_bench: unable to write %s\n", savePath);
+        return 1;
+    }
+    if (comparePath != nullptr) {
+        unsigned int regressions = 0;
+        if (!bench::compareResults(comparePath, tolerance, regressions)) {
+            std::fprintf(stderr, "superfree_bench: unable to read %s\n", comparePath);
+            return 1;
+        }
+        std::printf("%u regression(s) against %s (tolerance %.0f %%)\n", regressions, comparePath, tolerance);
+        return regressions > 0 ? 2 : 0;
+    }
+    return 0;
+}
@@ -1,261 +1,859 @@
 #include <iomanip>
 #include <sstream>
 #include <iostream>
-#include <fstream>
-#include <map>
+#include <stdexcept>
+#include <functional>
+#include <memory>
+#include <csignal>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 #include "ConsoleTable.h"
+#include "MemInfo.h"
+#include "MemInfoParser.h"
+#include "MemoryTables.h"
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "Alert.h"
+#include "BatchAnalysis.h"
+#include "CgroupTree.h"
+#include "Fragmentation.h"
+#include "KernelMemory.h"
+#include "MetricsServer.h"
+#include "NumaNodes.h"
+#include "PageCache.h"
+#include "Pressure.h"
+#include "Recording.h"
+#include "Sampler.h"
+#include "SnapshotPublisher.h"
+#include "Units.h"
+#include "Views.h"
+#include "VmStat.h"
+
+/// What superfree shows
+enum class View {
+    Memory,
+    Processes,
+    Cgroups,
+    Numa,
+    Kernel,
+    Cache,
+    Fragmentation,
+};
 
-class MemInfo {
-private:
-    const std::string pathMeminfo = "/proc/meminfo";
-
-    enum Options {
-        Option_Invalid,
-        MemTotal,
-        MemFree,
-        MemAvailable,
-        Buffers,
-        Cached,
-        SwapTotal,
-        SwapFree,
-    };
-
-    const std::map<std::string, Options> optionStrings {
-        {"MemTotal",MemTotal},
-        {"MemFree",MemFree},
-        {"MemAvailable",MemAvailable},
-        {"Buffers",Buffers},
-        {"Cached",Cached},
-        {"SwapTotal",SwapTotal},
-        {"SwapFree",SwapFree},
-        {"MemFree",MemFree}
-    };
+struct Arguments {
+    /// Memory tables or one of the detailed views
+    View view = View::Memory;
+    /// Number of rows of the detailed views
+    size_t top = 20;
+    /// Seconds between refreshes, 0 prints once
+    double interval = 0;
+    /// Number of refreshes, negative repeats until interrupted
+    long count = -1;
+    /// Tables or one of the machine-readable formats
+    OutputFormat format = OutputFormat::Table;
+    /// Unit of the sizes, -b/-k/-m/-g/-h and --si
+    Units units;
+    /// Ignore the limits of the enclosing cgroup
+    bool host = false;
+    /// PSI trigger refreshing the output on memory pressure, empty to refresh on a timer
+    std::string pressureTrigger;
+    /// Thresholds of the bars, --alert and --check
+    AlertRule rule;
+    /// Share of the total from which memory and swap count as exhausted in the forecast
+    double forecastPercent = 0;
+    /// Print level changes instead of tables
+    bool alert = false;
+    AlertFormat alertFormat = AlertFormat::Json;
+    /// Print a Nagios plugin status line and exit with its code
+    bool check = false;
+    /// Recording file written by --record
+    std::string recordPath;
+    /// Size of a new recording file in bytes
+    size_t recordSize = RECORDING_DEFAULT_SIZE;
+    /// Recording file read by --replay
+    std::string replayPath;
+    /// Times given by --range in milliseconds since the epoch, to is INT64_MIN when not given
+    int64_t rangeFromMs = INT64_MAX;
+    int64_t rangeToMs = INT64_MIN;
+    /// Shared memory name written by --publish, empty when not publishing
+    std::string publishName;
+    /// Directory read instead of /proc, e.g. the proc/ of a sosreport
+    std::string procRoot = "/proc";
+    /// Summarize the captures given as operands instead of reading this host
+    bool batch = false;
+    /// Operands of --batch and --cache
+    std::vector<std::string> paths;
+    /// Address given to --serve, empty when not serving
+    std::string serveAddress;
+    /// Window during which scrapes share one collection
+    unsigned int coalesceMs = METRICS_DEFAULT_COALESCE_MS;
+};
 
-    void trimLeft( std::string& str){
-        while(1){
-            if(str[0] != ' ') break;
-            std::string::size_type pos = str.find_first_not_of(" ");
-            str = str.erase(0, pos);
-        }
-    }
+/// Seconds between refreshes without pressure when --psi is given without -s
+const double PRESSURE_HEARTBEAT = 10;
 
+/// Seconds between checks of --alert when -s is not given
+const double ALERT_INTERVAL = 5;
 
-    std::string getColor(const std::string &percentage){
-        std::string color = "\e[38;5;148m"; //green
-        if (std::stof(percentage) < 60)
-            color = "\e[38;5;148m";
-        if ((std::stof(percentage) >= 60) && (std::stof(percentage) < 90))
-            color = "\e[38;5;226m";
-        if (std::stof(percentage) >= 90)
-            color = "\e[38;5;197m";
-        return color;
-    }
-
-    std::string genericPrintBar(const std::string &used, const std::string &total) {
-        std::string percentageUsed = calculatePercentage(used, total);
-        int numberHash = calculateNumberHash(used, total);
-        std::string result = getColor(percentageUsed);
-        for(int i = 0; i<24; i++){
-            if(i == 0)
-                result = result + "[";
-            if ((i > 0) && (i <= numberHash) && (i < 23))
-                result = result + "#";
-            if ((i > 0) && (i > numberHash) && (i < 23))
-                result = result + ".";
-            if (i == 23)
-                result = result + "]";
-        }
-        return result + " " + percentageUsed + " %\e[0m";
-    }
+/// Set by the SIGINT/SIGTERM handler to leave watch mode
+volatile sig_atomic_t stopRequested = 0;
 
+void requestStop(int) {
+    stopRequested = 1;
+}
 
-        Options resolveOption(const std::string &input) {
-            auto itr = optionStrings.find(input);
-            if( itr != optionStrings.end() ) {
-                return itr->second;
-            }
-            return Option_Invalid;
-        }
+/// Makes SIGINT and SIGTERM set stopRequested and interrupt blocking calls
+void installStopHandler() {
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
 
-        std::string calculatePercentage(const std::string &used, const std::string &total){
-            float x = (std::stol(used) * 100) / std::stol(total);
-            std::stringstream stream;
-            stream << std::fixed << std::setprecision(1) << x;
-            return stream.str();
-        }
+void printUsage(const char *program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  -s, --seconds <interval>  repeat printing every <interval> seconds\n"
+              << "  -c, --count <count>       repeat printing <count> times, then exit\n"
+              << "  -b, --bytes               show sizes in bytes\n"
+              << "  -k, --kibi                show sizes in KiB (default)\n"
+              << "  -m, --mebi                show sizes in MiB\n"
+              << "  -g, --gibi                show sizes in GiB\n"
+              << "  -h, --human               show sizes in the largest unit below 1024, e.g. 7.6 GiB\n"
+              << "                            (KiB in --json and --csv)\n"
+              << "      --si                  use powers of 1000 (kB, MB, GB) instead of 1024\n"
+              << "      --json                print one JSON object per refresh\n"
+              << "      --csv                 print a CSV header and one line per refresh\n"
+              << "      --prom                print the Prometheus text exposition format\n"
+              << "      --procs               show the processes using most memory (PSS)\n"
+              << "      --cgroups             show the memory of every cgroup v2 as a tree\n"
+              << "      --psi[=<trigger>]     refresh when memory pressure crosses a PSI trigger,\n"
+              << "                            default \"" << PRESSURE_DEFAULT_TRIGGER << "\", -s sets the\n"
+              << "                            heartbeat refresh without pressure (default "
+              << PRESSURE_HEARTBEAT << " s)\n"
+              << "      --alert[=json|syslog] print an event each time memory or swap use changes level\n"
+              << "      --check               print a Nagios plugin status line, exit 0, 1, 2 or 3\n"
+              << "      --warning <percent>   use from which bars turn yellow and levels warn (default 60)\n"
+              << "      --critical <percent>  use from which bars turn red and levels are critical (default 90)\n"
+              << "      --hysteresis <points> points below a threshold needed to leave a level (default 5)\n"
+              << "      --for <seconds>       time a new level must hold before --alert reports it\n"
+              << "      --exhausted-at <percent>\n"
+              << "                            available share of memory and swap from which the forecast\n"
+              << "                            shown when repeating counts them as exhausted (default 0)\n"
+              << "      --record <file>       append a sample every interval (default 1 s) to a ring file\n"
+              << "      --record-size <MiB>   size of a new recording file (default "
+              << RECORDING_DEFAULT_SIZE / (1024 * 1024) << " MiB)\n"
+              << "      --replay <file>       show the newest sample of a recording\n"
+              << "      --range <from>[,<to>] show the sample at <from>, or every sample between <from>\n"
+              << "                            and <to>; times are Unix seconds or YYYY-MM-DDTHH:MM:SS\n"
+              << "      --publish[=<name>]    publish a snapshot every interval (default 1 s) to the POSIX\n"
+              << "                            shared memory <name> (default " << SHARED_SNAPSHOT_NAME
+              << "), see SharedSnapshot.h\n"
+              << "      --serve <host:port>   serve meminfo, vmstat, PSI and cgroup metrics as OpenMetrics\n"
+              << "                            at http://<host:port>/metrics\n"
+              << "      --coalesce <ms>       scrapes within <ms> of a collection share it (default "
+              << METRICS_DEFAULT_COALESCE_MS << ")\n"
+              << "      --numa                show the memory of every NUMA node\n"
+              << "      --kernel              show the kernel memory and the largest slab caches (root)\n"
+              << "      --frag                show how fragmented the free memory of every zone is, and\n"
+              << "                            the compaction rates when repeating\n"
+              << "      --cache <path>...     show how much of files and directory trees is in the page\n"
+              << "                            cache (root, or the owner of the files)\n"
+              << "      --proc-root <dir>     read <dir> instead of /proc, e.g. the proc/ of a sosreport\n"
+              << "      --batch <path>...     summarize captured meminfo files, directories (one host per\n"
+              << "                            entry) and .tar archives as one CSV (or --json) line per host\n"
+              << "                            with p50/p95/max used%\n"
+              << "      --host                show the host memory even inside a limited cgroup\n"
+              << "  -n, --top <count>         number of rows of --procs, --kernel and --cache (default 20)\n"
+              << "      --help                display this help and exit\n";
+}
 
-        int calculateNumberHash(const std::string &used, const std::string &total){
-            float x = (std::stof(calculatePercentage(used, total)) * 22) / 100;
-            return int(round(x));
-        }
+/// Parses Unix seconds or a local YYYY-MM-DDTHH:MM:SS time
+bool parseTime(const std::string &text, int64_t &timeMs) {
+    char *end;
+    long long seconds = std::strtoll(text.c_str(), &end, 10);
+    if (!text.empty() && *end == '\0') {
+        timeMs = seconds * 1000;
+        return true;
+    }
+    tm local{};
+    local.tm_isdst = -1;
+    const char *rest = strptime(text.c_str(), "%Y-%m-%dT%H:%M:%S", &local);
+    if (rest == nullptr)
+        rest = strptime(text.c_str(), "%Y-%m-%d %H:%M:%S", &local);
+    if (rest == nullptr || *rest != '\0')
+        return false;
+    timeMs = static_cast<int64_t>(mktime(&local)) * 1000;
+    return true;
+}
 
-        std::string cleanData(const std::string &str){
-            std::string delimiter = ":";
-            std::string data = str.substr(str.find(delimiter) + 1, str.length() - str.find(delimiter));
-            trimLeft(data);
-            data.resize(data.size() - 3);
-            return data;
+bool parseArguments(int argc, char *argv[], Arguments &arguments) {
+    const option longOptions[] = {
+        {"seconds", required_argument, nullptr, 's'},
+        {"count", required_argument, nullptr, 'c'},
+        {"bytes", no_argument, nullptr, 'b'},
+        {"kibi", no_argument, nullptr, 'k'},
+        {"mebi", no_argument, nullptr, 'm'},
+        {"gibi", no_argument, nullptr, 'g'},
+        {"human", no_argument, nullptr, 'h'},
+        {"si", no_argument, nullptr, 'I'},
+        {"json", no_argument, nullptr, 'J'},
+        {"csv", no_argument, nullptr, 'C'},
+        {"prom", no_argument, nullptr, 'P'},
+        {"procs", no_argument, nullptr, 'p'},
+        {"top", required_argument, nullptr, 'n'},
+        {"cgroups", no_argument, nullptr, 'Q'},
+        {"numa", no_argument, nullptr, 'N'},
+        {"kernel", no_argument, nullptr, 'E'},
+        {"cache", no_argument, nullptr, 'D'},
+        {"frag", no_argument, nullptr, 'F'},
+        {"psi", optional_argument, nullptr, 'R'},
+        {"alert", optional_argument, nullptr, 'A'},
+        {"check", no_argument, nullptr, 'K'},
+        {"warning", required_argument, nullptr, 'w'},
+        {"critical", required_argument, nullptr, 'x'},
+        {"hysteresis", required_argument, nullptr, 'y'},
+        {"for", required_argument, nullptr, 'f'},
+        {"exhausted-at", required_argument, nullptr, 'T'},
+        {"record", required_argument, nullptr, 'W'},
+        {"record-size", required_argument, nullptr, 'Z'},
+        {"replay", required_argument, nullptr, 'Y'},
+        {"range", required_argument, nullptr, 'G'},
+        {"publish", optional_argument, nullptr, 'U'},
+        {"serve", required_argument, nullptr, 'S'},
+        {"proc-root", required_argument, nullptr, 'O'},
+        {"batch", no_argument, nullptr, 'B'},
+        {"coalesce", required_argument, nullptr, 'L'},
+        {"host", no_argument, nullptr, 'X'},
+        {"help", no_argument, nullptr, 'H'},
+        {nullptr, 0, nullptr, 0}
+    };
+    int opt;
+    char *end;
+    while ((opt = getopt_long(argc, argv, "s:c:n:bkmgh", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 's':
+            arguments.interval = std::strtod(optarg, &end);
+            if (*end != '\0' || arguments.interval <= 0) {
+                std::cerr << "superfree: seconds argument '" << optarg << "' is not positive number\n";
+                return false;
+            }
+            break;
+        case 'c':
+            arguments.count = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || arguments.count < 1) {
+                std::cerr << "superfree: failed to parse count argument: '" << optarg << "'\n";
+                return false;
+            }
+            break;
+        case 'J':
+            arguments.format = OutputFormat::Json;
+            break;
+        case 'C':
+            arguments.format = OutputFormat::Csv;
+            break;
+        case 'P':
+            arguments.format = OutputFormat::Prometheus;
+            break;
+        case 'p':
+            arguments.view = View::Processes;
+            break;
+        case 'Q':
+            arguments.view = View::Cgroups;
+            break;
+        case 'N':
+            arguments.view = View::Numa;
+            break;
+        case 'E':
+            arguments.view = View::Kernel;
+            break;
+        case 'D':
+            arguments.view = View::Cache;
+            break;
+        case 'F':
+            arguments.view = View::Fragmentation;
+            break;
+        case 'X':
+            arguments.host = true;
+            break;
+        case 'b':
+            arguments.units.scale = UnitScale::Bytes;
+            break;
+        case 'k':
+            arguments.units.scale = UnitScale::Kilo;
+            break;
+        case 'm':
+            arguments.units.scale = UnitScale::Mega;
+            break;
+        case 'g':
+            arguments.units.scale = UnitScale::Giga;
+            break;
+        case 'h':
+            arguments.units.scale = UnitScale::Human;
+            break;
+        case 'I':
+            arguments.units.si = true;
+            break;
+        case 'R':
+            arguments.pressureTrigger = optarg != nullptr ? optarg : PRESSURE_DEFAULT_TRIGGER;
+            break;
+        case 'A':
+            arguments.alert = true;
+            if (optarg == nullptr || std::strcmp(optarg, "json") == 0) {
+                arguments.alertFormat = AlertFormat::Json;
+            } else if (std::strcmp(optarg, "syslog") == 0) {
+                arguments.alertFormat = AlertFormat::Syslog;
+            } else {
+                std::cerr << "superfree: alert format '" << optarg << "' is not json or syslog\n";
+                return false;
+            }
+            break;
+        case 'K':
+            arguments.check = true;
+            break;
+        case 'W':
+            arguments.recordPath = optarg;
+            break;
+        case 'Z': {
+            long size = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || size < 1) {
+                std::cerr << "superfree: failed to parse record size argument: '" << optarg << "'\n";
+                return false;
+            }
+            arguments.recordSize = static_cast<size_t>(size) * 1024 * 1024;
+            break;
         }
-
-        void filterLine(const std::string &line){
-            std::string delimiter = ":";
-            std::string token = line.substr(0,line.find(delimiter));
-            switch(resolveOption(token)){
-        case MemTotal:
-            memTotal = cleanData(line);
+        case 'Y':
+            arguments.replayPath = optarg;
+            break;
+        case 'S':
+            arguments.serveAddress = optarg;
             break;
-        case MemFree:
-            memFree = cleanData(line);
+        case 'O':
+            arguments.procRoot = optarg;
+            while (arguments.procRoot.size() > 1 && arguments.procRoot.back() == '/')
+                arguments.procRoot.pop_back();
             break;
-        case MemAvailable:
-            memAvailable = cleanData(line);
+        case 'B':
+            arguments.batch = true;
             break;
-        case Buffers:
-            memBuffers = cleanData(line);
+        case 'L': {
+            long coalesce = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || coalesce < 0 || coalesce > 3600000) {
+                std::cerr << "superfree: coalesce argument '" << optarg << "' is not a number of milliseconds\n";
+                return false;
+            }
+            arguments.coalesceMs = static_cast<unsigned int>(coalesce);
             break;
-        case Cached:
-            memCached = cleanData(line);
+        }
+        case 'U':
+            arguments.publishName = optarg != nullptr ? optarg : SHARED_SNAPSHOT_NAME;
+            if (arguments.publishName[0] != '/')
+                arguments.publishName = "/" + arguments.publishName;
             break;
-        case SwapTotal:
-            swapTotal = cleanData(line);
+        case 'G': {
+            std::string range = optarg;
+            size_t comma = range.find(',');
+            if (!parseTime(range.substr(0, comma), arguments.rangeFromMs)
+                    || (comma != std::string::npos && !parseTime(range.substr(comma + 1), arguments.rangeToMs))) {
+                std::cerr << "superfree: failed to parse range argument: '" << optarg << "'\n";
+                return false;
+            }
             break;
-        case SwapFree:
-            swapFree = cleanData(line);
+        }
+        case 'w':
+        case 'x':
+        case 'y':
+        case 'T':
+        case 'f': {
+            double value = std::strtod(optarg, &end);
+            if (*end != '\0' || value < 0 || (opt != 'f' && value > 100) || (opt == 'T' && value >= 100)) {
+                std::cerr << "superfree: failed to parse argument: '" << optarg << "'\n";
+                return false;
+            }
+            if (opt == 'w')
+                arguments.rule.warning = value;
+            else if (opt == 'x')
+                arguments.rule.critical = value;
+            else if (opt == 'y')
+                arguments.rule.hysteresis = value;
+            else if (opt == 'T')
+                arguments.forecastPercent = value;
+            else
+                arguments.rule.minDuration = value;
             break;
-        default:
+        }
+        case 'n': {
+            long top = std::strtol(optarg, &end, 10);
+            if (*end != '\0' || top < 1) {
+                std::cerr << "superfree: failed to parse top argument: '" << optarg << "'\n";
+                return false;
+            }
+            arguments.top = static_cast<size_t>(top);
             break;
         }
+        case 'H':
+            printUsage(argv[0]);
+            std::exit(0);
+        default:
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    for (int i = optind; i < argc; i++)
+        arguments.paths.push_back(argv[i]);
+    const bool takesPaths = arguments.batch || arguments.view == View::Cache;
+    if (takesPaths != !arguments.paths.empty()) {
+        std::cerr << (takesPaths ? std::string("superfree: ") + (arguments.batch ? "--batch" : "--cache")
+                                   + " needs files or directories\n"
+                                 : "superfree: unexpected argument '" + arguments.paths[0] + "'\n");
+        return false;
+    }
+    if (arguments.rule.warning > arguments.rule.critical) {
+        std::cerr << "superfree: the warning threshold is above the critical one\n";
+        return false;
+    }
+    // The NUMA nodes are read from the live /sys, a captured /proc does not have them
+    if (arguments.view == View::Numa && arguments.procRoot != "/proc") {
+        std::cerr << "superfree: --numa reads the live /sys and cannot be used with --proc-root\n";
+        return false;
+    }
+    if ((arguments.alert || arguments.check) && arguments.view != View::Memory) {
+        std::cerr << "superfree: --alert and --check only apply to memory and swap\n";
+        return false;
+    }
+    if (arguments.alert && arguments.interval == 0 && arguments.pressureTrigger.empty())
+        arguments.interval = ALERT_INTERVAL;
+    if ((!arguments.recordPath.empty() || !arguments.publishName.empty()) && arguments.interval == 0)
+        arguments.interval = 1;
+    if (arguments.rangeFromMs != INT64_MAX && arguments.replayPath.empty()) {
+        std::cerr << "superfree: --range needs --replay\n";
+        return false;
+    }
+    if (!arguments.pressureTrigger.empty()) {
+        if (arguments.view != View::Memory) {
+            std::cerr << "superfree: --psi only applies to the memory tables and --json/--csv/--prom\n";
+            return false;
+        }
+        if (arguments.interval == 0)
+            arguments.interval = PRESSURE_HEARTBEAT;
+    }
+    if (arguments.count > 0 && arguments.interval == 0)
+        arguments.interval = 1;
+    return true;
+}
+
+timespec toTimespec(double seconds) {
+    timespec result;
+    result.tv_sec = static_cast<time_t>(seconds);
+    result.tv_nsec = static_cast<long>((seconds - result.tv_sec) * 1e9);
+    return result;
+}
+
+/// Prints one refresh of the tables. On a terminal the tables already on
+/// screen are updated in place, otherwise they are printed again.
+void printTables(MemInfo &info, MemoryTables &tables, bool first, bool repeat) {
+    tables.update(info);
+    if (repeat && isatty(STDOUT_FILENO)) {
+        if (first)
+            std::cout << "\e[?25l\e[H\e[2J";
+        tables.redraw(std::cout);
+    } else {
+        tables.print(std::cout);
+        if (repeat)
+            std::cout << "\n";
+    }
+    std::cout.flush();
+}
+
+/// Adds the current memory and swap to the forecast
+void addForecastSample(const MemInfo &info, ExhaustionForecast &forecast) {
+    forecast.add(info.memAvailable, info.memTotal, info.swapFree, info.swapTotal);
+}
+
+/// Refreshes the output every interval until count is reached or a signal arrives.
+/// The timer uses absolute deadlines on CLOCK_MONOTONIC so the interval does not drift.
+/// With a PSI trigger the output is refreshed when the trigger fires instead, and every
+/// interval as a heartbeat when there is no pressure.
+int watch(MemInfo &info, const Arguments &arguments, const std::function<void(bool)> &printFrame,
+          PressureTrigger *trigger = nullptr) {
+    installStopHandler();
+
+    if (trigger != nullptr) {
+        const int heartbeat = static_cast<int>(arguments.interval * 1000);
+        for (long i = 0; !stopRequested && (arguments.count < 0 || i < arguments.count); i++) {
+            if (i > 0) {
+                // A signal that does not stop superfree (SIGWINCH, SIGCHLD...) resumes the
+                // same wait, so -c still prints every frame
+                timespec deadline;
+                clock_gettime(CLOCK_MONOTONIC, &deadline);
+                const int64_t deadlineMs = deadline.tv_sec * 1000LL + deadline.tv_nsec / 1000000 + heartbeat;
+                PressureEvent event = trigger->wait(heartbeat);
+                while (event == PressureEvent::Interrupted && !stopRequested) {
+                    timespec now;
+                    clock_gettime(CLOCK_MONOTONIC, &now);
+                    const int64_t left = deadlineMs - (now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+                    event = trigger->wait(static_cast<int>(left > 0 ? left : 0));
+                }
+                if (stopRequested)
+                    break;
+                if (event == PressureEvent::Error) {
+                    std::cerr << "superfree: the PSI trigger stopped working\n";
+                    break;
+                }
+                info.refresh();
+            }
+            printFrame(i == 0);
+        }
+        if (arguments.format == OutputFormat::Table && isatty(STDOUT_FILENO))
+            std::cout << "\e[?25h" << std::flush;
+        return 0;
+    }
+
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer < 0) {
+        std::cerr << "superfree: timerfd_create failed\n";
+        return 1;
+    }
+    itimerspec spec{};
+    spec.it_interval = toTimespec(arguments.interval);
+    clock_gettime(CLOCK_MONOTONIC, &spec.it_value);
+    spec.it_value.tv_sec += spec.it_interval.tv_sec;
+    spec.it_value.tv_nsec += spec.it_interval.tv_nsec;
+    if (spec.it_value.tv_nsec >= 1000000000L) {
+        spec.it_value.tv_sec++;
+        spec.it_value.tv_nsec -= 1000000000L;
+    }
+    timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, nullptr);
+
+    for (long i = 0; !stopRequested && (arguments.count < 0 || i < arguments.count); i++) {
+        if (i > 0) {
+            uint64_t expirations;
+            ssize_t n;
+            while ((n = read(timer, &expirations, sizeof(expirations))) < 0 && errno == EINTR && !stopRequested) {
+            }
+            if (stopRequested)
+                break;
+            if (n < 0) {
+                std::cerr << "superfree: reading the timer failed: " << std::strerror(errno) << "\n";
+                break;
+            }
+            info.refresh();
+        }
+        printFrame(i == 0);
     }
+    if (arguments.format == OutputFormat::Table && isatty(STDOUT_FILENO))
+        std::cout << "\e[?25h" << std::flush;
+    close(timer);
+    return 0;
+}
 
-public:
-    std::string memTotal;
-    std::string memFree;
-    std::string memUsed;
-    std::string memAvailable;
-    std::string memBuffers;
-    std::string memCached;
-    std::string buffCached;
-    std::string swapTotal;
-    std::string swapUsed;
-    std::string swapFree;
-    std::string Total;
-    std::string TotalUsed;
-    std::string TotalFree;
-    std::string dataType;
-
-    enum barOptions {
-        bOption_Invalid,
-        Memory,
-        Swap,
-        Totals,
+/// Prints a detailed view once, or every interval like the tables. When repeating on a
+/// terminal the screen is cleared before every refresh.
+int showView(MemInfo &info, const Arguments &arguments, const std::function<void(std::string &, bool)> &render) {
+    const bool repeat = arguments.interval > 0;
+    auto print = [&](bool) {
+        std::string out;
+        if (repeat && isatty(STDOUT_FILENO))
+            out = "\e[H\e[2J";
+        render(out, repeat);
+        if (repeat && !isatty(STDOUT_FILENO))
+            out += "\n";
+        std::cout << out << std::flush;
     };
+    if (repeat)
+        return watch(info, arguments, print);
+    print(true);
+    return 0;
+}
 
-    MemInfo() {
-        readFile();
-        dataType = "kB";
-        long l_memUsed = std::stol(memTotal) - std::stol(memAvailable);
-        memUsed = std::to_string(l_memUsed);
-        long l_buffCached = std::stol(memBuffers) + std::stol(memCached);
-        buffCached = std::to_string(l_buffCached);
-        long l_swapUsed = std::stol(swapTotal) - std::stol(swapFree);
-        swapUsed = std::to_string(l_swapUsed);
-        long l_Total = std::stol(memTotal) + std::stol(swapTotal);
-        Total = std::to_string(l_Total);
-        long l_TotalUsed = std::stol(memUsed) + std::stol(swapUsed);
-        TotalUsed = std::to_string(l_TotalUsed);
-        long l_TotalFree = std::stol(memFree) + std::stol(swapFree);
-        TotalFree = std::to_string(l_TotalFree);
-    }
-
-    void readFile(){
-        std::ifstream infile(pathMeminfo);
-        for( std::string line; getline(infile, line);)
-            filterLine(line);
-    }
-
-    std::string printBar(){
-        return " ";
-    }
-
-    void printData(){
-        std::cout << "MemTotal: " << memTotal << std::endl;
-        std::cout << "MemUsed: " << memUsed << std::endl;
-        std::cout << "MemFree: " << memFree << std::endl;
-        std::cout << "MemAvailable: " << memAvailable << std::endl;
-        std::cout << "Buffers: " << memBuffers << std::endl;
-        std::cout << "Cached: " << memCached << std::endl;
-        std::cout << "BuffCached: " << buffCached << std::endl;
-        std::cout << "SwapTotal: " << swapTotal << std::endl;
-        std::cout << "SwapUsed: " << swapUsed << std::endl;
-        std::cout << "SwapFree: " << swapFree << std::endl;
-    }
-
-    std::string printBar(int type){
-        std::string result = "";
-        switch(type){
-        case Memory:
-            return genericPrintBar(memUsed, memTotal);
-            break;
-        case Swap:
-            return genericPrintBar(swapUsed, swapTotal);
-            break;
-        case Totals:
-            return genericPrintBar(TotalUsed, Total);
-        default:
-            return result;
+/// Checks memory and swap once, as a Nagios plugin
+int check(const Arguments &arguments) {
+    OutputBuffer out(STDOUT_FILENO);
+    try {
+        MemInfo info(!arguments.host && arguments.procRoot == "/proc", arguments.procRoot);
+        AlertLevel level = writeCheck(out, arguments.rule, info.memoryPercent(), info.swapPercent());
+        out.flush();
+        return static_cast<int>(level);
+    } catch (const std::exception &error) {
+        out.append("SUPERFREE UNKNOWN - ");
+        out.append(error.what());
+        out.append('\n');
+        out.flush();
+        return 3;
+    }
+}
+
+/// Prints an event each time memory or swap use changes level
+void printAlerts(const MemInfo &info, const Arguments &arguments, AlertState &memory, AlertState &swap,
+                 OutputBuffer &out) {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const double seconds = now.tv_sec + now.tv_nsec / 1e9;
+    const double memoryPercent = info.memoryPercent();
+    const double swapPercent = info.swapPercent();
+    if (memory.update(memoryPercent, seconds))
+        writeAlertEvent(out, arguments.alertFormat, "memory", memory, arguments.rule, memoryPercent);
+    if (swap.update(swapPercent, seconds))
+        writeAlertEvent(out, arguments.alertFormat, "swap", swap, arguments.rule, swapPercent);
+    out.flush();
+}
+
+/// Appends one sample to the recording every refresh
+void recordSample(const MemInfo &info, VmStatReader &vmstat, Recorder &recorder) {
+    VmStatData counters{};
+    vmstat.read(counters);
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    recorder.append(static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000, info.data, counters);
+}
+
+/// Formats a time of a recording as local time
+std::string formatTime(int64_t timeMs) {
+    time_t seconds = static_cast<time_t>(timeMs / 1000);
+    tm local;
+    localtime_r(&seconds, &local);
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+    return text;
+}
+
+/// Prints recorded samples through the tables or the machine-readable formats
+int replay(MemInfo &info, const Arguments &arguments) {
+    Replay recording(arguments.replayPath);
+    std::vector<RecordedSample> samples;
+    if (arguments.rangeToMs == INT64_MIN) {
+        RecordedSample sample;
+        if (recording.at(arguments.rangeFromMs, sample))
+            samples.push_back(sample);
+    } else {
+        recording.forEach(arguments.rangeFromMs, arguments.rangeToMs, [&](const RecordedSample &sample) {
+            samples.push_back(sample);
+            return true;
+        });
+    }
+    if (samples.empty()) {
+        std::cerr << "superfree: no sample in " << arguments.replayPath << " for this range\n";
+        return 1;
+    }
+
+    OutputBuffer out(STDOUT_FILENO);
+    // A range is forecast as if it was watched, from the times of the samples
+    ExhaustionForecast forecast(arguments.forecastPercent);
+    const ExhaustionForecast *trends = samples.size() > 1 ? &forecast : nullptr;
+    MemoryTables tables(trends);
+    tables.activity = samples.size() > 1;
+    for (size_t i = 0; i < samples.size(); i++) {
+        const RecordedSample &sample = samples[i];
+        info.load(sample.meminfo);
+        forecast.addAt(static_cast<double>(sample.timeMs) / 1000, info.memAvailable, info.memTotal, info.swapFree,
+                       info.swapTotal);
+        const uint64_t timestamp = static_cast<uint64_t>(sample.timeMs / 1000);
+        if (arguments.format == OutputFormat::Table) {
+            tables.tableMemory.setTittle("Memory at " + formatTime(sample.timeMs));
+            if (tables.activity)
+                tables.setActivity(i > 0 ? &samples[i - 1].vmstat : nullptr, sample.vmstat);
+            tables.update(info);
+            tables.print(std::cout);
         }
-        return result;
+        writeSnapshot(out, arguments.format, info.data, i == 0, timestamp, arguments.units, trends);
+        out.flush();
     }
+    std::cout.flush();
+    return 0;
+}
 
-};
+/// Summarizes captured meminfo files, one line per host
+int batch(const Arguments &arguments) {
+    size_t files = 0;
+    const std::vector<HostSummary> hosts = analyzeCaptures(arguments.paths, defaultThreadCount(), files);
+    if (hosts.empty()) {
+        std::cerr << "superfree: no meminfo snapshot found in " << files << " file(s)\n";
+        return 1;
+    }
+    OutputBuffer out(STDOUT_FILENO);
+    if (arguments.format != OutputFormat::Json)
+        writeHostCsvHeader(out);
+    for (const auto &host : hosts) {
+        if (arguments.format == OutputFormat::Json)
+            writeHostJson(out, host, arguments.units);
+        else
+            writeHostCsv(out, host, arguments.units);
+    }
+    out.flush();
+    return 0;
+}
 
+/// Serves the metrics over HTTP until SIGINT or SIGTERM
+int serve(const Arguments &arguments) {
+    try {
+        MetricsServer server(arguments.serveAddress, arguments.coalesceMs,
+                             !arguments.host && arguments.procRoot == "/proc", arguments.procRoot);
+        installStopHandler();
+        std::cerr << "superfree: serving OpenMetrics on port " << server.port() << "\n";
+        server.run(stopRequested);
+        return 0;
+    } catch (const std::runtime_error &error) {
+        std::cerr << "superfree: " << error.what() << "\n";
+        return 1;
+    }
+}
 
+int main(int argc, char *argv[]) {
 
-int main() {
+    Arguments arguments;
+    if (!parseArguments(argc, argv, arguments))
+        return 1;
 
-    MemInfo info = MemInfo();
+    if (arguments.check)
+        return check(arguments);
 
-    ConsoleTable tableMemory{"TOTAL", "USED", "FREE", "BUF/CACHE", "AVAILABLE", "USE%"};
+    if (arguments.batch)
+        return batch(arguments);
 
-    tableMemory.setPadding(1);
-    tableMemory.setStyle(4);
+    if (!arguments.serveAddress.empty())
+        return serve(arguments);
 
-    tableMemory += {"\e[38;5;75m" +info.memTotal + " " + info.dataType  + "\e[0m",
-            info.memUsed + " " + info.dataType,
-            info.memFree + " " + info.dataType,
-            info.buffCached + " " + info.dataType,
-            info.memAvailable + " " + info.dataType,
-            info.printBar(1)};
+    // The cgroup tree compares every cgroup with the host, and kernel memory, the page cache
+    // and the zones belong to the host, so they keep the host values. The cgroup of superfree says
+    // nothing about a captured tree either.
+    const bool hostView = arguments.view == View::Cgroups || arguments.view == View::Kernel
+                          || arguments.view == View::Cache || arguments.view == View::Fragmentation;
+    std::unique_ptr<MemInfo> meminfo;
+    try {
+        meminfo.reset(new MemInfo(!arguments.host && !hostView && arguments.procRoot == "/proc", arguments.procRoot));
+    } catch (const std::runtime_error &error) {
+        std::cerr << "superfree: " << error.what() << "\n";
+        return 1;
+    }
+    MemInfo &info = *meminfo;
+    info.setThresholds(arguments.rule);
+    info.setUnits(arguments.units);
+
+    if (arguments.view == View::Processes) {
+        return showView(info, arguments, [&](std::string &out, bool) {
+            renderProcesses(out, arguments.procRoot.c_str(), arguments.top, arguments.units);
+        });
+    }
 
-    tableMemory.setTittle("Memory");
-    std::cout << tableMemory;
+    if (arguments.view == View::Cgroups) {
+        std::string root = findCgroup2Root();
+        if (root.empty()) {
+            std::cerr << "superfree: cgroup v2 is not mounted\n";
+            return 1;
+        }
+        CgroupScanner scanner(root);
+        return showView(info, arguments, [&](std::string &out, bool) { renderCgroups(out, info, scanner); });
+    }
 
-    ConsoleTable tableSwap{"TOTAL", "USED", "FREE", "USE%"};
+    if (arguments.view == View::Kernel) {
+        SlabInfoReader slabinfo(arguments.procRoot + "/slabinfo");
+        return showView(info, arguments, [&](std::string &out, bool) {
+            renderKernel(out, info, slabinfo, arguments.top);
+        });
+    }
 
-    tableSwap.setPadding(1);
-    tableSwap.setStyle(4);
+    if (arguments.view == View::Fragmentation) {
+        FragmentationReader reader(arguments.procRoot);
+        if (!reader.isOpen()) {
+            std::cerr << "superfree: unable to open " << arguments.procRoot << "/buddyinfo\n";
+            return 1;
+        }
+        CompactionSamples samples;
+        return showView(info, arguments, [&](std::string &out, bool repeat) {
+            renderFragmentation(out, info, reader, samples, repeat);
+        });
+    }
 
-    tableSwap += {"\e[38;5;75m" + info.swapTotal + " " + info.dataType  + "\e[0m",
-            info.swapUsed + " " + info.dataType,
-            info.swapFree + " " + info.dataType,
-            info.printBar(2)};
+    if (arguments.view == View::Cache) {
+        PageCacheScanner scanner(arguments.paths);
+        return showView(info, arguments, [&](std::string &out, bool) {
+            renderCache(out, info, scanner, arguments.top);
+        });
+    }
 
+    if (arguments.view == View::Numa) {
+        NumaNodes reader;
+        if (reader.size() == 0) {
+            std::cerr << "superfree: no NUMA node found in /sys/devices/system/node\n";
+            return 1;
+        }
+        NumaSamples samples;
+        return showView(info, arguments, [&](std::string &out, bool repeat) {
+            renderNuma(out, info, reader, samples, repeat);
+        });
+    }
 
-    tableSwap.setTittle("Swap");
-    std::cout << tableSwap;
+    PressureTrigger trigger;
+    const std::string pressurePath = arguments.procRoot + "/pressure/memory";
+    if (!arguments.pressureTrigger.empty() && !trigger.open(arguments.pressureTrigger, pressurePath.c_str())
+            && !(errno == EINVAL && arguments.pressureTrigger == PRESSURE_DEFAULT_TRIGGER
+                 && trigger.open(PRESSURE_UNPRIVILEGED_TRIGGER, pressurePath.c_str()))) {
+        std::cerr << "superfree: unable to register the PSI trigger \"" << arguments.pressureTrigger
+                  << "\" on " << pressurePath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    PressureTrigger *pressure = arguments.pressureTrigger.empty() ? nullptr : &trigger;
+
+    if (!arguments.replayPath.empty() || !arguments.recordPath.empty() || !arguments.publishName.empty()) {
+        try {
+            if (!arguments.replayPath.empty())
+                return replay(info, arguments);
+            if (!arguments.publishName.empty()) {
+                SnapshotPublisher publisher(arguments.publishName);
+                return watch(info, arguments, [&](bool) { publisher.publish(info.data); }, pressure);
+            }
+            Recorder recorder(arguments.recordPath, arguments.recordSize);
+            VmStatReader vmstat;
+            vmstat.open((arguments.procRoot + "/vmstat").c_str());
+            return watch(info, arguments, [&](bool) { recordSample(info, vmstat, recorder); }, pressure);
+        } catch (const std::runtime_error &error) {
+            std::cerr << "superfree: " << error.what() << "\n";
+            return 1;
+        }
+    }
 
-    ConsoleTable tableTotals{"TOTAL", "USED", "FREE", "USE%"};
+    if (arguments.alert) {
+        OutputBuffer out(STDOUT_FILENO);
+        AlertState memory(arguments.rule);
+        AlertState swap(arguments.rule);
+        return watch(info, arguments, [&](bool) { printAlerts(info, arguments, memory, swap, out); }, pressure);
+    }
 
-    tableTotals.setPadding(1);
-    tableTotals.setStyle(4);
+    if (arguments.format != OutputFormat::Table) {
+        OutputBuffer out(STDOUT_FILENO);
+        ExhaustionForecast forecast(arguments.forecastPercent);
+        if (arguments.interval > 0)
+            return watch(info, arguments, [&](bool first) {
+                addForecastSample(info, forecast);
+                writeSnapshot(out, arguments.format, info.data, first, 0, info.getUnits(), &forecast);
+                out.flush();
+            }, pressure);
+        writeSnapshot(out, arguments.format, info.data, true, 0, info.getUnits());
+        out.flush();
+        return 0;
+    }
 
-    tableTotals += {"\e[38;5;75m" + info.Total + " " + info.dataType + "\e[0m",
-            info.TotalUsed + " " + info.dataType,
-            info.TotalFree + " " + info.dataType,
-            info.printBar(3)};
+    ExhaustionForecast forecast(arguments.forecastPercent);
+    const bool repeat = arguments.interval > 0;
+    MemoryTables tables(repeat ? &forecast : nullptr);
+    if (!info.cgroupPath().empty())
+        tables.tableMemory.setTittle("Memory (cgroup " + info.cgroupPath() + ")");
+    if (repeat) {
+        tables.enableActivity(arguments.procRoot);
+        tables.pressure = pressure;
+        return watch(info, arguments, [&](bool first) {
+            addForecastSample(info, forecast);
+            printTables(info, tables, first, repeat);
+        }, pressure);
+    }
 
-    tableTotals.setTittle("Totals");
-    std::cout << tableTotals;
+    printTables(info, tables, true, repeat);
 
     return 0;
 }
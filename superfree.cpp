@@ -0,0 +1,79 @@
+#include "superfree.h"
+
+#include <cerrno>
+#include <ctime>
+#include <exception>
+#include <new>
+#include "Sampler.h"
+
+struct sf_sampler {
+    Sampler sampler;
+
+    sf_sampler(unsigned int intervalMs, bool cgroupAware) : sampler{intervalMs, cgroupAware} {
+    }
+};
+
+namespace {
+
+void fillSnapshot(const Snapshot &sample, sf_snapshot &snapshot) {
+    const MemInfoData &data = sample.meminfo;
+    snapshot.time_ms = sample.timeMs;
+    snapshot.sequence = sample.sequence;
+    snapshot.mem_total = data.memTotal;
+    snapshot.mem_used = sample.memUsed();
+    snapshot.mem_free = data.memFree;
+    snapshot.mem_shared = data.shmem;
+    snapshot.mem_buff_cache = memInfoBuffCache(data);
+    snapshot.mem_available = sample.memAvailable();
+    snapshot.swap_total = data.swapTotal;
+    snapshot.swap_used = sample.swapUsed();
+    snapshot.swap_free = data.swapFree;
+    snapshot.mem_used_permille = sample.memUsedPermille();
+    snapshot.swap_used_permille = sample.swapUsedPermille();
+}
+
+}
+
+sf_sampler *sf_sampler_start(unsigned int interval_ms, int flags) {
+    errno = 0;
+    try {
+        return new sf_sampler{interval_ms, (flags & SF_HOST) == 0};
+    } catch (const std::bad_alloc &) {
+        errno = ENOMEM;
+    } catch (const std::exception &) {
+        if (errno == 0)
+            errno = EIO;
+    }
+    return nullptr;
+}
+
+void sf_sampler_stop(sf_sampler *sampler) {
+    delete sampler;
+}
+
+int sf_snapshot_read(const sf_sampler *sampler, sf_snapshot *snapshot) {
+    if (sampler != nullptr) {
+        Snapshot sample;
+        sampler->sampler.read(sample);
+        fillSnapshot(sample, *snapshot);
+        return 0;
+    }
+    Snapshot sample;
+    errno = 0;
+    try {
+        MemInfoReader reader{true};
+        if (!reader.read(sample.meminfo)) {
+            errno = EIO;
+            return -1;
+        }
+    } catch (const std::exception &) {
+        if (errno == 0)
+            errno = EIO;
+        return -1;
+    }
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    sample.timeMs = static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+    fillSnapshot(sample, *snapshot);
+    return 0;
+}
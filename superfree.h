@@ -0,0 +1,65 @@
+#ifndef SUPERFREE_H
+#define SUPERFREE_H
+
+/* C API of libsuperfree_core: in-process memory telemetry sampled by a background thread.
+ * Reading a snapshot never blocks, allocates or makes a syscall. The C++ API is Sampler.h. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Figures of the Memory and Swap tables of superfree, sizes in kB */
+typedef struct sf_snapshot {
+    /** Wall clock time of the sample in milliseconds since the epoch */
+    uint64_t time_ms;
+    /** Number of the sample, starting at 1, 0 for sf_snapshot_read() without a sampler */
+    uint64_t sequence;
+    uint64_t mem_total;
+    uint64_t mem_used;
+    uint64_t mem_free;
+    uint64_t mem_shared;
+    uint64_t mem_buff_cache;
+    uint64_t mem_available;
+    uint64_t swap_total;
+    uint64_t swap_used;
+    uint64_t swap_free;
+    /** Used memory and swap in tenths of a percent, rounded */
+    uint32_t mem_used_permille;
+    uint32_t swap_used_permille;
+} sf_snapshot;
+
+/** A background sampler, see sf_sampler_start() */
+typedef struct sf_sampler sf_sampler;
+
+/** sf_sampler_start() flag: report the host even inside a memory-limited cgroup v2 */
+#define SF_HOST 1
+
+/**
+ * Takes a first sample and starts a thread sampling /proc/meminfo every interval.
+ * \param interval_ms Milliseconds between samples
+ * \param flags 0 or SF_HOST
+ * \return The sampler, or NULL with errno set if /proc/meminfo cannot be read
+ */
+sf_sampler *sf_sampler_start(unsigned int interval_ms, int flags);
+
+/**
+ * Stops the thread and frees the sampler, no sf_snapshot_read() may be running on it.
+ * \param sampler A sampler from sf_sampler_start(), or NULL
+ */
+void sf_sampler_stop(sf_sampler *sampler);
+
+/**
+ * Copies the latest sample, safe to call from any number of threads.
+ * \param sampler A running sampler, or NULL to read /proc/meminfo now in the calling thread
+ * \param snapshot Receives the values
+ * \return 0 on success, -1 with errno set if /proc/meminfo could not be read
+ */
+int sf_snapshot_read(const sf_sampler *sampler, sf_snapshot *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUPERFREE_H */